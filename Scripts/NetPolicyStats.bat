@@ -0,0 +1,30 @@
+@echo off
+rem Runs a headless server with NumClients headless clients and logs the actors considered for
+rem replication per connection per frame, see ARPG.NetPolicyStats. Stops every UnrealEditor-Cmd
+rem process when done, so close other editor command line sessions first.
+rem
+rem Usage: NetPolicyStats.bat <path to UnrealEditor-Cmd.exe> [NumClients=4] [Seconds=30]
+
+setlocal
+set EDITOR=%~1
+set NUMCLIENTS=%~2
+set SECONDS=%~3
+if "%EDITOR%"=="" (
+	echo Usage: NetPolicyStats.bat ^<path to UnrealEditor-Cmd.exe^> [NumClients=4] [Seconds=30]
+	exit /b 1
+)
+if "%NUMCLIENTS%"=="" set NUMCLIENTS=4
+if "%SECONDS%"=="" set SECONDS=30
+
+set PROJECT=%~dp0..\UE5TopDownARPG.uproject
+set SERVERLOG=%~dp0..\Saved\Logs\NetPolicyStatsServer.log
+
+rem The clients connect once the server had time to load the map.
+start "" /b cmd /c "timeout /t 20 /nobreak > nul & for /l %%I in (1,1,%NUMCLIENTS%) do start "" /b "%EDITOR%" "%PROJECT%" 127.0.0.1 -game -nullrhi -nosound -unattended -log=NetPolicyStatsClient%%I.log"
+
+rem Samples once every client joined, logs and quits.
+"%EDITOR%" "%PROJECT%" -server -nullrhi -unattended -log=NetPolicyStatsServer.log -ExecCmds="ARPG.NetPolicyStats %SECONDS% %NUMCLIENTS%" -ARPGNetPolicyStatsExit
+
+taskkill /im UnrealEditor-Cmd.exe /f > nul 2>&1
+findstr /c:"Net policy stats" /c:"actors considered" "%SERVERLOG%"
+endlocal
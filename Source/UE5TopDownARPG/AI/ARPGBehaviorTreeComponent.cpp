@@ -0,0 +1,23 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ARPGBehaviorTreeComponent.h"
+
+uint64 UARPGBehaviorTreeComponent::TotalTickCycles = 0;
+
+void UARPGBehaviorTreeComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+	TotalTickCycles += FPlatformTime::Cycles64() - StartCycles;
+}
+
+SIZE_T UARPGBehaviorTreeComponent::GetInstanceMemorySize() const
+{
+	SIZE_T Size = InstanceStack.GetAllocatedSize();
+	for (const FBehaviorTreeInstance& Instance : InstanceStack)
+	{
+		Size += Instance.GetInstanceMemory().GetAllocatedSize();
+	}
+	return Size;
+}
@@ -0,0 +1,29 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BehaviorTree/BehaviorTreeComponent.h"
+#include "ARPGBehaviorTreeComponent.generated.h"
+
+/**
+ * Behavior tree component of enemies whose class selects EEnemyBrain::BehaviorTree. It accounts its
+ * tick time and node memory so ARPG.Bench.AIBrain can compare it with UEnemyStateMachineComponent.
+ */
+UCLASS()
+class UE5TOPDOWNARPG_API UARPGBehaviorTreeComponent : public UBehaviorTreeComponent
+{
+	GENERATED_BODY()
+
+public:
+	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	/** Node instance memory of every tree on the instance stack. */
+	SIZE_T GetInstanceMemorySize() const;
+
+	/** Tick time accumulated by every instance, for benchmarks. */
+	static uint64 GetTotalTickCycles() { return TotalTickCycles; }
+
+private:
+	static uint64 TotalTickCycles;
+};
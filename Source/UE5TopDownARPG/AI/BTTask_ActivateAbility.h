@@ -1,19 +1,19 @@
-// Fill out your copyright notice in the Description page of Project Settings.
-
-#pragma once
-
-#include "CoreMinimal.h"
-#include "BehaviorTree/Tasks/BTTask_BlackboardBase.h"
-#include "BTTask_ActivateAbility.generated.h"
-
-/**
- * 
- */
-UCLASS()
-class UE5TOPDOWNARPG_API UBTTask_ActivateAbility : public UBTTask_BlackboardBase
-{
-	GENERATED_BODY()
-
-private:
-	virtual EBTNodeResult::Type ExecuteTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) override;
-};
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BehaviorTree/Tasks/BTTask_BlackboardBase.h"
+#include "BTTask_ActivateAbility.generated.h"
+
+/**
+ * 
+ */
+UCLASS()
+class UE5TOPDOWNARPG_API UBTTask_ActivateAbility : public UBTTask_BlackboardBase
+{
+	GENERATED_BODY()
+
+private:
+	virtual EBTNodeResult::Type ExecuteTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) override;
+};
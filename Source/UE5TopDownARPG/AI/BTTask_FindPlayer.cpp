@@ -1,63 +1,108 @@
-// Fill out your copyright notice in the Description page of Project Settings.
-
-
-#include "BTTask_FindPlayer.h"
-#include "../UE5TopDownARPGCharacter.h"
-#include "NavigationSystem.h"
-#include "AIController.h"
-#include "NavigationPath.h"
-#include "BehaviorTree/BlackboardComponent.h"
-#include "Kismet/GameplayStatics.h"
-
-EBTNodeResult::Type UBTTask_FindPlayer::ExecuteTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory)
-{
-  AAIController* AIController = Cast<AAIController>(OwnerComp.GetOwner());
-  if (IsValid(AIController) == false)
-  {
-    return EBTNodeResult::Failed;
-  }
-
-  APawn* PossesedPawn = AIController->GetPawn();
-  if (IsValid(PossesedPawn) == false)
-  {
-    return EBTNodeResult::Failed;
-  }
-
-  UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
-  if (IsValid(NavSys) == false)
-  {
-    return EBTNodeResult::Failed;
-  }
-
-  TArray<AActor*> FoundActors;
-  UGameplayStatics::GetAllActorsOfClass(GetWorld(), AUE5TopDownARPGCharacter::StaticClass(), FoundActors);
-
-  for (AActor* Actor : FoundActors)
-  {
-    AUE5TopDownARPGCharacter* UE5TopDownARPGCharacter = Cast<AUE5TopDownARPGCharacter>(Actor);
-    if (IsValid(UE5TopDownARPGCharacter) == false)
-    {
-      continue;
-    }
-
-    APlayerController* PlayerController = Cast<APlayerController>(UE5TopDownARPGCharacter->GetController());
-    if (IsValid(PlayerController) == false)
-    {
-      continue;
-    }
-
-    UNavigationPath* Path = NavSys->FindPathToLocationSynchronously(GetWorld(), PossesedPawn->GetActorLocation(), Actor->GetActorLocation());
-    if (Path->IsValid() && Path->IsPartial() == false)
-    {
-      UBlackboardComponent* BlackboardComponent = OwnerComp.GetBlackboardComponent();
-      if (IsValid(BlackboardComponent) == false)
-      {
-        return EBTNodeResult::Failed;
-      }
-
-      BlackboardComponent->SetValueAsObject(FName("Target"), Actor);
-      return EBTNodeResult::Succeeded;
-    }
-  }
-  return EBTNodeResult::Failed;
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BTTask_FindPlayer.h"
+#include "../UE5TopDownARPGCharacter.h"
+#include "../Arena/ArenaSubsystem.h"
+#include "NavigationSystem.h"
+#include "AIController.h"
+#include "NavigationPath.h"
+#include "BehaviorTree/BlackboardComponent.h"
+#include "Kismet/GameplayStatics.h"
+#include "../Scheduling/GameplayWorkScheduler.h"
+#include "../Telemetry/GameplayMetrics.h"
+
+EBTNodeResult::Type UBTTask_FindPlayer::ExecuteTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory)
+{
+  UGameplayWorkScheduler* Scheduler = UGameplayWorkScheduler::Get(&OwnerComp);
+  if (IsValid(Scheduler) == false)
+  {
+    return FindPlayer(OwnerComp);
+  }
+
+  // Path queries are the expensive part of target refresh, let them wait for a frame with room.
+  TWeakObjectPtr<UBehaviorTreeComponent> WeakOwnerComp = &OwnerComp;
+  Scheduler->Submit(EGameplayWorkPriority::Low, &OwnerComp, [this, WeakOwnerComp]()
+  {
+    UBehaviorTreeComponent* OwnerComp = WeakOwnerComp.Get();
+    if (OwnerComp != nullptr && OwnerComp->GetTaskStatus(this) == EBTTaskStatus::Active)
+    {
+      FinishLatentTask(*OwnerComp, FindPlayer(*OwnerComp));
+    }
+  });
+  return EBTNodeResult::InProgress;
+}
+
+EBTNodeResult::Type UBTTask_FindPlayer::FindPlayer(UBehaviorTreeComponent& OwnerComp) const
+{
+  AAIController* AIController = Cast<AAIController>(OwnerComp.GetOwner());
+  if (IsValid(AIController) == false)
+  {
+    return EBTNodeResult::Failed;
+  }
+
+  AActor* Target = FindReachablePlayer(AIController->GetPawn());
+  if (IsValid(Target) == false)
+  {
+    return EBTNodeResult::Failed;
+  }
+
+  UBlackboardComponent* BlackboardComponent = OwnerComp.GetBlackboardComponent();
+  if (IsValid(BlackboardComponent) == false)
+  {
+    return EBTNodeResult::Failed;
+  }
+
+  BlackboardComponent->SetValueAsObject(FName("Target"), Target);
+  return EBTNodeResult::Succeeded;
+}
+
+AActor* UBTTask_FindPlayer::FindReachablePlayer(APawn* PossesedPawn)
+{
+  if (IsValid(PossesedPawn) == false)
+  {
+    return nullptr;
+  }
+
+  UWorld* World = PossesedPawn->GetWorld();
+  UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(World);
+  if (IsValid(NavSys) == false)
+  {
+    return nullptr;
+  }
+
+  TArray<AActor*> FoundActors;
+  UGameplayStatics::GetAllActorsOfClass(World, AUE5TopDownARPGCharacter::StaticClass(), FoundActors);
+
+  // Players in other arenas are unreachable, skip their path queries.
+  const UArenaSubsystem* ArenaSubsystem = UArenaSubsystem::Get(PossesedPawn);
+  const int32 ArenaId = ArenaSubsystem ? ArenaSubsystem->GetArenaId(PossesedPawn) : INDEX_NONE;
+
+  for (AActor* Actor : FoundActors)
+  {
+    AUE5TopDownARPGCharacter* UE5TopDownARPGCharacter = Cast<AUE5TopDownARPGCharacter>(Actor);
+    if (IsValid(UE5TopDownARPGCharacter) == false)
+    {
+      continue;
+    }
+
+    APlayerController* PlayerController = Cast<APlayerController>(UE5TopDownARPGCharacter->GetController());
+    if (IsValid(PlayerController) == false)
+    {
+      continue;
+    }
+
+    if (ArenaSubsystem != nullptr && ArenaSubsystem->GetArenaId(PlayerController) != ArenaId)
+    {
+      continue;
+    }
+
+    UNavigationPath* Path = NavSys->FindPathToLocationSynchronously(World, PossesedPawn->GetActorLocation(), Actor->GetActorLocation());
+    if (Path->IsValid() && Path->IsPartial() == false)
+    {
+      return Actor;
+    }
+    GameplayMetrics::Increment(EGameplayCounter::AIPathFailures);
+  }
+  return nullptr;
 }
\ No newline at end of file
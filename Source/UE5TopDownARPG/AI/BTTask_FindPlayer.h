@@ -1,19 +1,25 @@
-// Fill out your copyright notice in the Description page of Project Settings.
-
-#pragma once
-
-#include "CoreMinimal.h"
-#include "BehaviorTree/Tasks/BTTask_BlackboardBase.h"
-#include "BTTask_FindPlayer.generated.h"
-
-/**
- * 
- */
-UCLASS()
-class UE5TOPDOWNARPG_API UBTTask_FindPlayer : public UBTTask_BlackboardBase
-{
-	GENERATED_BODY()
-
-private:
-	virtual EBTNodeResult::Type ExecuteTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) override;
-};
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BehaviorTree/Tasks/BTTask_BlackboardBase.h"
+#include "BTTask_FindPlayer.generated.h"
+
+/**
+ * 
+ */
+UCLASS()
+class UE5TOPDOWNARPG_API UBTTask_FindPlayer : public UBTTask_BlackboardBase
+{
+	GENERATED_BODY()
+
+public:
+	/** First player in the pawn's arena with a complete path from the pawn, nullptr when none is reachable. */
+	static AActor* FindReachablePlayer(APawn* PossesedPawn);
+
+private:
+	virtual EBTNodeResult::Type ExecuteTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) override;
+
+	EBTNodeResult::Type FindPlayer(UBehaviorTreeComponent& OwnerComp) const;
+};
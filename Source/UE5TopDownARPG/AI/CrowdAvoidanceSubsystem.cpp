@@ -0,0 +1,332 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CrowdAvoidanceSubsystem.h"
+#include "Algo/Sort.h"
+#include "Async/ParallelFor.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/Character.h"
+#include "HAL/IConsoleManager.h"
+#include "Math/VectorRegister.h"
+#include "CrowdBenchmark.h"
+#include "../Characters/ARPGCharacterMovementComponent.h"
+#include "../UE5TopDownARPG.h"
+
+DECLARE_CYCLE_STAT(TEXT("Crowd Avoidance"), STAT_CrowdAvoidance, STATGROUP_ARPG);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Crowd Agents"), STAT_CrowdAgents, STATGROUP_ARPG);
+
+uint64 UCrowdAvoidanceSubsystem::TotalCycles = 0;
+
+namespace
+{
+	bool bCrowdAvoidanceEnabled = true;
+	FAutoConsoleVariableRef CVarCrowdAvoidance(
+		TEXT("ARPG.AI.CrowdAvoidance"),
+		bCrowdAvoidanceEnabled,
+		TEXT("Steers AI characters around each other before they collide."));
+
+	float CrowdAvoidanceHorizon = 0.75f;
+	FAutoConsoleVariableRef CVarCrowdAvoidanceHorizon(
+		TEXT("ARPG.AI.CrowdAvoidance.Horizon"),
+		CrowdAvoidanceHorizon,
+		TEXT("Seconds ahead an agent looks for collisions with its neighbors."));
+
+	float CrowdAvoidanceStrength = 1.0f;
+	FAutoConsoleVariableRef CVarCrowdAvoidanceStrength(
+		TEXT("ARPG.AI.CrowdAvoidance.Strength"),
+		CrowdAvoidanceStrength,
+		TEXT("Scale of the avoidance velocity relative to the agent's max speed."));
+
+	const int32 AgentsPerTask = 32;
+
+	uint64 GetCellKey(const FIntPoint& Cell)
+	{
+		return (uint64(uint32(Cell.X)) << 32) | uint64(uint32(Cell.Y));
+	}
+
+	struct FCrowdCounters
+	{
+		uint64 MovementCycles = 0;
+		uint64 AvoidanceCycles = 0;
+		uint64 Depenetrations = 0;
+		uint64 PawnImpacts = 0;
+	};
+
+	FCrowdCounters ReadCrowdCounters()
+	{
+		FCrowdCounters Counters;
+		Counters.MovementCycles = UARPGCharacterMovementComponent::GetTotalTickCycles();
+		Counters.AvoidanceCycles = UCrowdAvoidanceSubsystem::GetTotalCycles();
+		Counters.Depenetrations = UARPGCharacterMovementComponent::GetTotalDepenetrations();
+		Counters.PawnImpacts = UARPGCharacterMovementComponent::GetTotalPawnImpacts();
+		return Counters;
+	}
+
+	FCrowdBenchmarkPhase MakeCrowdAvoidancePhase(bool bEnabled)
+	{
+		TSharedRef<FCrowdCounters> Start = MakeShared<FCrowdCounters>();
+
+		FCrowdBenchmarkPhase Phase;
+		Phase.Begin = [Start, bEnabled]()
+		{
+			bCrowdAvoidanceEnabled = bEnabled;
+			*Start = ReadCrowdCounters();
+		};
+		Phase.End = [Start, bEnabled](UWorld* World, int32 NumCharacters, double NumFrames)
+		{
+			const FCrowdCounters End = ReadCrowdCounters();
+			UE_LOG(LogUE5TopDownARPG, Log, TEXT("Crowd of %d, avoidance %s: movement %.3f ms/frame, avoidance %.3f ms/frame, %.1f depenetrations/frame, %.1f pawn impacts/frame"),
+				NumCharacters, bEnabled ? TEXT("on") : TEXT("off"),
+				FPlatformTime::ToMilliseconds64(End.MovementCycles - Start->MovementCycles) / NumFrames,
+				FPlatformTime::ToMilliseconds64(End.AvoidanceCycles - Start->AvoidanceCycles) / NumFrames,
+				(End.Depenetrations - Start->Depenetrations) / NumFrames,
+				(End.PawnImpacts - Start->PawnImpacts) / NumFrames);
+		};
+		return Phase;
+	}
+
+	void RunCrowdAvoidanceBenchmark(const TArray<FString>& Args, UWorld* World)
+	{
+		FCrowdBenchmarkSettings Settings;
+		Settings.Name = TEXT("ARPG.Bench.CrowdAvoidance");
+		CrowdBenchmark::ParseArgs(Args, Settings);
+
+		// A tight ring so the whole crowd converges on the player within the first phase.
+		Settings.MinDistance = 800.0f;
+		Settings.DistanceSpread = 800.0f;
+
+		const bool bOriginalEnabled = bCrowdAvoidanceEnabled;
+		Settings.Finish = [bOriginalEnabled]()
+		{
+			bCrowdAvoidanceEnabled = bOriginalEnabled;
+		};
+
+		CrowdBenchmark::Run(World, MoveTemp(Settings), { MakeCrowdAvoidancePhase(false), MakeCrowdAvoidancePhase(true) });
+	}
+
+	FAutoConsoleCommandWithWorldAndArgs CrowdAvoidanceBenchmarkCommand(
+		TEXT("ARPG.Bench.CrowdAvoidance"),
+		TEXT("Spawns a chasing crowd and compares movement cost and collisions with and without avoidance. Args: [NumCharacters=300] [PhaseSeconds=5]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&RunCrowdAvoidanceBenchmark));
+}
+
+bool UCrowdAvoidanceSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	UWorld* World = Cast<UWorld>(Outer);
+	return Super::ShouldCreateSubsystem(Outer) && IsValid(World) && World->IsGameWorld();
+}
+
+void UCrowdAvoidanceSubsystem::RegisterAgent(UARPGCharacterMovementComponent* Agent)
+{
+	if (Agent->CrowdAgentIndex == INDEX_NONE)
+	{
+		Agent->CrowdAgentIndex = Agents.Add(Agent);
+		AvoidanceOffsets.Add(FVector2f::ZeroVector);
+		INC_DWORD_STAT(STAT_CrowdAgents);
+	}
+}
+
+void UCrowdAvoidanceSubsystem::UnregisterAgent(UARPGCharacterMovementComponent* Agent)
+{
+	const int32 AgentIndex = Agent->CrowdAgentIndex;
+	if (Agents.IsValidIndex(AgentIndex) == false || Agents[AgentIndex] != Agent)
+	{
+		return;
+	}
+
+	Agents.RemoveAtSwap(AgentIndex, 1, false);
+	AvoidanceOffsets.RemoveAtSwap(AgentIndex, 1, false);
+	if (Agents.IsValidIndex(AgentIndex))
+	{
+		Agents[AgentIndex]->CrowdAgentIndex = AgentIndex;
+	}
+	Agent->CrowdAgentIndex = INDEX_NONE;
+	DEC_DWORD_STAT(STAT_CrowdAgents);
+}
+
+FVector UCrowdAvoidanceSubsystem::GetAvoidanceOffset(const UARPGCharacterMovementComponent* Agent) const
+{
+	if (bCrowdAvoidanceEnabled == false || AvoidanceOffsets.IsValidIndex(Agent->CrowdAgentIndex) == false)
+	{
+		return FVector::ZeroVector;
+	}
+
+	const FVector2f& Offset = AvoidanceOffsets[Agent->CrowdAgentIndex];
+	return FVector(Offset.X, Offset.Y, 0.0f);
+}
+
+void UCrowdAvoidanceSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_CrowdAvoidance);
+
+	if (bCrowdAvoidanceEnabled == false || Agents.Num() < 2)
+	{
+		for (FVector2f& Offset : AvoidanceOffsets)
+		{
+			Offset = FVector2f::ZeroVector;
+		}
+		return;
+	}
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+
+	GatherAgents();
+
+	const int32 NumAgents = SortedAgents.Num();
+	const int32 NumTasks = FMath::DivideAndRoundUp(NumAgents, AgentsPerTask);
+	ParallelFor(NumTasks, [this, NumAgents](int32 TaskIndex)
+	{
+		const int32 End = FMath::Min((TaskIndex + 1) * AgentsPerTask, NumAgents);
+		for (int32 SortedIndex = TaskIndex * AgentsPerTask; SortedIndex < End; SortedIndex++)
+		{
+			ComputeAvoidance(SortedIndex);
+		}
+	});
+
+	TotalCycles += FPlatformTime::Cycles64() - StartCycles;
+}
+
+TStatId UCrowdAvoidanceSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UCrowdAvoidanceSubsystem, STATGROUP_Tickables);
+}
+
+void UCrowdAvoidanceSubsystem::GatherAgents()
+{
+	const int32 NumAgents = Agents.Num();
+
+	// Cells are large enough that any neighbor that can reach us within the horizon is in the 3x3 block around us.
+	float MaxRadius = 0.0f;
+	float MaxAgentSpeed = 0.0f;
+	for (const UARPGCharacterMovementComponent* Agent : Agents)
+	{
+		MaxRadius = FMath::Max(MaxRadius, Agent->GetAvoidanceRadius());
+		MaxAgentSpeed = FMath::Max(MaxAgentSpeed, Agent->GetMaxSpeed());
+	}
+	CellSize = FMath::Max(4.0f * MaxRadius, 2.0f * MaxAgentSpeed * CrowdAvoidanceHorizon);
+	if (CellSize <= 0.0f)
+	{
+		CellSize = 1.0f;
+	}
+
+	SortKeys.SetNumUninitialized(NumAgents, false);
+	SortedAgents.SetNumUninitialized(NumAgents, false);
+	for (int32 AgentIndex = 0; AgentIndex < NumAgents; AgentIndex++)
+	{
+		const FVector Location = Agents[AgentIndex]->GetActorFeetLocation();
+		SortKeys[AgentIndex] = GetCellKey(FIntPoint(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize)));
+		SortedAgents[AgentIndex] = AgentIndex;
+	}
+	Algo::SortBy(SortedAgents, [this](int32 AgentIndex) { return SortKeys[AgentIndex]; });
+
+	const int32 NumPadded = NumAgents + 3;
+	PositionX.SetNumZeroed(NumPadded, false);
+	PositionY.SetNumZeroed(NumPadded, false);
+	VelocityX.SetNumZeroed(NumPadded, false);
+	VelocityY.SetNumZeroed(NumPadded, false);
+	Radius.SetNumZeroed(NumPadded, false);
+	MaxSpeed.SetNumZeroed(NumPadded, false);
+
+	CellRanges.Reset();
+	for (int32 SortedIndex = 0; SortedIndex < NumAgents; SortedIndex++)
+	{
+		const UARPGCharacterMovementComponent* Agent = Agents[SortedAgents[SortedIndex]];
+		const FVector Location = Agent->GetActorFeetLocation();
+		PositionX[SortedIndex] = Location.X;
+		PositionY[SortedIndex] = Location.Y;
+		VelocityX[SortedIndex] = Agent->Velocity.X;
+		VelocityY[SortedIndex] = Agent->Velocity.Y;
+		Radius[SortedIndex] = Agent->GetAvoidanceRadius();
+		MaxSpeed[SortedIndex] = Agent->GetMaxSpeed();
+
+		const FIntPoint Cell(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize));
+		FIntPoint& Range = CellRanges.FindOrAdd(Cell, FIntPoint(SortedIndex, SortedIndex));
+		Range.Y = SortedIndex + 1;
+	}
+}
+
+void UCrowdAvoidanceSubsystem::ComputeAvoidance(int32 SortedIndex)
+{
+	const float SelfX = PositionX[SortedIndex];
+	const float SelfY = PositionY[SortedIndex];
+	const FIntPoint SelfCell(FMath::FloorToInt(SelfX / CellSize), FMath::FloorToInt(SelfY / CellSize));
+
+	const VectorRegister4Float SelfPositionX = VectorSetFloat1(SelfX);
+	const VectorRegister4Float SelfPositionY = VectorSetFloat1(SelfY);
+	const VectorRegister4Float SelfVelocityX = VectorSetFloat1(VelocityX[SortedIndex]);
+	const VectorRegister4Float SelfVelocityY = VectorSetFloat1(VelocityY[SortedIndex]);
+	const VectorRegister4Float SelfRadius = VectorSetFloat1(Radius[SortedIndex]);
+	const VectorRegister4Float SelfIndex = VectorSetFloat1(float(SortedIndex));
+	const VectorRegister4Float Horizon = VectorSetFloat1(CrowdAvoidanceHorizon);
+	const VectorRegister4Float InvHorizon = VectorSetFloat1(1.0f / FMath::Max(CrowdAvoidanceHorizon, KINDA_SMALL_NUMBER));
+	const VectorRegister4Float Epsilon = VectorSetFloat1(KINDA_SMALL_NUMBER);
+	const VectorRegister4Float LaneOffsets = MakeVectorRegisterFloat(0.0f, 1.0f, 2.0f, 3.0f);
+	const VectorRegister4Float Zero = VectorZeroFloat();
+	const VectorRegister4Float One = VectorOneFloat();
+
+	VectorRegister4Float SteerX = Zero;
+	VectorRegister4Float SteerY = Zero;
+
+	for (int32 CellY = SelfCell.Y - 1; CellY <= SelfCell.Y + 1; CellY++)
+	{
+		for (int32 CellX = SelfCell.X - 1; CellX <= SelfCell.X + 1; CellX++)
+		{
+			const FIntPoint* Range = CellRanges.Find(FIntPoint(CellX, CellY));
+			if (Range == nullptr)
+			{
+				continue;
+			}
+
+			const VectorRegister4Float RangeEnd = VectorSetFloat1(float(Range->Y));
+			for (int32 Other = Range->X; Other < Range->Y; Other += 4)
+			{
+				// Lanes past the end of the cell or on ourselves contribute nothing.
+				const VectorRegister4Float OtherIndex = VectorAdd(VectorSetFloat1(float(Other)), LaneOffsets);
+				const VectorRegister4Float Mask = VectorBitwiseAnd(VectorCompareGT(RangeEnd, OtherIndex), VectorCompareNE(OtherIndex, SelfIndex));
+
+				// Relative position and velocity of the neighbors.
+				const VectorRegister4Float RelativeX = VectorSubtract(VectorLoad(&PositionX[Other]), SelfPositionX);
+				const VectorRegister4Float RelativeY = VectorSubtract(VectorLoad(&PositionY[Other]), SelfPositionY);
+				const VectorRegister4Float RelativeVelocityX = VectorSubtract(VectorLoad(&VelocityX[Other]), SelfVelocityX);
+				const VectorRegister4Float RelativeVelocityY = VectorSubtract(VectorLoad(&VelocityY[Other]), SelfVelocityY);
+
+				// Time of closest approach within the horizon.
+				const VectorRegister4Float RelativeSpeedSquared = VectorMultiplyAdd(RelativeVelocityX, RelativeVelocityX, VectorMultiplyAdd(RelativeVelocityY, RelativeVelocityY, Epsilon));
+				const VectorRegister4Float Approach = VectorNegate(VectorMultiplyAdd(RelativeX, RelativeVelocityX, VectorMultiply(RelativeY, RelativeVelocityY)));
+				const VectorRegister4Float Time = VectorMin(VectorMax(VectorDivide(Approach, RelativeSpeedSquared), Zero), Horizon);
+
+				// Offset to the neighbor at that time and how deep the two would overlap.
+				const VectorRegister4Float ClosestX = VectorMultiplyAdd(RelativeVelocityX, Time, RelativeX);
+				const VectorRegister4Float ClosestY = VectorMultiplyAdd(RelativeVelocityY, Time, RelativeY);
+				const VectorRegister4Float ClosestDistanceSquared = VectorMultiplyAdd(ClosestX, ClosestX, VectorMultiplyAdd(ClosestY, ClosestY, Epsilon));
+				const VectorRegister4Float InvClosestDistance = VectorReciprocalSqrt(ClosestDistanceSquared);
+				const VectorRegister4Float CombinedRadius = VectorAdd(SelfRadius, VectorLoad(&Radius[Other]));
+				const VectorRegister4Float Penetration = VectorMax(VectorSubtract(CombinedRadius, VectorMultiply(ClosestDistanceSquared, InvClosestDistance)), Zero);
+
+				// Sooner and deeper overlaps push harder.
+				const VectorRegister4Float Urgency = VectorSubtract(One, VectorMultiply(Time, InvHorizon));
+				const VectorRegister4Float Weight = VectorBitwiseAnd(VectorMultiply(VectorDivide(Penetration, CombinedRadius), Urgency), Mask);
+				const VectorRegister4Float Scale = VectorMultiply(Weight, InvClosestDistance);
+				SteerX = VectorNegativeMultiplyAdd(ClosestX, Scale, SteerX);
+				SteerY = VectorNegativeMultiplyAdd(ClosestY, Scale, SteerY);
+			}
+		}
+	}
+
+	alignas(16) float SteerXLanes[4];
+	alignas(16) float SteerYLanes[4];
+	VectorStoreAligned(SteerX, SteerXLanes);
+	VectorStoreAligned(SteerY, SteerYLanes);
+
+	// Reciprocal: each side of a pair takes half of the avoidance.
+	const float Speed = 0.5f * CrowdAvoidanceStrength * MaxSpeed[SortedIndex];
+	FVector2f Offset(
+		(SteerXLanes[0] + SteerXLanes[1] + SteerXLanes[2] + SteerXLanes[3]) * Speed,
+		(SteerYLanes[0] + SteerYLanes[1] + SteerYLanes[2] + SteerYLanes[3]) * Speed);
+	if (Offset.SizeSquared() > FMath::Square(MaxSpeed[SortedIndex]))
+	{
+		Offset = Offset.GetSafeNormal() * MaxSpeed[SortedIndex];
+	}
+	AvoidanceOffsets[SortedAgents[SortedIndex]] = Offset;
+}
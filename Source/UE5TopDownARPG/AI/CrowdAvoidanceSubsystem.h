@@ -0,0 +1,62 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "CrowdAvoidanceSubsystem.generated.h"
+
+/**
+ * Computes reciprocal avoidance for every character in one pass per frame. Agents are gathered into
+ * contiguous arrays sorted by grid cell, and each agent tests the neighbors of its surrounding cells
+ * four at a time. AI characters add the resulting offset to their path following move requests,
+ * so a chasing wave spreads around the player instead of piling up and depenetrating.
+ */
+UCLASS()
+class UE5TOPDOWNARPG_API UCrowdAvoidanceSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	void RegisterAgent(class UARPGCharacterMovementComponent* Agent);
+	void UnregisterAgent(class UARPGCharacterMovementComponent* Agent);
+
+	/** Velocity to add to the agent's requested move, computed from last frame's positions. */
+	FVector GetAvoidanceOffset(const class UARPGCharacterMovementComponent* Agent) const;
+
+	int32 GetNumAgents() const { return Agents.Num(); }
+
+	/** Avoidance time accumulated by every instance, for benchmarks. */
+	static uint64 GetTotalCycles() { return TotalCycles; }
+
+private:
+	void GatherAgents();
+	void ComputeAvoidance(int32 SortedIndex);
+
+	UPROPERTY(Transient)
+	TArray<class UARPGCharacterMovementComponent*> Agents;
+
+	/** Per agent, indexed like Agents. */
+	TArray<FVector2f> AvoidanceOffsets;
+
+	// Agents sorted by cell, one array per component so the neighbor loop loads four lanes at once.
+	// Each array has three trailing entries so a four wide load starting at the last agent stays in bounds.
+	TArray<float> PositionX;
+	TArray<float> PositionY;
+	TArray<float> VelocityX;
+	TArray<float> VelocityY;
+	TArray<float> Radius;
+	TArray<float> MaxSpeed;
+	TArray<int32> SortedAgents;
+	TArray<uint64> SortKeys;
+
+	/** Start and end of each occupied cell in the sorted arrays. */
+	TMap<FIntPoint, FIntPoint> CellRanges;
+	float CellSize = 0.0f;
+
+	static uint64 TotalCycles;
+};
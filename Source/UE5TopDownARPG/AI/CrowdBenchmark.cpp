@@ -0,0 +1,178 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CrowdBenchmark.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/PlayerController.h"
+#include "TimerManager.h"
+#include "../Characters/BaseCharacter.h"
+#include "../UE5TopDownARPG.h"
+
+namespace
+{
+	struct FCrowdBenchmarkRun
+	{
+		FCrowdBenchmarkSettings Settings;
+		TArray<FCrowdBenchmarkPhase> Phases;
+		TArray<TWeakObjectPtr<ABaseCharacter>> Spawned;
+		TWeakObjectPtr<UClass> EnemyClass;
+		FVector Center = FVector::ZeroVector;
+		FTimerHandle TimerHandle;
+		int32 PhaseIndex = 0;
+		uint64 StartFrame = 0;
+	};
+
+	void DestroyCrowd(FCrowdBenchmarkRun& Run)
+	{
+		for (const TWeakObjectPtr<ABaseCharacter>& Character : Run.Spawned)
+		{
+			if (Character.IsValid())
+			{
+				Character->Destroy();
+			}
+		}
+		Run.Spawned.Reset();
+	}
+
+	void SpawnCrowd(UWorld* World, FCrowdBenchmarkRun& Run, const FCrowdBenchmarkPhase& Phase)
+	{
+		UClass* EnemyClass = Run.EnemyClass.Get();
+		if (EnemyClass == nullptr)
+		{
+			return;
+		}
+
+		const int32 NumCharacters = Run.Settings.NumCharacters;
+		for (int32 Index = 0; Index < NumCharacters; Index++)
+		{
+			const float Angle = 2.0f * PI * Index / NumCharacters;
+			const float Distance = Run.Settings.MinDistance + Run.Settings.DistanceSpread * (Index % 4) / 4.0f;
+			const FVector Location = Run.Center + FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.0f) * Distance;
+			if (ABaseCharacter* Character = CrowdBenchmark::SpawnClone(World, EnemyClass, Location, Phase.PrepareCharacter))
+			{
+				Run.Spawned.Add(Character);
+			}
+		}
+	}
+
+	void StartPhase(UWorld* World, TSharedRef<FCrowdBenchmarkRun> Run)
+	{
+		const FCrowdBenchmarkPhase& Phase = Run->Phases[Run->PhaseIndex];
+		if (Run->Spawned.Num() == 0)
+		{
+			SpawnCrowd(World, *Run, Phase);
+		}
+
+		if (Phase.Begin)
+		{
+			Phase.Begin();
+		}
+		Run->StartFrame = GFrameCounter;
+
+		TWeakObjectPtr<UWorld> WeakWorld = World;
+		World->GetTimerManager().SetTimer(Run->TimerHandle, FTimerDelegate::CreateLambda([Run, WeakWorld]()
+		{
+			UWorld* World = WeakWorld.Get();
+			if (World == nullptr)
+			{
+				return;
+			}
+
+			const FCrowdBenchmarkPhase& Phase = Run->Phases[Run->PhaseIndex];
+			if (Phase.End)
+			{
+				Phase.End(World, Run->Spawned.Num(), double(FMath::Max<uint64>(GFrameCounter - Run->StartFrame, 1)));
+			}
+
+			if (Run->Settings.bRespawnPerPhase)
+			{
+				DestroyCrowd(*Run);
+			}
+
+			if (++Run->PhaseIndex < Run->Phases.Num())
+			{
+				StartPhase(World, Run);
+				return;
+			}
+
+			if (Run->Settings.Finish)
+			{
+				Run->Settings.Finish();
+			}
+			DestroyCrowd(*Run);
+		}), Run->Settings.PhaseSeconds, false);
+	}
+}
+
+ABaseCharacter* CrowdBenchmark::FindEnemyToClone(UWorld* World, const TFunction<bool(const ABaseCharacter& Character)>& CanClone)
+{
+	for (TActorIterator<ABaseCharacter> It(World); It; ++It)
+	{
+		if (It->IsPlayerControlled() == false && (!CanClone || CanClone(**It)))
+		{
+			return *It;
+		}
+	}
+	return nullptr;
+}
+
+ABaseCharacter* CrowdBenchmark::SpawnClone(UWorld* World, UClass* EnemyClass, const FVector& Location, const TFunction<void(ABaseCharacter& Character)>& Prepare)
+{
+	const FTransform Transform(Location);
+	ABaseCharacter* Character = World->SpawnActorDeferred<ABaseCharacter>(EnemyClass, Transform, nullptr, nullptr, ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn);
+	if (Character == nullptr)
+	{
+		return nullptr;
+	}
+
+	if (Prepare)
+	{
+		Prepare(*Character);
+	}
+	Character->FinishSpawning(Transform);
+	return Character;
+}
+
+void CrowdBenchmark::ParseArgs(const TArray<FString>& Args, FCrowdBenchmarkSettings& Settings)
+{
+	if (Args.Num() > 0)
+	{
+		Settings.NumCharacters = FCString::Atoi(*Args[0]);
+	}
+	if (Args.Num() > 1)
+	{
+		Settings.PhaseSeconds = FCString::Atof(*Args[1]);
+	}
+}
+
+void CrowdBenchmark::Run(UWorld* World, FCrowdBenchmarkSettings Settings, TArray<FCrowdBenchmarkPhase> Phases)
+{
+	APlayerController* PlayerController = World ? World->GetFirstPlayerController() : nullptr;
+	APawn* PlayerPawn = PlayerController ? PlayerController->GetPawn() : nullptr;
+	if (PlayerPawn == nullptr || World->GetNetMode() == NM_Client)
+	{
+		UE_LOG(LogUE5TopDownARPG, Log, TEXT("%s needs a local player pawn on the server"), Settings.Name);
+		return;
+	}
+
+	// Clone whichever enemy is already in the level so the benchmark uses its behavior.
+	ABaseCharacter* Enemy = FindEnemyToClone(World, Settings.CanClone);
+	if (Enemy == nullptr)
+	{
+		UE_LOG(LogUE5TopDownARPG, Log, TEXT("%s needs a suitable enemy in the level to clone"), Settings.Name);
+		return;
+	}
+
+	if (Phases.Num() == 0 || Settings.NumCharacters <= 0)
+	{
+		return;
+	}
+
+	TSharedRef<FCrowdBenchmarkRun> Run = MakeShared<FCrowdBenchmarkRun>();
+	Run->Settings = MoveTemp(Settings);
+	Run->Phases = MoveTemp(Phases);
+	Run->EnemyClass = Enemy->GetClass();
+	Run->Center = PlayerPawn->GetActorLocation();
+	StartPhase(World, Run);
+}
@@ -0,0 +1,61 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class ABaseCharacter;
+
+/** One timed phase of a crowd benchmark. */
+struct FCrowdBenchmarkPhase
+{
+	/** Runs once the crowd is in place, to switch the feature under test and snapshot its counters. */
+	TFunction<void()> Begin;
+
+	/** Logs the phase's measurement over the NumFrames frames it covered. */
+	TFunction<void(UWorld* World, int32 NumCharacters, double NumFrames)> End;
+
+	/** Adjusts each clone of this phase's crowd before it finishes spawning and is possessed. */
+	TFunction<void(ABaseCharacter& Character)> PrepareCharacter;
+};
+
+struct FCrowdBenchmarkSettings
+{
+	/** Console command running the benchmark, used in log messages. */
+	const TCHAR* Name = TEXT("");
+
+	int32 NumCharacters = 300;
+	float PhaseSeconds = 5.0f;
+
+	/** The crowd stands in four rings between MinDistance and MinDistance + DistanceSpread from the player. */
+	float MinDistance = 1500.0f;
+	float DistanceSpread = 1500.0f;
+
+	/** Spawns a fresh crowd for every phase instead of measuring the first one throughout. */
+	bool bRespawnPerPhase = false;
+
+	/** Which enemies in the level may be cloned, any AI character when unset. */
+	TFunction<bool(const ABaseCharacter& Character)> CanClone;
+
+	/** Restores whatever the phases switched, after the last one. */
+	TFunction<void()> Finish;
+};
+
+/**
+ * Scaffold shared by the ARPG.Bench crowd benchmarks: clones the first enemy in the level around the
+ * local player and runs the crowd through timed phases. Each benchmark only supplies its phases.
+ */
+namespace CrowdBenchmark
+{
+	/** The first AI character in the world accepted by CanClone, or null. */
+	ABaseCharacter* FindEnemyToClone(UWorld* World, const TFunction<bool(const ABaseCharacter& Character)>& CanClone = nullptr);
+
+	/** Spawns a clone of EnemyClass, letting Prepare adjust it before it is possessed. */
+	ABaseCharacter* SpawnClone(UWorld* World, UClass* EnemyClass, const FVector& Location, const TFunction<void(ABaseCharacter& Character)>& Prepare = nullptr);
+
+	/** Reads [NumCharacters] [PhaseSeconds] from the command arguments, keeping the defaults for missing ones. */
+	void ParseArgs(const TArray<FString>& Args, FCrowdBenchmarkSettings& Settings);
+
+	/** Spawns the crowd and runs the phases one after another. Needs a local player pawn on the server. */
+	void Run(UWorld* World, FCrowdBenchmarkSettings Settings, TArray<FCrowdBenchmarkPhase> Phases);
+}
@@ -0,0 +1,65 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "EnemyStateMachine.generated.h"
+
+UENUM()
+enum class EEnemyBrain : uint8
+{
+	/** Runs the character's behavior tree with a blackboard. */
+	BehaviorTree,
+	/** Runs the native find, chase and cast loop of UEnemyStateMachineSubsystem, the behavior tree is ignored. */
+	StateMachine
+};
+
+USTRUCT()
+struct FEnemyStateMachineSettings
+{
+	GENERATED_BODY()
+
+	/** Distance to the target at which the enemy stops chasing and casts. */
+	UPROPERTY(EditDefaultsOnly)
+	float AttackRange = 300.0f;
+
+	/** Acceptance radius of the chase move, below AttackRange so the move ends in range. */
+	UPROPERTY(EditDefaultsOnly)
+	float AcceptanceRadius = 150.0f;
+
+	/** Seconds after a cast before searching for a player again. */
+	UPROPERTY(EditDefaultsOnly)
+	float AttackCooldown = 1.0f;
+
+	/** Seconds before searching again when no player was reachable or the cast failed. */
+	UPROPERTY(EditDefaultsOnly)
+	float RetryInterval = 0.5f;
+};
+
+enum class EEnemyState : uint8
+{
+	/** Searches for a reachable player once WaitEndTime passes. */
+	FindPlayer,
+	/** Waits for the scheduled path query. */
+	FindingPlayer,
+	/** Follows the path to Target until in attack range. */
+	Chase,
+	/** Casts the primary ability at Target. */
+	Attack,
+	/** Waits until WaitEndTime, then searches again. */
+	Recover,
+	Num
+};
+
+/** Everything the state machine keeps per agent. */
+struct FEnemyAgentState
+{
+	TWeakObjectPtr<AActor> Target;
+	float WaitEndTime = 0.0f;
+	/** Index into the settings shared by every agent of the same character class. */
+	uint16 SettingsIndex = 0;
+	EEnemyState State = EEnemyState::FindPlayer;
+	bool bMoveRequested = false;
+};
+
+static_assert(sizeof(FEnemyAgentState) <= 16, "FEnemyAgentState is updated in batches and should stay compact");
@@ -0,0 +1,51 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "EnemyStateMachineComponent.h"
+#include "EnemyStateMachineSubsystem.h"
+
+UEnemyStateMachineComponent::UEnemyStateMachineComponent()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+}
+
+void UEnemyStateMachineComponent::StartLogic()
+{
+	UEnemyStateMachineSubsystem* StateMachineSubsystem = UEnemyStateMachineSubsystem::Get(this);
+	if (IsValid(StateMachineSubsystem) && IsRunning() == false)
+	{
+		StateMachineSubsystem->RegisterAgent(this);
+	}
+}
+
+void UEnemyStateMachineComponent::RestartLogic()
+{
+	StopLogic(TEXT("Restart"));
+	StartLogic();
+}
+
+void UEnemyStateMachineComponent::StopLogic(const FString& Reason)
+{
+	UEnemyStateMachineSubsystem* StateMachineSubsystem = UEnemyStateMachineSubsystem::Get(this);
+	if (IsValid(StateMachineSubsystem) && IsRunning())
+	{
+		StateMachineSubsystem->UnregisterAgent(this);
+	}
+}
+
+void UEnemyStateMachineComponent::Cleanup()
+{
+	StopLogic(TEXT("Cleanup"));
+}
+
+bool UEnemyStateMachineComponent::IsRunning() const
+{
+	return AgentIndex != INDEX_NONE;
+}
+
+void UEnemyStateMachineComponent::OnUnregister()
+{
+	StopLogic(TEXT("Unregistered"));
+
+	Super::OnUnregister();
+}
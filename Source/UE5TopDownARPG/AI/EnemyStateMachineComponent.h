@@ -0,0 +1,34 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BrainComponent.h"
+#include "EnemyStateMachineComponent.generated.h"
+
+/**
+ * Brain of enemies whose class selects EEnemyBrain::StateMachine. It holds no state and never ticks:
+ * starting the logic registers the controller with UEnemyStateMachineSubsystem, which keeps the
+ * agent's state and updates it together with every other agent.
+ */
+UCLASS()
+class UE5TOPDOWNARPG_API UEnemyStateMachineComponent : public UBrainComponent
+{
+	GENERATED_BODY()
+
+public:
+	UEnemyStateMachineComponent();
+
+	virtual void StartLogic() override;
+	virtual void RestartLogic() override;
+	virtual void StopLogic(const FString& Reason) override;
+	virtual void Cleanup() override;
+	virtual bool IsRunning() const override;
+
+protected:
+	virtual void OnUnregister() override;
+
+private:
+	friend class UEnemyStateMachineSubsystem;
+	int32 AgentIndex = INDEX_NONE;
+};
@@ -0,0 +1,376 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "EnemyStateMachineSubsystem.h"
+#include "AIController.h"
+#include "BehaviorTree/BlackboardComponent.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+#include "Navigation/PathFollowingComponent.h"
+#include "ARPGBehaviorTreeComponent.h"
+#include "BTTask_FindPlayer.h"
+#include "CrowdBenchmark.h"
+#include "EnemyStateMachineComponent.h"
+#include "../Characters/BaseCharacter.h"
+#include "../Scheduling/GameplayWorkScheduler.h"
+#include "../UE5TopDownARPG.h"
+
+DECLARE_CYCLE_STAT(TEXT("Enemy State Machine"), STAT_EnemyStateMachine, STATGROUP_ARPG);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("State Machine Agents"), STAT_StateMachineAgents, STATGROUP_ARPG);
+
+uint64 UEnemyStateMachineSubsystem::TotalCycles = 0;
+
+namespace
+{
+	struct FBrainFootprint
+	{
+		int32 NumAgents = 0;
+		SIZE_T Bytes = 0;
+	};
+
+	/** Counts every running brain of the given kind in the world and the memory it holds per agent. */
+	FBrainFootprint MeasureBrains(UWorld* World, EEnemyBrain Brain)
+	{
+		FBrainFootprint Footprint;
+		for (TActorIterator<AAIController> It(World); It; ++It)
+		{
+			UBrainComponent* BrainComponent = It->GetBrainComponent();
+			if (IsValid(BrainComponent) == false || BrainComponent->IsRunning() == false)
+			{
+				continue;
+			}
+
+			if (Brain == EEnemyBrain::BehaviorTree)
+			{
+				const UARPGBehaviorTreeComponent* BehaviorTreeComponent = Cast<UARPGBehaviorTreeComponent>(BrainComponent);
+				if (BehaviorTreeComponent == nullptr)
+				{
+					continue;
+				}
+
+				Footprint.Bytes += BehaviorTreeComponent->GetClass()->GetStructureSize() + BehaviorTreeComponent->GetResourceSizeBytes(EResourceSizeMode::Exclusive)
+					+ BehaviorTreeComponent->GetInstanceMemorySize();
+				if (const UBlackboardComponent* BlackboardComponent = It->GetBlackboardComponent())
+				{
+					Footprint.Bytes += BlackboardComponent->GetClass()->GetStructureSize() + BlackboardComponent->GetResourceSizeBytes(EResourceSizeMode::Exclusive);
+				}
+			}
+			else
+			{
+				const UEnemyStateMachineComponent* StateMachineComponent = Cast<UEnemyStateMachineComponent>(BrainComponent);
+				if (StateMachineComponent == nullptr)
+				{
+					continue;
+				}
+
+				Footprint.Bytes += StateMachineComponent->GetClass()->GetStructureSize() + StateMachineComponent->GetResourceSizeBytes(EResourceSizeMode::Exclusive)
+					+ UEnemyStateMachineSubsystem::GetAgentStateSize();
+			}
+			Footprint.NumAgents++;
+		}
+		return Footprint;
+	}
+
+	uint64 GetBrainCycles(EEnemyBrain Brain)
+	{
+		return Brain == EEnemyBrain::BehaviorTree ? UARPGBehaviorTreeComponent::GetTotalTickCycles() : UEnemyStateMachineSubsystem::GetTotalCycles();
+	}
+
+	FCrowdBenchmarkPhase MakeBrainPhase(EEnemyBrain Brain)
+	{
+		TSharedRef<uint64> StartCycles = MakeShared<uint64>(0);
+
+		FCrowdBenchmarkPhase Phase;
+		// The brain is picked on possession, so it is set between spawning and finishing the spawn.
+		Phase.PrepareCharacter = [Brain](ABaseCharacter& Character)
+		{
+			Character.SetBrain(Brain);
+		};
+		Phase.Begin = [StartCycles, Brain]()
+		{
+			*StartCycles = GetBrainCycles(Brain);
+		};
+		Phase.End = [StartCycles, Brain](UWorld* World, int32 NumCharacters, double NumFrames)
+		{
+			const double MsPerFrame = FPlatformTime::ToMilliseconds64(GetBrainCycles(Brain) - *StartCycles) / NumFrames;
+			const FBrainFootprint Footprint = MeasureBrains(World, Brain);
+			const int32 NumAgents = FMath::Max(Footprint.NumAgents, 1);
+			UE_LOG(LogUE5TopDownARPG, Log, TEXT("%s brain: %d agents, %.3f ms/frame, %.2f us/agent/frame, %.0f bytes/agent"),
+				Brain == EEnemyBrain::BehaviorTree ? TEXT("Behavior tree") : TEXT("State machine"),
+				Footprint.NumAgents, MsPerFrame, MsPerFrame * 1000.0 / NumAgents, double(Footprint.Bytes) / NumAgents);
+		};
+		return Phase;
+	}
+
+	void RunBrainBenchmark(const TArray<FString>& Args, UWorld* World)
+	{
+		FCrowdBenchmarkSettings Settings;
+		Settings.Name = TEXT("ARPG.Bench.AIBrain");
+		Settings.NumCharacters = 200;
+		Settings.PhaseSeconds = 10.0f;
+		CrowdBenchmark::ParseArgs(Args, Settings);
+
+		// Each brain gets its own crowd of the first enemy class that runs a behavior tree.
+		Settings.MinDistance = 1500.0f;
+		Settings.DistanceSpread = 1000.0f;
+		Settings.bRespawnPerPhase = true;
+		Settings.CanClone = [](const ABaseCharacter& Character)
+		{
+			return IsValid(Character.GetBehaviorTree());
+		};
+
+		CrowdBenchmark::Run(World, MoveTemp(Settings), { MakeBrainPhase(EEnemyBrain::BehaviorTree), MakeBrainPhase(EEnemyBrain::StateMachine) });
+	}
+
+	FAutoConsoleCommandWithWorldAndArgs BrainBenchmarkCommand(
+		TEXT("ARPG.Bench.AIBrain"),
+		TEXT("Spawns a crowd of the first enemy class running its behavior tree, then the same crowd on the state machine, and logs brain time and memory per agent. Args: [NumCharacters=200] [PhaseSeconds=10]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&RunBrainBenchmark));
+}
+
+bool UEnemyStateMachineSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	UWorld* World = Cast<UWorld>(Outer);
+	return Super::ShouldCreateSubsystem(Outer) && IsValid(World) && World->IsGameWorld();
+}
+
+UEnemyStateMachineSubsystem* UEnemyStateMachineSubsystem::Get(const UObject* WorldContextObject)
+{
+	UWorld* World = IsValid(WorldContextObject) ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UEnemyStateMachineSubsystem>() : nullptr;
+}
+
+void UEnemyStateMachineSubsystem::RegisterAgent(UEnemyStateMachineComponent* Agent)
+{
+	AAIController* Controller = Agent->GetAIOwner();
+	const ABaseCharacter* Character = IsValid(Controller) ? Cast<ABaseCharacter>(Controller->GetPawn()) : nullptr;
+	if (IsValid(Character) == false || Agent->AgentIndex != INDEX_NONE)
+	{
+		return;
+	}
+
+	Agent->AgentIndex = Agents.Add(Agent);
+	Controllers.Add(Controller);
+	FEnemyAgentState& State = States.AddDefaulted_GetRef();
+	State.SettingsIndex = GetSettingsIndex(Character);
+	INC_DWORD_STAT(STAT_StateMachineAgents);
+}
+
+void UEnemyStateMachineSubsystem::UnregisterAgent(UEnemyStateMachineComponent* Agent)
+{
+	const int32 AgentIndex = Agent->AgentIndex;
+	if (Agents.IsValidIndex(AgentIndex) == false || Agents[AgentIndex] != Agent)
+	{
+		return;
+	}
+
+	Agent->AgentIndex = INDEX_NONE;
+	DEC_DWORD_STAT(STAT_StateMachineAgents);
+
+	if (bUpdatingAgents)
+	{
+		Agents[AgentIndex] = nullptr;
+		Controllers[AgentIndex] = nullptr;
+		PendingRemovals.Add(AgentIndex);
+		return;
+	}
+	RemoveAgentAt(AgentIndex);
+}
+
+void UEnemyStateMachineSubsystem::RemoveAgentAt(int32 AgentIndex)
+{
+	Agents.RemoveAtSwap(AgentIndex, 1, false);
+	Controllers.RemoveAtSwap(AgentIndex, 1, false);
+	States.RemoveAtSwap(AgentIndex, 1, false);
+	if (Agents.IsValidIndex(AgentIndex) && Agents[AgentIndex] != nullptr)
+	{
+		Agents[AgentIndex]->AgentIndex = AgentIndex;
+	}
+}
+
+uint16 UEnemyStateMachineSubsystem::GetSettingsIndex(const ABaseCharacter* Character)
+{
+	if (const uint16* SettingsIndex = SettingsIndices.Find(Character->GetClass()))
+	{
+		return *SettingsIndex;
+	}
+
+	const uint16 SettingsIndex = uint16(Settings.Add(Character->GetStateMachineSettings()));
+	SettingsIndices.Add(Character->GetClass(), SettingsIndex);
+	return SettingsIndex;
+}
+
+void UEnemyStateMachineSubsystem::SetState(int32 AgentIndex, EEnemyState State, float WaitEndTime)
+{
+	FEnemyAgentState& AgentState = States[AgentIndex];
+	AgentState.State = State;
+	AgentState.WaitEndTime = WaitEndTime;
+	AgentState.bMoveRequested = false;
+}
+
+void UEnemyStateMachineSubsystem::OnPlayerSearched(UEnemyStateMachineComponent* Agent)
+{
+	const int32 AgentIndex = Agent->AgentIndex;
+	if (Agent->IsRunning() == false || States[AgentIndex].State != EEnemyState::FindingPlayer)
+	{
+		return;
+	}
+
+	AActor* Target = UBTTask_FindPlayer::FindReachablePlayer(Controllers[AgentIndex]->GetPawn());
+	if (Target == nullptr)
+	{
+		const FEnemyStateMachineSettings& AgentSettings = Settings[States[AgentIndex].SettingsIndex];
+		SetState(AgentIndex, EEnemyState::FindPlayer, GetWorld()->GetTimeSeconds() + AgentSettings.RetryInterval);
+		return;
+	}
+
+	SetState(AgentIndex, EEnemyState::Chase);
+	States[AgentIndex].Target = Target;
+}
+
+template<>
+void UEnemyStateMachineSubsystem::UpdateAgent<EEnemyState::FindPlayer>(int32 AgentIndex, float Now)
+{
+	FEnemyAgentState& State = States[AgentIndex];
+	UEnemyStateMachineComponent* Agent = Agents[AgentIndex];
+	if (Agent == nullptr || Now < State.WaitEndTime)
+	{
+		return;
+	}
+
+	State.State = EEnemyState::FindingPlayer;
+	State.Target.Reset();
+
+	// Path queries are the expensive part of target refresh, let them wait for a frame with room.
+	TWeakObjectPtr<UEnemyStateMachineComponent> WeakAgent = Agent;
+	UGameplayWorkScheduler::SubmitOrRun(Agent, EGameplayWorkPriority::Low, [this, WeakAgent]()
+	{
+		if (UEnemyStateMachineComponent* Agent = WeakAgent.Get())
+		{
+			OnPlayerSearched(Agent);
+		}
+	});
+}
+
+template<>
+void UEnemyStateMachineSubsystem::UpdateAgent<EEnemyState::Chase>(int32 AgentIndex, float Now)
+{
+	AAIController* Controller = Controllers[AgentIndex];
+	const APawn* Pawn = Controller ? Controller->GetPawn() : nullptr;
+	if (Pawn == nullptr)
+	{
+		return;
+	}
+
+	FEnemyAgentState& State = States[AgentIndex];
+	AActor* Target = State.Target.Get();
+	if (IsValid(Target) == false)
+	{
+		SetState(AgentIndex, EEnemyState::FindPlayer, Now);
+		return;
+	}
+
+	const FEnemyStateMachineSettings& AgentSettings = Settings[State.SettingsIndex];
+	if (FVector::DistSquared2D(Pawn->GetActorLocation(), Target->GetActorLocation()) <= FMath::Square(AgentSettings.AttackRange))
+	{
+		SetState(AgentIndex, EEnemyState::Attack);
+		return;
+	}
+
+	// The move follows the target by itself, it is only requested again once it ended.
+	if (State.bMoveRequested == false || Controller->GetMoveStatus() == EPathFollowingStatus::Idle)
+	{
+		State.bMoveRequested = true;
+		if (Controller->MoveToActor(Target, AgentSettings.AcceptanceRadius) == EPathFollowingRequestResult::Failed)
+		{
+			SetState(AgentIndex, EEnemyState::Recover, Now + AgentSettings.RetryInterval);
+		}
+	}
+}
+
+template<>
+void UEnemyStateMachineSubsystem::UpdateAgent<EEnemyState::Attack>(int32 AgentIndex, float Now)
+{
+	AAIController* Controller = Controllers[AgentIndex];
+	ABaseCharacter* Character = Controller ? Cast<ABaseCharacter>(Controller->GetPawn()) : nullptr;
+	if (Character == nullptr)
+	{
+		return;
+	}
+
+	const AActor* Target = States[AgentIndex].Target.Get();
+	if (IsValid(Target) == false)
+	{
+		SetState(AgentIndex, EEnemyState::FindPlayer, Now);
+		return;
+	}
+
+	const FEnemyStateMachineSettings& AgentSettings = Settings[States[AgentIndex].SettingsIndex];
+	Controller->StopMovement();
+	const bool bActivated = Character->ActivateAbility(Target->GetActorLocation());
+	SetState(AgentIndex, EEnemyState::Recover, Now + (bActivated ? AgentSettings.AttackCooldown : AgentSettings.RetryInterval));
+}
+
+template<>
+void UEnemyStateMachineSubsystem::UpdateAgent<EEnemyState::Recover>(int32 AgentIndex, float Now)
+{
+	if (Now >= States[AgentIndex].WaitEndTime)
+	{
+		SetState(AgentIndex, EEnemyState::FindPlayer, Now);
+	}
+}
+
+template<EEnemyState State>
+void UEnemyStateMachineSubsystem::UpdateBatch(float Now)
+{
+	for (const int32 AgentIndex : Batches[(int32)State])
+	{
+		UpdateAgent<State>(AgentIndex, Now);
+	}
+}
+
+void UEnemyStateMachineSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_EnemyStateMachine);
+
+	if (Agents.Num() == 0)
+	{
+		return;
+	}
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+	const float Now = GetWorld()->GetTimeSeconds();
+
+	for (TArray<int32>& Batch : Batches)
+	{
+		Batch.Reset();
+	}
+	for (int32 AgentIndex = 0; AgentIndex < States.Num(); AgentIndex++)
+	{
+		Batches[(int32)States[AgentIndex].State].Add(AgentIndex);
+	}
+
+	// Agents waiting on a path query have nothing to update.
+	bUpdatingAgents = true;
+	UpdateBatch<EEnemyState::FindPlayer>(Now);
+	UpdateBatch<EEnemyState::Chase>(Now);
+	UpdateBatch<EEnemyState::Attack>(Now);
+	UpdateBatch<EEnemyState::Recover>(Now);
+	bUpdatingAgents = false;
+
+	// Highest first, so the agent swapped into a removed slot is never one still pending.
+	PendingRemovals.Sort(TGreater<int32>());
+	for (const int32 AgentIndex : PendingRemovals)
+	{
+		RemoveAgentAt(AgentIndex);
+	}
+	PendingRemovals.Reset();
+
+	TotalCycles += FPlatformTime::Cycles64() - StartCycles;
+}
+
+TStatId UEnemyStateMachineSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UEnemyStateMachineSubsystem, STATGROUP_Tickables);
+}
@@ -0,0 +1,71 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "EnemyStateMachine.h"
+#include "EnemyStateMachineSubsystem.generated.h"
+
+/**
+ * Runs the behavior of every enemy with a UEnemyStateMachineComponent: find a reachable player, chase it
+ * and cast the primary ability, the same loop as the enemy behavior tree. Agent state lives in compact
+ * structs in one array. Each frame the agents are bucketed by state and every bucket runs through the
+ * update specialized for that state, with no per-agent component tick, node search or blackboard lookup.
+ */
+UCLASS()
+class UE5TOPDOWNARPG_API UEnemyStateMachineSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	static UEnemyStateMachineSubsystem* Get(const UObject* WorldContextObject);
+
+	void RegisterAgent(class UEnemyStateMachineComponent* Agent);
+	void UnregisterAgent(class UEnemyStateMachineComponent* Agent);
+
+	int32 GetNumAgents() const { return Agents.Num() - PendingRemovals.Num(); }
+
+	/** Memory the subsystem keeps per agent, excluding the component. */
+	static constexpr SIZE_T GetAgentStateSize() { return sizeof(FEnemyAgentState) + 2 * sizeof(UObject*); }
+
+	/** Update time accumulated by every instance, for benchmarks. */
+	static uint64 GetTotalCycles() { return TotalCycles; }
+
+private:
+	template<EEnemyState State>
+	void UpdateBatch(float Now);
+
+	template<EEnemyState State>
+	void UpdateAgent(int32 AgentIndex, float Now);
+
+	void SetState(int32 AgentIndex, EEnemyState State, float WaitEndTime = 0.0f);
+	void OnPlayerSearched(class UEnemyStateMachineComponent* Agent);
+	uint16 GetSettingsIndex(const class ABaseCharacter* Character);
+	void RemoveAgentAt(int32 AgentIndex);
+
+	// Per agent, indexed by UEnemyStateMachineComponent::AgentIndex.
+	UPROPERTY(Transient)
+	TArray<class UEnemyStateMachineComponent*> Agents;
+
+	UPROPERTY(Transient)
+	TArray<class AAIController*> Controllers;
+
+	TArray<FEnemyAgentState> States;
+
+	/** Agent indices per state, rebuilt every frame. */
+	TArray<int32> Batches[(int32)EEnemyState::Num];
+
+	/** Agents that stopped during the update, removed once it is done so the batches stay valid. */
+	TArray<int32> PendingRemovals;
+	bool bUpdatingAgents = false;
+
+	TArray<FEnemyStateMachineSettings> Settings;
+	TMap<TObjectKey<UClass>, uint16> SettingsIndices;
+
+	static uint64 TotalCycles;
+};
@@ -1,37 +1,69 @@
-// Fill out your copyright notice in the Description page of Project Settings.
-
-
-#include "UE5TopDownARPGAIController.h"
-#include "../UE5TopDownARPGCharacter.h"
-#include "BehaviorTree/BlackboardComponent.h"
-#include "BehaviorTree/BehaviorTreeComponent.h"
-#include "BehaviorTree/BehaviorTree.h"
-
-AUE5TopDownARPGAIController::AUE5TopDownARPGAIController()
-{
-  BlackboardComponent = CreateDefaultSubobject<UBlackboardComponent>(TEXT("BlackboardComponent"));
-  BehaviorTreeComponent = CreateDefaultSubobject<UBehaviorTreeComponent>(TEXT("BehaviorTreeComponent"));
-}
-
-void AUE5TopDownARPGAIController::OnPossess(APawn* InPawn)
-{
-  Super::OnPossess(InPawn);
-
-  AUE5TopDownARPGCharacter* PossesedCharacter = Cast<AUE5TopDownARPGCharacter>(InPawn);
-  if (IsValid(PossesedCharacter))
-  {
-    UBehaviorTree* Tree = PossesedCharacter->GetBehaviorTree();
-    if (IsValid(Tree))
-    {
-      BlackboardComponent->InitializeBlackboard(*Tree->GetBlackboardAsset());
-      BehaviorTreeComponent->StartTree(*Tree);
-    }
-  }
-}
-
-void AUE5TopDownARPGAIController::OnUnPossess()
-{
-  Super::OnUnPossess();
-
-  BehaviorTreeComponent->StopTree();
-}
\ No newline at end of file
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "UE5TopDownARPGAIController.h"
+#include "../Characters/BaseCharacter.h"
+#include "BehaviorTree/BlackboardComponent.h"
+#include "BehaviorTree/BehaviorTree.h"
+#include "ARPGBehaviorTreeComponent.h"
+#include "EnemyStateMachineComponent.h"
+#include "../Startup/StartupProfiler.h"
+
+void AUE5TopDownARPGAIController::OnPossess(APawn* InPawn)
+{
+  FScopedStartupPhase StartupPhase(EStartupPhase::AIPossess);
+
+  Super::OnPossess(InPawn);
+
+  ABaseCharacter* PossesedCharacter = Cast<ABaseCharacter>(InPawn);
+  if (IsValid(PossesedCharacter))
+  {
+    if (PossesedCharacter->GetBrain() == EEnemyBrain::StateMachine)
+    {
+      StartStateMachine();
+      return;
+    }
+
+    UBehaviorTree* Tree = PossesedCharacter->GetBehaviorTree();
+    if (IsValid(Tree))
+    {
+      StartBehaviorTree(*Tree);
+    }
+  }
+}
+
+void AUE5TopDownARPGAIController::OnUnPossess()
+{
+  Super::OnUnPossess();
+
+  if (IsValid(BrainComponent))
+  {
+    BrainComponent->StopLogic(TEXT("UnPossessed"));
+  }
+}
+
+void AUE5TopDownARPGAIController::StartBehaviorTree(UBehaviorTree& Tree)
+{
+  // Registered before the blackboard, which hands itself to the brain it finds on initialization.
+  if (BehaviorTreeComponent == nullptr)
+  {
+    BehaviorTreeComponent = NewObject<UARPGBehaviorTreeComponent>(this, TEXT("BehaviorTreeComponent"));
+    BehaviorTreeComponent->RegisterComponent();
+  }
+  BrainComponent = BehaviorTreeComponent;
+
+  UseBlackboard(Tree.GetBlackboardAsset(), BlackboardComponent);
+  BehaviorTreeComponent->StartTree(Tree);
+}
+
+void AUE5TopDownARPGAIController::StartStateMachine()
+{
+  if (StateMachineComponent == nullptr)
+  {
+    StateMachineComponent = NewObject<UEnemyStateMachineComponent>(this, TEXT("StateMachineComponent"));
+    StateMachineComponent->RegisterComponent();
+  }
+  BrainComponent = StateMachineComponent;
+
+  StateMachineComponent->StartLogic();
+}
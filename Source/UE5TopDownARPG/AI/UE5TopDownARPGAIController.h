@@ -1,30 +1,34 @@
-// Fill out your copyright notice in the Description page of Project Settings.
-
-#pragma once
-
-#include "CoreMinimal.h"
-#include "AIController.h"
-#include "UE5TopDownARPGAIController.generated.h"
-
-/**
- * 
- */
-UCLASS()
-class UE5TOPDOWNARPG_API AUE5TopDownARPGAIController : public AAIController
-{
-	GENERATED_BODY()
-
-public:
-	AUE5TopDownARPGAIController();
-
-protected:
-	virtual void OnPossess(APawn* InPawn) override;
-	virtual void OnUnPossess() override;
-
-	UPROPERTY()
-	class UBlackboardComponent* BlackboardComponent;
-
-	UPROPERTY()
-	class UBehaviorTreeComponent* BehaviorTreeComponent;
-
-};
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AIController.h"
+#include "UE5TopDownARPGAIController.generated.h"
+
+/**
+ * 
+ */
+UCLASS()
+class UE5TOPDOWNARPG_API AUE5TopDownARPGAIController : public AAIController
+{
+	GENERATED_BODY()
+
+protected:
+	virtual void OnPossess(APawn* InPawn) override;
+	virtual void OnUnPossess() override;
+
+	/** Brains are created on first possession, so a controller only carries the one its pawn selects. */
+	void StartBehaviorTree(class UBehaviorTree& Tree);
+	void StartStateMachine();
+
+	UPROPERTY()
+	class UBlackboardComponent* BlackboardComponent;
+
+	UPROPERTY()
+	class UBehaviorTreeComponent* BehaviorTreeComponent;
+
+	UPROPERTY()
+	class UEnemyStateMachineComponent* StateMachineComponent;
+
+};
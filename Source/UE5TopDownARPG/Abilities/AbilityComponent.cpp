@@ -0,0 +1,207 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AbilityComponent.h"
+#include "../Characters/BaseCharacter.h"
+#include "../Loading/AssetPreloadSubsystem.h"
+#include "../Persistence/CheckpointSubsystem.h"
+#include "../UE5TopDownARPG.h"
+#include "Engine/World.h"
+#include "GameFramework/GameStateBase.h"
+#include "Net/UnrealNetwork.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Abilities Activated"), STAT_AbilitiesActivated, STATGROUP_ARPG);
+
+UAbilityComponent::UAbilityComponent()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+	SetIsReplicatedByDefault(true);
+}
+
+void UAbilityComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME_CONDITION(UAbilityComponent, Slots, COND_OwnerOnly);
+}
+
+void UAbilityComponent::InsertAbilityClass(const TSoftClassPtr<UBaseAbility>& AbilityClass, int32 Index)
+{
+	if (AbilityClass.IsNull() == false)
+	{
+		AbilityClasses.Insert(AbilityClass, FMath::Min(Index, AbilityClasses.Num()));
+	}
+}
+
+void UAbilityComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	UAssetPreloadSubsystem* PreloadSubsystem = GetWorld()->GetSubsystem<UAssetPreloadSubsystem>();
+	if (PreloadSubsystem == nullptr)
+	{
+		OnAbilityClassesLoaded();
+		return;
+	}
+
+	TArray<FSoftObjectPath> AbilityPaths;
+	for (const TSoftClassPtr<UBaseAbility>& AbilityClass : AbilityClasses)
+	{
+		AbilityPaths.Add(AbilityClass.ToSoftObjectPath());
+	}
+	PreloadSubsystem->RequestPreload(AbilityPaths, TEXT("Ability"),
+		FStreamableDelegate::CreateUObject(this, &UAbilityComponent::OnAbilityClassesLoaded));
+}
+
+void UAbilityComponent::OnAbilityClassesLoaded()
+{
+	if (Definitions.Num() > 0)
+	{
+		return;
+	}
+
+	TArray<FSoftObjectPath> AbilityAssets;
+	for (const TSoftClassPtr<UBaseAbility>& AbilityClass : AbilityClasses)
+	{
+		TSubclassOf<UBaseAbility> LoadedClass = UAssetPreloadSubsystem::Resolve(this, AbilityClass);
+		const UBaseAbility* Definition = LoadedClass ? GetDefault<UBaseAbility>(LoadedClass) : nullptr;
+		Definitions.Add(Definition);
+		if (Definition != nullptr)
+		{
+			Definition->GatherPreloadAssets(AbilityAssets);
+		}
+	}
+
+	if (UAssetPreloadSubsystem* PreloadSubsystem = GetWorld()->GetSubsystem<UAssetPreloadSubsystem>())
+	{
+		PreloadSubsystem->RequestPreload(AbilityAssets, TEXT("AbilityAssets"));
+	}
+
+	// Slots restored from a checkpoint before the classes finished loading are kept.
+	if (GetOwner()->HasAuthority() && Slots.Num() == 0)
+	{
+		Slots.Reset(Definitions.Num());
+		for (int32 DefinitionIndex = 0; DefinitionIndex < Definitions.Num(); DefinitionIndex++)
+		{
+			FAbilitySlotState& Slot = Slots.AddDefaulted_GetRef();
+			Slot.DefinitionIndex = uint8(DefinitionIndex);
+			Slot.Charges = Definitions[DefinitionIndex] ? Definitions[DefinitionIndex]->GetMaxCharges() : 0;
+		}
+	}
+}
+
+bool UAbilityComponent::CanActivateAbility(int32 SlotIndex) const
+{
+	if (Slots.IsValidIndex(SlotIndex) == false)
+	{
+		return false;
+	}
+
+	FAbilitySlotState Slot = Slots[SlotIndex];
+	RestoreCharges(Slot, GetServerTime());
+	return Slot.Charges > 0;
+}
+
+bool UAbilityComponent::ActivateAbility(int32 SlotIndex, const FVector& Location)
+{
+	if (CanActivateAbility(SlotIndex) == false)
+	{
+		return false;
+	}
+
+	const float ClientTimestamp = GetServerTime();
+	if (GetOwner()->HasAuthority())
+	{
+		return ActivateOnServer(SlotIndex, Location, ClientTimestamp);
+	}
+
+	ServerRPC_ActivateAbility(uint8(SlotIndex), Location, ClientTimestamp);
+	return true;
+}
+
+void UAbilityComponent::RestoreSlots(TArrayView<const FAbilitySlotState> RestoredSlots)
+{
+	Slots.Reset(RestoredSlots.Num());
+	Slots.Append(RestoredSlots.GetData(), RestoredSlots.Num());
+}
+
+void UAbilityComponent::ServerRPC_ActivateAbility_Implementation(uint8 SlotIndex, FVector_NetQuantize Location, float ClientTimestamp)
+{
+	ActivateOnServer(SlotIndex, Location, ClientTimestamp);
+}
+
+bool UAbilityComponent::ActivateOnServer(int32 SlotIndex, const FVector& Location, float ClientTimestamp)
+{
+	ABaseCharacter* Caster = Cast<ABaseCharacter>(GetOwner());
+	if (Slots.IsValidIndex(SlotIndex) == false || IsValid(Caster) == false)
+	{
+		return false;
+	}
+
+	FAbilitySlotState& Slot = Slots[SlotIndex];
+	const UBaseAbility* Definition = GetDefinition(Slot.DefinitionIndex);
+	const float Time = GetServerTime();
+	RestoreCharges(Slot, Time);
+	if (Definition == nullptr || Slot.Charges == 0)
+	{
+		return false;
+	}
+
+	FAbilityCastEvent CastEvent;
+	if (Definition->Execute(Caster, Location, ClientTimestamp, CastEvent) == false)
+	{
+		return false;
+	}
+
+	if (Slot.Charges == Definition->GetMaxCharges())
+	{
+		Slot.CooldownEndTime = Time + Definition->GetCooldown();
+	}
+	Slot.Charges--;
+	INC_DWORD_STAT(STAT_AbilitiesActivated);
+
+	if (UCheckpointSubsystem* CheckpointSubsystem = UCheckpointSubsystem::Get(this))
+	{
+		CheckpointSubsystem->MarkDirty(Caster);
+	}
+
+	MulticastRPC_AbilityCast(Slot.DefinitionIndex, CastEvent);
+	return true;
+}
+
+void UAbilityComponent::MulticastRPC_AbilityCast_Implementation(uint8 DefinitionIndex, const FAbilityCastEvent& CastEvent)
+{
+	ABaseCharacter* Caster = Cast<ABaseCharacter>(GetOwner());
+	const UBaseAbility* Definition = GetDefinition(DefinitionIndex);
+	if (IsValid(Caster) && Definition != nullptr)
+	{
+		Definition->OnCastEvent(Caster, CastEvent);
+	}
+}
+
+void UAbilityComponent::RestoreCharges(FAbilitySlotState& Slot, float Time) const
+{
+	const UBaseAbility* Definition = GetDefinition(Slot.DefinitionIndex);
+	if (Definition == nullptr)
+	{
+		return;
+	}
+
+	while (Slot.Charges < Definition->GetMaxCharges() && Time >= Slot.CooldownEndTime)
+	{
+		Slot.Charges++;
+		Slot.CooldownEndTime += Definition->GetCooldown();
+	}
+}
+
+const UBaseAbility* UAbilityComponent::GetDefinition(int32 DefinitionIndex) const
+{
+	return Definitions.IsValidIndex(DefinitionIndex) ? Definitions[DefinitionIndex] : nullptr;
+}
+
+float UAbilityComponent::GetServerTime() const
+{
+	// Cooldowns are stored in server time so the owning client can check them locally.
+	const AGameStateBase* GameState = GetWorld()->GetGameState();
+	return IsValid(GameState) ? GameState->GetServerWorldTimeSeconds() : GetWorld()->GetTimeSeconds();
+}
@@ -0,0 +1,77 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "BaseAbility.h"
+#include "AbilityComponent.generated.h"
+
+/** Runtime state of one ability slot. The ability itself is a shared, stateless definition. */
+USTRUCT()
+struct FAbilitySlotState
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	uint8 DefinitionIndex = 0;
+
+	UPROPERTY()
+	uint8 Charges = 0;
+
+	/** Server world time at which the next charge is restored. */
+	UPROPERTY()
+	float CooldownEndTime = 0.0f;
+};
+
+/**
+ * Holds a character's abilities as compact slot states and routes their activation to the server.
+ */
+UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
+class UE5TOPDOWNARPG_API UAbilityComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UAbilityComponent();
+
+	virtual void BeginPlay() override;
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	/** Adds an ability class ahead of the configured ones. Call before BeginPlay. */
+	void InsertAbilityClass(const TSoftClassPtr<UBaseAbility>& AbilityClass, int32 Index);
+
+	bool ActivateAbility(int32 SlotIndex, const FVector& Location);
+	bool CanActivateAbility(int32 SlotIndex) const;
+
+	int32 GetNumSlots() const { return Slots.Num(); }
+	const TArray<FAbilitySlotState>& GetSlots() const { return Slots; }
+
+	/** Replaces the slot states, used when restoring a checkpoint. */
+	void RestoreSlots(TArrayView<const FAbilitySlotState> RestoredSlots);
+
+private:
+	void OnAbilityClassesLoaded();
+
+	bool ActivateOnServer(int32 SlotIndex, const FVector& Location, float ClientTimestamp);
+	void RestoreCharges(FAbilitySlotState& Slot, float Time) const;
+	const UBaseAbility* GetDefinition(int32 DefinitionIndex) const;
+	float GetServerTime() const;
+
+	UFUNCTION(Server, Reliable)
+	void ServerRPC_ActivateAbility(uint8 SlotIndex, FVector_NetQuantize Location, float ClientTimestamp);
+
+	UFUNCTION(NetMulticast, Unreliable)
+	void MulticastRPC_AbilityCast(uint8 DefinitionIndex, const FAbilityCastEvent& CastEvent);
+
+	UPROPERTY(EditDefaultsOnly)
+	TArray<TSoftClassPtr<UBaseAbility>> AbilityClasses;
+
+	/** Class default objects of AbilityClasses, shared by every character using them. */
+	UPROPERTY(Transient)
+	TArray<const UBaseAbility*> Definitions;
+
+	/** Only the owning client needs cooldowns, simulated proxies only see cast events. */
+	UPROPERTY(Replicated)
+	TArray<FAbilitySlotState> Slots;
+};
@@ -0,0 +1,164 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AreaAbility.h"
+#include "../Characters/ARPGCharacterMovementComponent.h"
+#include "../Characters/BaseCharacter.h"
+#include "../Scheduling/GameplayWorkScheduler.h"
+#include "../UE5TopDownARPG.h"
+#include "Algo/Sort.h"
+#include "Algo/Unique.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/CollisionProfile.h"
+#include "Engine/DamageEvents.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "NiagaraFunctionLibrary.h"
+
+DECLARE_CYCLE_STAT(TEXT("Area Cast"), STAT_AreaCast, STATGROUP_ARPG);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Area Targets Hit"), STAT_AreaTargetsHit, STATGROUP_ARPG);
+
+namespace
+{
+	// There are no teams: players and AI fight each other, and non-pawn damageable actors are fair game.
+	bool IsOpponent(const ABaseCharacter* Caster, const AActor* Target)
+	{
+		const APawn* TargetPawn = Cast<APawn>(Target);
+		return TargetPawn == nullptr || TargetPawn->IsPlayerControlled() != Caster->IsPlayerControlled();
+	}
+
+	void RunAreaAbilityBenchmark(const TArray<FString>& Args, UWorld* World)
+	{
+		const int32 NumTargets = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 200;
+		const int32 NumIterations = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 100;
+		const float Radius = 600.0f;
+		if (IsValid(World) == false || NumTargets <= 0 || NumIterations <= 0)
+		{
+			return;
+		}
+
+		// Plain pawn-channel capsules stand in for characters so only the query cost is measured.
+		const FVector Center(0.0f, 0.0f, 5000.0f);
+		FRandomStream Stream(NumTargets);
+		TArray<AActor*> Dummies;
+		for (int32 Index = 0; Index < NumTargets; Index++)
+		{
+			const FVector2D Offset = FVector2D(Stream.GetUnitVector()).GetSafeNormal() * Stream.FRandRange(0.0f, Radius - 50.0f);
+			FActorSpawnParameters SpawnParameters;
+			SpawnParameters.ObjectFlags |= RF_Transient;
+			AActor* Dummy = World->SpawnActor<AActor>(AActor::StaticClass(), FTransform(Center + FVector(Offset, 0.0f)), SpawnParameters);
+
+			UCapsuleComponent* Capsule = NewObject<UCapsuleComponent>(Dummy);
+			Capsule->InitCapsuleSize(42.0f, 96.0f);
+			Capsule->SetCollisionProfileName(UCollisionProfile::Pawn_ProfileName);
+			Dummy->SetRootComponent(Capsule);
+			Capsule->RegisterComponent();
+			Dummies.Add(Dummy);
+		}
+
+		TArray<FOverlapResult> Overlaps;
+		FAreaTargetArray Targets;
+		double StartTime = FPlatformTime::Seconds();
+		for (int32 Iteration = 0; Iteration < NumIterations; Iteration++)
+		{
+			Targets.Reset();
+			UAreaAbility::GatherTargets(World, Center, Radius, nullptr, Overlaps, Targets);
+		}
+		const double BatchedMs = (FPlatformTime::Seconds() - StartTime) * 1000.0 / NumIterations;
+
+		// What designers built before: one projectile-sized overlap per target.
+		StartTime = FPlatformTime::Seconds();
+		for (int32 Iteration = 0; Iteration < NumIterations; Iteration++)
+		{
+			for (const AActor* Dummy : Dummies)
+			{
+				Overlaps.Reset();
+				World->OverlapMultiByObjectType(Overlaps, Dummy->GetActorLocation(), FQuat::Identity,
+					FCollisionObjectQueryParams(ECC_Pawn), FCollisionShape::MakeSphere(20.0f));
+			}
+		}
+		const double PerTargetMs = (FPlatformTime::Seconds() - StartTime) * 1000.0 / NumIterations;
+
+		UE_LOG(LogUE5TopDownARPG, Log, TEXT("Area cast over %d targets: %d found, batched query %.3f ms, per-target queries %.3f ms"),
+			NumTargets, Targets.Num(), BatchedMs, PerTargetMs);
+
+		for (AActor* Dummy : Dummies)
+		{
+			Dummy->Destroy();
+		}
+	}
+
+	FAutoConsoleCommandWithWorldAndArgs AreaAbilityBenchmarkCommand(
+		TEXT("ARPG.Bench.AreaAbility"),
+		TEXT("Compares one batched area query with per-target queries. Args: [NumTargets=200] [NumIterations=100]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&RunAreaAbilityBenchmark));
+}
+
+bool UAreaAbility::Execute(ABaseCharacter* Caster, const FVector& Location, float ClientTimestamp, FAbilityCastEvent& OutCastEvent) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_AreaCast);
+
+	const FVector CasterLocation = Caster->GetActorLocation();
+	const FVector Center = CasterLocation + (Location - CasterLocation).GetClampedToMaxSize(CastRange);
+
+	TArray<FOverlapResult> Overlaps;
+	FAreaTargetArray Targets;
+	GatherTargets(Caster->GetWorld(), Center, Radius, Caster, Overlaps, Targets);
+	Targets.RemoveAllSwap([Caster](const AActor* Target)
+	{
+		return IsOpponent(Caster, Target) == false;
+	}, false);
+
+	for (AActor* Target : Targets)
+	{
+		Target->TakeDamage(Damage, FDamageEvent(UDamageType::StaticClass()), Caster->GetController(), Caster);
+
+		ABaseCharacter* TargetCharacter = Cast<ABaseCharacter>(Target);
+		UARPGCharacterMovementComponent* TargetMovement = TargetCharacter ? Cast<UARPGCharacterMovementComponent>(TargetCharacter->GetCharacterMovement()) : nullptr;
+		if (KnockbackSpeed > 0.0f && IsValid(TargetMovement))
+		{
+			TargetMovement->ApplyKnockback((Target->GetActorLocation() - Center).GetSafeNormal2D() * KnockbackSpeed);
+		}
+	}
+	INC_DWORD_STAT_BY(STAT_AreaTargetsHit, Targets.Num());
+
+	OutCastEvent.Location = Center;
+	OutCastEvent.NumTargets = uint8(FMath::Min(Targets.Num(), 255));
+	return true;
+}
+
+void UAreaAbility::OnCastEvent(ABaseCharacter* Caster, const FAbilityCastEvent& CastEvent) const
+{
+	Super::OnCastEvent(Caster, CastEvent);
+
+	if (Caster->GetNetMode() != NM_DedicatedServer && IsValid(CastEffect))
+	{
+		const FVector EffectLocation = CastEvent.Location;
+		UGameplayWorkScheduler::SubmitOrRun(Caster, EGameplayWorkPriority::Low, [this, Caster, EffectLocation]()
+		{
+			UNiagaraFunctionLibrary::SpawnSystemAtLocation(Caster, CastEffect, EffectLocation, FRotator::ZeroRotator, FVector(Radius / 100.0f));
+		});
+	}
+}
+
+void UAreaAbility::GatherTargets(UWorld* World, const FVector& Center, float Radius, const AActor* IgnoredActor, TArray<FOverlapResult>& Overlaps, FAreaTargetArray& OutTargets)
+{
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(AreaAbility), false, IgnoredActor);
+	Overlaps.Reset();
+	World->OverlapMultiByObjectType(Overlaps, Center, FQuat::Identity, FCollisionObjectQueryParams(ECC_Pawn), FCollisionShape::MakeSphere(Radius), QueryParams);
+
+	// An actor can overlap with several components, keep each one once.
+	const int32 FirstTarget = OutTargets.Num();
+	for (const FOverlapResult& Overlap : Overlaps)
+	{
+		AActor* Actor = Overlap.GetActor();
+		if (IsValid(Actor) && Actor->CanBeDamaged())
+		{
+			OutTargets.Add(Actor);
+		}
+	}
+
+	TArrayView<AActor*> NewTargets = MakeArrayView(OutTargets).Slice(FirstTarget, OutTargets.Num() - FirstTarget);
+	Algo::Sort(NewTargets);
+	OutTargets.SetNum(FirstTarget + Algo::Unique(NewTargets), false);
+}
@@ -0,0 +1,45 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BaseAbility.h"
+#include "WorldCollision.h"
+#include "AreaAbility.generated.h"
+
+/** Targets of one area query; sized so a typical cast does not allocate. */
+using FAreaTargetArray = TArray<AActor*, TInlineAllocator<32>>;
+
+/**
+ * Damages every opponent of the caster inside a sphere with a single overlap query per cast.
+ */
+UCLASS()
+class UE5TOPDOWNARPG_API UAreaAbility : public UBaseAbility
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool Execute(class ABaseCharacter* Caster, const FVector& Location, float ClientTimestamp, FAbilityCastEvent& OutCastEvent) const override;
+	virtual void OnCastEvent(class ABaseCharacter* Caster, const FAbilityCastEvent& CastEvent) const override;
+
+	/** Unique actors with a pawn body inside the sphere, ignoring IgnoredActor. */
+	static void GatherTargets(UWorld* World, const FVector& Center, float Radius, const AActor* IgnoredActor, TArray<FOverlapResult>& Overlaps, FAreaTargetArray& OutTargets);
+
+private:
+	UPROPERTY(EditDefaultsOnly)
+	float Radius = 400.0f;
+
+	/** Farthest distance from the caster the area can be centered. */
+	UPROPERTY(EditDefaultsOnly)
+	float CastRange = 1000.0f;
+
+	UPROPERTY(EditDefaultsOnly)
+	float Damage = 20.0f;
+
+	/** Horizontal push away from the center, in cm/s. Zero disables knockback. */
+	UPROPERTY(EditDefaultsOnly)
+	float KnockbackSpeed = 0.0f;
+
+	UPROPERTY(EditDefaultsOnly)
+	class UNiagaraSystem* CastEffect;
+};
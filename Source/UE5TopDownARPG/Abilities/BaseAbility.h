@@ -1,33 +1,51 @@
-// Fill out your copyright notice in the Description page of Project Settings.
-
-#pragma once
-
-#include "CoreMinimal.h"
-#include "UObject/NoExportTypes.h"
-#include "BaseAbility.generated.h"
-
-/**
- * 
- */
-UCLASS(Blueprintable)
-class UE5TOPDOWNARPG_API UBaseAbility : public UObject
-{
-	GENERATED_BODY()
-
-public:
-	virtual bool Activate(FVector Location);
-	virtual bool IsSupportedForNetworking() const override { return true; }
-	virtual bool CallRemoteFunction(UFunction* Function, void* Params, struct FOutParmRec* OutParms, FFrame* Stack) override;
-	virtual int32 GetFunctionCallspace(UFunction* Fuction, FFrame* Stack) override;
-
-protected:
-	UPROPERTY(EditDefaultsOnly)
-	float Cooldown = 1.0f;
-
-	bool bIsInCooldown = false;
-
-	FTimerHandle CooldownTimerHandle;
-
-private:
-	void OnCooldownEnded();
-};
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/NoExportTypes.h"
+#include "Engine/NetSerialization.h"
+#include "BaseAbility.generated.h"
+
+/** What clients need to present a cast, sent once per cast. */
+USTRUCT()
+struct FAbilityCastEvent
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FVector_NetQuantize Location;
+
+	UPROPERTY()
+	uint8 NumTargets = 0;
+};
+
+/**
+ * Stateless ability definition. Characters share the class default object and keep their
+ * cooldowns and charges in UAbilityComponent.
+ */
+UCLASS(Blueprintable)
+class UE5TOPDOWNARPG_API UBaseAbility : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	/** Resolves the ability on the server. Fills OutCastEvent for clients and returns whether it was cast. */
+	virtual bool Execute(class ABaseCharacter* Caster, const FVector& Location, float ClientTimestamp, FAbilityCastEvent& OutCastEvent) const;
+
+	/** Cosmetic response to a cast the server resolved, runs on every machine. */
+	virtual void OnCastEvent(class ABaseCharacter* Caster, const FAbilityCastEvent& CastEvent) const;
+
+	/** Adds soft-referenced assets the ability will need on activation. */
+	virtual void GatherPreloadAssets(TArray<FSoftObjectPath>& OutAssetPaths) const {}
+
+	float GetCooldown() const { return Cooldown; }
+	uint8 GetMaxCharges() const { return MaxCharges; }
+
+protected:
+	UPROPERTY(EditDefaultsOnly)
+	float Cooldown = 1.0f;
+
+	UPROPERTY(EditDefaultsOnly, meta = (ClampMin = 1))
+	uint8 MaxCharges = 1;
+};
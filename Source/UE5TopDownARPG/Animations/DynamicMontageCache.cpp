@@ -0,0 +1,75 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "DynamicMontageCache.h"
+#include "Animation/AnimMontage.h"
+#include "Animation/AnimSequenceBase.h"
+#include "Engine/Engine.h"
+#include "HAL/IConsoleManager.h"
+#include "../UE5TopDownARPG.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Dynamic Montages Created"), STAT_DynamicMontagesCreated, STATGROUP_ARPG);
+
+namespace
+{
+	void LogMontageStats()
+	{
+		if (UDynamicMontageCache* MontageCache = GEngine ? GEngine->GetEngineSubsystem<UDynamicMontageCache>() : nullptr)
+		{
+			MontageCache->LogStats();
+		}
+	}
+
+	FAutoConsoleCommand MontageStatsCommand(
+		TEXT("ARPG.MontageStats"),
+		TEXT("Logs dynamic montage allocations per minute and cache hits."),
+		FConsoleCommandDelegate::CreateStatic(&LogMontageStats));
+}
+
+void UDynamicMontageCache::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	StartTime = FPlatformTime::Seconds();
+}
+
+void UDynamicMontageCache::Deinitialize()
+{
+	MontageLookup.Reset();
+	Montages.Reset();
+
+	Super::Deinitialize();
+}
+
+UAnimMontage* UDynamicMontageCache::GetOrCreateMontage(UAnimSequenceBase* Animation, FName SlotName)
+{
+	if (IsValid(Animation) == false)
+	{
+		return nullptr;
+	}
+
+	const FMontageKey Key(Animation, SlotName);
+	if (UAnimMontage** CachedMontage = MontageLookup.Find(Key))
+	{
+		NumCacheHits++;
+		return *CachedMontage;
+	}
+
+	UAnimMontage* Montage = UAnimMontage::CreateSlotAnimationAsDynamicMontage(Animation, SlotName);
+	if (IsValid(Montage) == false)
+	{
+		return nullptr;
+	}
+
+	INC_DWORD_STAT(STAT_DynamicMontagesCreated);
+	MontageLookup.Add(Key, Montage);
+	Montages.Add(Montage);
+	return Montage;
+}
+
+void UDynamicMontageCache::LogStats() const
+{
+	const double Minutes = FMath::Max((FPlatformTime::Seconds() - StartTime) / 60.0, 1.0 / 60.0);
+	UE_LOG(LogUE5TopDownARPG, Log, TEXT("Dynamic montages: %d created (%.2f per minute), %d cache hits"),
+		Montages.Num(), Montages.Num() / Minutes, NumCacheHits);
+}
@@ -0,0 +1,37 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/EngineSubsystem.h"
+#include "DynamicMontageCache.generated.h"
+
+/**
+ * Shares one dynamic montage per animation and slot between all anim instances,
+ * instead of building a transient montage on every PlaySlotAnimationAsDynamicMontage call.
+ */
+UCLASS()
+class UE5TOPDOWNARPG_API UDynamicMontageCache : public UEngineSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	UAnimMontage* GetOrCreateMontage(UAnimSequenceBase* Animation, FName SlotName);
+
+	void LogStats() const;
+
+private:
+	typedef TPair<TObjectKey<UAnimSequenceBase>, FName> FMontageKey;
+
+	TMap<FMontageKey, UAnimMontage*> MontageLookup;
+
+	/** Keeps the cached montages alive. */
+	UPROPERTY(Transient)
+	TArray<UAnimMontage*> Montages;
+
+	int32 NumCacheHits = 0;
+	double StartTime = 0.0;
+};
@@ -1,9 +1,54 @@
-// Fill out your copyright notice in the Description page of Project Settings.
-
-
-#include "UE5TopDownARPGAnimInstance.h"
-
-void UUE5TopDownARPGAnimInstance::SetIsAttacking()
-{
-  PlaySlotAnimationAsDynamicMontage(AttackAnimation, FName(TEXT("UpperBody")));
-}
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "UE5TopDownARPGAnimInstance.h"
+#include "DynamicMontageCache.h"
+#include "Engine/Engine.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/CharacterMovementComponent.h"
+
+void UUE5TopDownARPGAnimInstance::SetIsAttacking()
+{
+  static const FName UpperBodySlotName(TEXT("UpperBody"));
+
+  UDynamicMontageCache* MontageCache = GEngine ? GEngine->GetEngineSubsystem<UDynamicMontageCache>() : nullptr;
+  if (MontageCache == nullptr)
+  {
+    PlaySlotAnimationAsDynamicMontage(AttackAnimation, UpperBodySlotName);
+    return;
+  }
+
+  UAnimMontage* Montage = MontageCache->GetOrCreateMontage(AttackAnimation, UpperBodySlotName);
+  if (IsValid(Montage))
+  {
+    Montage_Play(Montage);
+  }
+}
+
+void UUE5TopDownARPGAnimInstance::NativeUpdateAnimation(float DeltaSeconds)
+{
+  Super::NativeUpdateAnimation(DeltaSeconds);
+
+  ACharacter* Character = Cast<ACharacter>(TryGetPawnOwner());
+  if (IsValid(Character) == false)
+  {
+    return;
+  }
+
+  UCharacterMovementComponent* MovementComponent = Character->GetCharacterMovement();
+  if (IsValid(MovementComponent))
+  {
+    Velocity = MovementComponent->Velocity;
+    CurrentAcceleration = MovementComponent->GetCurrentAcceleration();
+    bIsFallingOnGameThread = MovementComponent->IsFalling();
+  }
+}
+
+void UUE5TopDownARPGAnimInstance::NativeThreadSafeUpdateAnimation(float DeltaSeconds)
+{
+  Super::NativeThreadSafeUpdateAnimation(DeltaSeconds);
+
+  GroundSpeed = Velocity.Size2D();
+  bShouldMove = GroundSpeed > 3.0f && CurrentAcceleration.IsNearlyZero() == false;
+  bIsFalling = bIsFallingOnGameThread;
+}
@@ -1,23 +1,41 @@
-// Fill out your copyright notice in the Description page of Project Settings.
-
-#pragma once
-
-#include "CoreMinimal.h"
-#include "Animation/AnimInstance.h"
-#include "UE5TopDownARPGAnimInstance.generated.h"
-
-/**
- * 
- */
-UCLASS()
-class UE5TOPDOWNARPG_API UUE5TopDownARPGAnimInstance : public UAnimInstance
-{
-	GENERATED_BODY()
-public:
-	void SetIsAttacking();
-
-protected:
-	UPROPERTY(EditDefaultsOnly)
-	UAnimSequenceBase* AttackAnimation;
-	
-};
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Animation/AnimInstance.h"
+#include "UE5TopDownARPGAnimInstance.generated.h"
+
+/**
+ * 
+ */
+UCLASS()
+class UE5TOPDOWNARPG_API UUE5TopDownARPGAnimInstance : public UAnimInstance
+{
+	GENERATED_BODY()
+public:
+	void SetIsAttacking();
+
+protected:
+	virtual void NativeUpdateAnimation(float DeltaSeconds) override;
+	virtual void NativeThreadSafeUpdateAnimation(float DeltaSeconds) override;
+
+	UPROPERTY(EditDefaultsOnly)
+	UAnimSequenceBase* AttackAnimation;
+
+	/** Locomotion values for the anim graph, computed off the game thread. */
+	UPROPERTY(BlueprintReadOnly, Category = Locomotion)
+	float GroundSpeed = 0.0f;
+
+	UPROPERTY(BlueprintReadOnly, Category = Locomotion)
+	bool bShouldMove = false;
+
+	UPROPERTY(BlueprintReadOnly, Category = Locomotion)
+	bool bIsFalling = false;
+
+private:
+	// Gathered on the game thread in NativeUpdateAnimation.
+	FVector Velocity = FVector::ZeroVector;
+	FVector CurrentAcceleration = FVector::ZeroVector;
+	bool bIsFallingOnGameThread = false;
+};
@@ -0,0 +1,391 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ArenaSubsystem.h"
+#include "Engine/LevelStreamingDynamic.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/GameModeBase.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformMemory.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "TimerManager.h"
+#include "../Characters/BaseCharacter.h"
+#include "../Projectiles/Projectile.h"
+#include "../Projectiles/ProjectilePoolSubsystem.h"
+#include "../Trigger/SpawnTrigger.h"
+#include "../UE5TopDownARPG.h"
+#include "../UE5TopDownARPGPlayerController.h"
+
+namespace
+{
+	float ArenaSpacing = 50000.0f;
+	FAutoConsoleVariableRef CVarArenaSpacing(
+		TEXT("ARPG.Arena.Spacing"),
+		ArenaSpacing,
+		TEXT("Distance between arena origins along X. Must exceed the size of the arena map."),
+		ECVF_ReadOnly);
+
+	float ArenaRestartSeconds = 5.0f;
+	FAutoConsoleVariableRef CVarArenaRestartSeconds(
+		TEXT("ARPG.Arena.RestartSeconds"),
+		ArenaRestartSeconds,
+		TEXT("Seconds after a match ends before its arena reloads for the next one. Negative keeps ended arenas."));
+
+	void LogArenaReport(const TArray<FString>& Args, UWorld* World)
+	{
+		if (UArenaSubsystem* Subsystem = UArenaSubsystem::Get(World))
+		{
+			Subsystem->LogReport(Args.Num() > 0 ? FCString::Atof(*Args[0]) : 30.0f);
+		}
+	}
+
+	FAutoConsoleCommandWithWorldAndArgs ArenaReportCommand(
+		TEXT("ARPG.ArenaReport"),
+		TEXT("Logs players and matches per arena, memory per match and matches per core. Args: [ServerTickRate=30]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&LogArenaReport));
+
+	double ToMegabytes(int64 Bytes)
+	{
+		return double(Bytes) / (1024.0 * 1024.0);
+	}
+}
+
+bool UArenaSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	UWorld* World = Cast<UWorld>(Outer);
+	return Super::ShouldCreateSubsystem(Outer) && IsValid(World) && World->IsGameWorld();
+}
+
+void UArenaSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	if (InWorld.GetNetMode() == NM_Client)
+	{
+		return;
+	}
+
+	// A single arena is the persistent level, which keeps the report comparable with one process per match.
+	int32 NumArenas = 1;
+	FParse::Value(FCommandLine::Get(), TEXT("ARPGArenas="), NumArenas);
+	NumArenas = FMath::Max(NumArenas, 1);
+
+	Spacing = ArenaSpacing;
+	bPersistentLevelIsArena = NumArenas == 1 || FParse::Value(FCommandLine::Get(), TEXT("ARPGArenaMap="), ArenaMapName) == false;
+	if (bPersistentLevelIsArena)
+	{
+		ArenaMapName = UWorld::RemovePIEPrefix(InWorld.GetOutermost()->GetName());
+	}
+	BaselineMemory = FPlatformMemory::GetStats().UsedPhysical;
+
+	Arenas.SetNum(NumArenas);
+	ArenaLevels.SetNumZeroed(NumArenas);
+	for (int32 ArenaId = 0; ArenaId < NumArenas; ArenaId++)
+	{
+		if (ArenaId > 0 || bPersistentLevelIsArena == false)
+		{
+			LoadArena(ArenaId);
+		}
+		Arenas[ArenaId].MatchStartTime = InWorld.GetTimeSeconds();
+	}
+
+	// Players may join as soon as the server listens, have every arena ready before that.
+	if (NumArenas > 1)
+	{
+		InWorld.FlushLevelStreaming();
+		UE_LOG(LogUE5TopDownARPG, Log, TEXT("Hosting %d arenas of %s"), NumArenas, *ArenaMapName);
+	}
+
+	TickStartHandle = FWorldDelegates::OnWorldTickStart.AddUObject(this, &UArenaSubsystem::OnWorldTickStart);
+}
+
+void UArenaSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldTickStart.Remove(TickStartHandle);
+
+	Super::Deinitialize();
+}
+
+UArenaSubsystem* UArenaSubsystem::Get(const UObject* WorldContextObject)
+{
+	UWorld* World = IsValid(WorldContextObject) ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UArenaSubsystem>() : nullptr;
+}
+
+bool UArenaSubsystem::IsNetRelevantFor(const AActor* Actor, const AActor* RealViewer, const AActor* ViewTarget)
+{
+	const UArenaSubsystem* Subsystem = Get(Actor);
+	if (Subsystem == nullptr || Subsystem->GetNumArenas() <= 1)
+	{
+		return true;
+	}
+
+	// Viewers not assigned to an arena yet see everything, as they did before arenas.
+	const int32 ViewerArena = Subsystem->GetArenaId(RealViewer != nullptr ? RealViewer : ViewTarget);
+	return ViewerArena == INDEX_NONE || Subsystem->GetArenaId(Actor) == ViewerArena;
+}
+
+int32 UArenaSubsystem::GetArenaId(const FVector& Location) const
+{
+	if (Arenas.Num() <= 1)
+	{
+		return Arenas.Num() - 1;
+	}
+
+	const int32 ArenaId = FMath::RoundToInt(Location.X / Spacing);
+	return Arenas.IsValidIndex(ArenaId) ? ArenaId : INDEX_NONE;
+}
+
+int32 UArenaSubsystem::GetArenaId(const AActor* Actor) const
+{
+	if (IsValid(Actor) == false)
+	{
+		return INDEX_NONE;
+	}
+
+	const APawn* Pawn = Cast<APawn>(Actor);
+	const AController* Controller = Pawn ? Pawn->GetController() : Cast<AController>(Actor);
+	if (const int32* PlayerArena = Controller ? PlayerArenas.Find(Controller) : nullptr)
+	{
+		return *PlayerArena;
+	}
+	return GetArenaId(Actor->GetActorLocation());
+}
+
+FVector UArenaSubsystem::GetArenaOrigin(int32 ArenaId) const
+{
+	return FVector(ArenaId * Spacing, 0.0f, 0.0f);
+}
+
+int32 UArenaSubsystem::AssignPlayer(AController* Player)
+{
+	if (const int32* PlayerArena = PlayerArenas.Find(Player))
+	{
+		return *PlayerArena;
+	}
+
+	int32 ArenaId = 0;
+	for (int32 Index = 1; Index < Arenas.Num(); Index++)
+	{
+		if (Arenas[Index].Players.Num() < Arenas[ArenaId].Players.Num())
+		{
+			ArenaId = Index;
+		}
+	}
+
+	Arenas[ArenaId].Players.Add(Player);
+	PlayerArenas.Add(Player, ArenaId);
+	SendArenaToClient(ArenaId, Player);
+	return ArenaId;
+}
+
+void UArenaSubsystem::RemovePlayer(AController* Player)
+{
+	int32 ArenaId = INDEX_NONE;
+	if (PlayerArenas.RemoveAndCopyValue(Player, ArenaId))
+	{
+		Arenas[ArenaId].Players.Remove(Player);
+	}
+}
+
+void UArenaSubsystem::EndArena(int32 ArenaId, bool bIsWin)
+{
+	if (Arenas.IsValidIndex(ArenaId) == false || Arenas[ArenaId].bEnded)
+	{
+		return;
+	}
+
+	FArena& Arena = Arenas[ArenaId];
+	Arena.NumMatches++;
+	Arena.NumWins += bIsWin ? 1 : 0;
+	UE_LOG(LogUE5TopDownARPG, Log, TEXT("Arena %d: %s after %.1f s"), ArenaId, bIsWin ? TEXT("Win") : TEXT("Lose"),
+		GetWorld()->GetTimeSeconds() - Arena.MatchStartTime);
+
+	// A single arena is the game as it was before arenas: the end only posts the game-ended message.
+	if (Arenas.Num() <= 1)
+	{
+		Arena.MatchStartTime = GetWorld()->GetTimeSeconds();
+		return;
+	}
+
+	Arena.bEnded = true;
+	if (ArenaRestartSeconds >= 0.0f)
+	{
+		GetWorld()->GetTimerManager().SetTimer(Arena.RestartTimerHandle,
+			FTimerDelegate::CreateUObject(this, &UArenaSubsystem::RestartArena, ArenaId), FMath::Max(ArenaRestartSeconds, 0.01f), false);
+	}
+}
+
+void UArenaSubsystem::LoadArena(int32 ArenaId)
+{
+	FArena& Arena = Arenas[ArenaId];
+
+	// Instance names must be unique per load and match on clients, so they count the matches.
+	Arena.InstanceName = FString::Printf(TEXT("%s_Arena%d_%d"), *ArenaMapName, ArenaId, Arena.NumMatches);
+
+	bool bSucceeded = false;
+	ArenaLevels[ArenaId] = ULevelStreamingDynamic::LoadLevelInstance(GetWorld(), ArenaMapName, GetArenaOrigin(ArenaId), FRotator::ZeroRotator, bSucceeded, Arena.InstanceName);
+	if (bSucceeded == false)
+	{
+		UE_LOG(LogUE5TopDownARPG, Error, TEXT("Could not load arena %d from %s"), ArenaId, *ArenaMapName);
+		return;
+	}
+	ArenaLevels[ArenaId]->OnLevelShown.AddDynamic(this, &UArenaSubsystem::OnArenaLevelShown);
+}
+
+void UArenaSubsystem::RestartArena(int32 ArenaId)
+{
+	UWorld* World = GetWorld();
+	FArena& Arena = Arenas[ArenaId];
+
+	// Spawned enemies and projectiles live in the persistent level and would survive the reload. The persistent
+	// arena is not reloaded, its spawn triggers stop instead and start over when the players reach them again.
+	for (TActorIterator<AActor> It(World); It; ++It)
+	{
+		if (It->GetLevel() != World->PersistentLevel || GetArenaId(It->GetActorLocation()) != ArenaId)
+		{
+			continue;
+		}
+
+		const ABaseCharacter* Character = Cast<ABaseCharacter>(*It);
+		if (AProjectile* Projectile = Cast<AProjectile>(*It))
+		{
+			UProjectilePoolSubsystem::Release(Projectile);
+		}
+		else if (Character != nullptr && Character->IsPlayerControlled() == false)
+		{
+			It->Destroy();
+		}
+		else if (ASpawnTrigger* SpawnTrigger = Cast<ASpawnTrigger>(*It))
+		{
+			SpawnTrigger->StopWaves();
+		}
+	}
+
+	Arena.bEnded = false;
+	Arena.MatchStartTime = World->GetTimeSeconds();
+	if (Arena.InstanceName.IsEmpty())
+	{
+		RestartPlayers(ArenaId);
+		return;
+	}
+
+	if (ArenaLevels[ArenaId] != nullptr)
+	{
+		ArenaLevels[ArenaId]->SetIsRequestingUnloadAndRemoval(true);
+	}
+	Arena.bRestartPending = true;
+	LoadArena(ArenaId);
+
+	for (const TWeakObjectPtr<AController>& Player : Arena.Players)
+	{
+		if (AController* Controller = Player.Get())
+		{
+			SendArenaToClient(ArenaId, Controller);
+			if (APawn* Pawn = Controller->GetPawn())
+			{
+				Pawn->Destroy();
+			}
+		}
+	}
+}
+
+void UArenaSubsystem::RestartPlayers(int32 ArenaId)
+{
+	AGameModeBase* GameMode = GetWorld()->GetAuthGameMode();
+	for (const TWeakObjectPtr<AController>& Player : Arenas[ArenaId].Players)
+	{
+		AController* Controller = Player.Get();
+		if (Controller == nullptr || GameMode == nullptr)
+		{
+			continue;
+		}
+
+		if (APawn* Pawn = Controller->GetPawn())
+		{
+			Pawn->Destroy();
+		}
+		GameMode->RestartPlayer(Controller);
+	}
+}
+
+void UArenaSubsystem::OnArenaLevelShown()
+{
+	for (int32 ArenaId = 0; ArenaId < Arenas.Num(); ArenaId++)
+	{
+		FArena& Arena = Arenas[ArenaId];
+		if (Arena.bRestartPending == false || ArenaLevels[ArenaId] == nullptr || ArenaLevels[ArenaId]->IsLevelVisible() == false)
+		{
+			continue;
+		}
+
+		Arena.bRestartPending = false;
+		RestartPlayers(ArenaId);
+	}
+}
+
+void UArenaSubsystem::SendArenaToClient(int32 ArenaId, AController* Player) const
+{
+	AUE5TopDownARPGPlayerController* PlayerController = Cast<AUE5TopDownARPGPlayerController>(Player);
+	if (PlayerController == nullptr || PlayerController->IsLocalController())
+	{
+		return;
+	}
+
+	// Clients only load their own arena, so the server never replicates the static actors of the others.
+	const FString& InstanceName = Arenas[ArenaId].InstanceName;
+	PlayerController->ClientLoadArena(InstanceName.IsEmpty() ? FString() : ArenaMapName, InstanceName, GetArenaOrigin(ArenaId));
+}
+
+void UArenaSubsystem::LoadClientArena(const FString& MapName, const FString& InstanceName, const FVector& Origin)
+{
+	if (ClientArenaLevel != nullptr)
+	{
+		ClientArenaLevel->SetIsRequestingUnloadAndRemoval(true);
+		ClientArenaLevel = nullptr;
+	}
+
+	if (MapName.IsEmpty() == false)
+	{
+		bool bSucceeded = false;
+		ClientArenaLevel = ULevelStreamingDynamic::LoadLevelInstance(GetWorld(), MapName, Origin, FRotator::ZeroRotator, bSucceeded, InstanceName);
+	}
+}
+
+void UArenaSubsystem::OnWorldTickStart(UWorld* TickedWorld, ELevelTick TickType, float DeltaTime)
+{
+	if (TickedWorld != GetWorld())
+	{
+		return;
+	}
+
+	// The previous frame's busy time, including replication, which runs after the world tick.
+	TickSeconds += FMath::Max(FApp::GetDeltaTime() - FApp::GetIdleTime(), 0.0);
+	NumTicks++;
+}
+
+void UArenaSubsystem::LogReport(float ServerTickRate) const
+{
+	const double Now = GetWorld()->GetTimeSeconds();
+	for (int32 ArenaId = 0; ArenaId < Arenas.Num(); ArenaId++)
+	{
+		const FArena& Arena = Arenas[ArenaId];
+		UE_LOG(LogUE5TopDownARPG, Log, TEXT("Arena %d: %d players, %d matches (%d won), current match %s %.1f s"),
+			ArenaId, Arena.Players.Num(), Arena.NumMatches, Arena.NumWins, Arena.bEnded ? TEXT("ended after") : TEXT("running for"), Now - Arena.MatchStartTime);
+	}
+
+	// One process per match pays the baseline, which holds the engine and shared assets, once per match.
+	const int64 UsedMemory = FPlatformMemory::GetStats().UsedPhysical;
+	const int32 NumInstances = Arenas.Num() - (bPersistentLevelIsArena ? 1 : 0);
+	const int64 InstanceMemory = NumInstances > 0 ? FMath::Max<int64>(UsedMemory - int64(BaselineMemory), 0) / NumInstances : 0;
+	const int64 OneProcessMemory = BaselineMemory + (bPersistentLevelIsArena ? 0 : InstanceMemory);
+	UE_LOG(LogUE5TopDownARPG, Log, TEXT("Memory: %.1f MB per match hosted (%.1f MB for %d arenas), %.1f MB per match with one process per match"),
+		ToMegabytes(UsedMemory) / FMath::Max(Arenas.Num(), 1), ToMegabytes(UsedMemory), Arenas.Num(), ToMegabytes(OneProcessMemory));
+
+	const double FrameMs = NumTicks > 0 ? TickSeconds * 1000.0 / NumTicks : 0.0;
+	const double BudgetMs = 1000.0 / FMath::Max(ServerTickRate, 1.0f);
+	UE_LOG(LogUE5TopDownARPG, Log, TEXT("CPU: %.2f ms busy per frame for %d arenas, %.1f matches per core at %.0f Hz"),
+		FrameMs, Arenas.Num(), FrameMs > 0.0 ? Arenas.Num() * BudgetMs / FrameMs : 0.0, ServerTickRate);
+}
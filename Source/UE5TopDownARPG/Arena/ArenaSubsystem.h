@@ -0,0 +1,106 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineBaseTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ArenaSubsystem.generated.h"
+
+/**
+ * Hosts several independent arenas in one server world. Each arena is an instance of the arena map
+ * placed ARPG.Arena.Spacing apart along X, so arenas share every loaded asset but no actors. An actor
+ * belongs to the arena it stands in, players are assigned an arena when they join, and replicated
+ * actors are only relevant to the players of their own arena. Each arena ends and restarts on its own.
+ *
+ * Enabled with -ARPGArenas=<count> on the server. -ARPGArenaMap=<long package name> instances that map
+ * for every arena; without it the persistent level is arena 0 and the others are instances of it.
+ */
+UCLASS()
+class UE5TOPDOWNARPG_API UArenaSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+	static UArenaSubsystem* Get(const UObject* WorldContextObject);
+
+	/** Whether Actor may replicate to the connection of RealViewer. Always true with a single arena. */
+	static bool IsNetRelevantFor(const AActor* Actor, const AActor* RealViewer, const AActor* ViewTarget);
+
+	int32 GetNumArenas() const { return Arenas.Num(); }
+
+	/** Arena containing Location, INDEX_NONE outside every arena. */
+	int32 GetArenaId(const FVector& Location) const;
+
+	/** Arena a controller was assigned, or the arena its actor stands in. */
+	int32 GetArenaId(const AActor* Actor) const;
+
+	FVector GetArenaOrigin(int32 ArenaId) const;
+
+	/** Assigns a joining player to the arena with the fewest players and returns it. */
+	int32 AssignPlayer(AController* Player);
+	void RemovePlayer(AController* Player);
+
+	/**
+	 * Records the result of the arena's match and schedules the arena to restart. With a single arena only the
+	 * result is recorded and the game plays on as without arenas.
+	 */
+	void EndArena(int32 ArenaId, bool bIsWin);
+
+	/** Client side: loads the instance of the arena the server assigned this client. */
+	void LoadClientArena(const FString& MapName, const FString& InstanceName, const FVector& Origin);
+
+	/** Logs players and matches per arena, memory per match and estimated matches per core. */
+	void LogReport(float ServerTickRate) const;
+
+private:
+	struct FArena
+	{
+		/** Unique package name of the current instance, empty for the persistent level, which resets in place. */
+		FString InstanceName;
+		TArray<TWeakObjectPtr<AController>> Players;
+		int32 NumMatches = 0;
+		int32 NumWins = 0;
+		double MatchStartTime = 0.0;
+		bool bEnded = false;
+		/** Players respawn once the reloaded instance is visible, so they find its player starts. */
+		bool bRestartPending = false;
+		FTimerHandle RestartTimerHandle;
+	};
+
+	void LoadArena(int32 ArenaId);
+	void RestartArena(int32 ArenaId);
+	void RestartPlayers(int32 ArenaId);
+	void SendArenaToClient(int32 ArenaId, AController* Player) const;
+
+	UFUNCTION()
+	void OnArenaLevelShown();
+
+	void OnWorldTickStart(UWorld* TickedWorld, ELevelTick TickType, float DeltaTime);
+
+	TArray<FArena> Arenas;
+
+	UPROPERTY(Transient)
+	TArray<class ULevelStreamingDynamic*> ArenaLevels;
+
+	TMap<TObjectKey<AController>, int32> PlayerArenas;
+
+	FString ArenaMapName;
+	bool bPersistentLevelIsArena = false;
+	float Spacing = 0.0f;
+
+	/** Physical memory in use before the arena instances were loaded. */
+	uint64 BaselineMemory = 0;
+
+	FDelegateHandle TickStartHandle;
+	double TickSeconds = 0.0;
+	uint64 NumTicks = 0;
+
+	/** Client side instance of the assigned arena. */
+	UPROPERTY(Transient)
+	class ULevelStreamingDynamic* ClientArenaLevel = nullptr;
+};
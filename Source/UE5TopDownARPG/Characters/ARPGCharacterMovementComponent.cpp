@@ -0,0 +1,224 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ARPGCharacterMovementComponent.h"
+#include "BaseCharacter.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "Net/UnrealNetwork.h"
+#include "TimerManager.h"
+#include "../AI/CrowdAvoidanceSubsystem.h"
+#include "../AI/CrowdBenchmark.h"
+#include "../UE5TopDownARPG.h"
+
+DECLARE_CYCLE_STAT(TEXT("ARPG Character Movement"), STAT_ARPGCharacterMovement, STATGROUP_ARPG);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("AI Nav Walking"), STAT_AINavWalking, STATGROUP_ARPG);
+
+uint64 UARPGCharacterMovementComponent::TotalTickCycles = 0;
+uint64 UARPGCharacterMovementComponent::TotalDepenetrations = 0;
+uint64 UARPGCharacterMovementComponent::TotalPawnImpacts = 0;
+
+namespace
+{
+	bool bAINavWalkingEnabled = true;
+	FAutoConsoleVariableRef CVarAINavWalking(
+		TEXT("ARPG.AI.NavWalking"),
+		bAINavWalkingEnabled,
+		TEXT("Lets AI characters away from players move in nav walking."));
+
+	FCrowdBenchmarkPhase MakeAIMovementPhase(bool bNavWalking)
+	{
+		TSharedRef<uint64> StartCycles = MakeShared<uint64>(0);
+
+		FCrowdBenchmarkPhase Phase;
+		Phase.Begin = [StartCycles, bNavWalking]()
+		{
+			bAINavWalkingEnabled = bNavWalking;
+			*StartCycles = UARPGCharacterMovementComponent::GetTotalTickCycles();
+		};
+		Phase.End = [StartCycles, bNavWalking](UWorld* World, int32 NumCharacters, double NumFrames)
+		{
+			UE_LOG(LogUE5TopDownARPG, Log, TEXT("AI movement for %d characters, %s: %.3f ms/frame"),
+				NumCharacters, bNavWalking ? TEXT("nav walking") : TEXT("walking"),
+				FPlatformTime::ToMilliseconds64(UARPGCharacterMovementComponent::GetTotalTickCycles() - *StartCycles) / NumFrames);
+		};
+		return Phase;
+	}
+
+	void RunAIMovementBenchmark(const TArray<FString>& Args, UWorld* World)
+	{
+		FCrowdBenchmarkSettings Settings;
+		Settings.Name = TEXT("ARPG.Bench.AIMovement");
+		CrowdBenchmark::ParseArgs(Args, Settings);
+
+		const bool bOriginalNavWalking = bAINavWalkingEnabled;
+		Settings.Finish = [bOriginalNavWalking]()
+		{
+			bAINavWalkingEnabled = bOriginalNavWalking;
+		};
+
+		// First phase measures full walking, the second nav walking, for the same crowd.
+		CrowdBenchmark::Run(World, MoveTemp(Settings), { MakeAIMovementPhase(false), MakeAIMovementPhase(true) });
+	}
+
+	FAutoConsoleCommandWithWorldAndArgs AIMovementBenchmarkCommand(
+		TEXT("ARPG.Bench.AIMovement"),
+		TEXT("Spawns chasing AI and compares character movement time with and without nav walking. Args: [NumCharacters=300] [PhaseSeconds=5]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&RunAIMovementBenchmark));
+}
+
+UARPGCharacterMovementComponent::UARPGCharacterMovementComponent()
+{
+	// The arena is flat, following the navmesh polygons is close enough without tracing the geometry.
+	bProjectNavMeshWalking = false;
+	NavAgentProps.bCanWalk = true;
+	SetIsReplicatedByDefault(true);
+}
+
+void UARPGCharacterMovementComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	// Simulated proxies follow the replicated movement, only the autonomous proxy runs its own moves.
+	DOREPLIFETIME_CONDITION(UARPGCharacterMovementComponent, SpeedMultiplier, COND_AutonomousOnly);
+}
+
+void UARPGCharacterMovementComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (GetOwner()->HasAuthority())
+	{
+		if (UCrowdAvoidanceSubsystem* CrowdAvoidanceSubsystem = GetWorld()->GetSubsystem<UCrowdAvoidanceSubsystem>())
+		{
+			CrowdAvoidanceSubsystem->RegisterAgent(this);
+		}
+	}
+
+	if (bUseNavWalkingForAI && GetOwner()->HasAuthority())
+	{
+		// Spread the evaluations of a freshly spawned wave over the interval.
+		GetWorld()->GetTimerManager().SetTimer(EvaluateTimerHandle, this, &UARPGCharacterMovementComponent::EvaluateMovementMode,
+			EvaluateInterval, true, FMath::FRandRange(0.0f, EvaluateInterval));
+	}
+}
+
+void UARPGCharacterMovementComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	GetWorld()->GetTimerManager().ClearTimer(EvaluateTimerHandle);
+	if (UCrowdAvoidanceSubsystem* CrowdAvoidanceSubsystem = GetWorld()->GetSubsystem<UCrowdAvoidanceSubsystem>())
+	{
+		CrowdAvoidanceSubsystem->UnregisterAgent(this);
+	}
+	if (MovementMode == MOVE_NavWalking)
+	{
+		DEC_DWORD_STAT(STAT_AINavWalking);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UARPGCharacterMovementComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ARPGCharacterMovement);
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+	TotalTickCycles += FPlatformTime::Cycles64() - StartCycles;
+}
+
+float UARPGCharacterMovementComponent::GetMaxSpeed() const
+{
+	return Super::GetMaxSpeed() * SpeedMultiplier;
+}
+
+void UARPGCharacterMovementComponent::RequestDirectMove(const FVector& MoveVelocity, bool bForceMaxSpeed)
+{
+	FVector AvoidingVelocity = MoveVelocity;
+	if (CrowdAgentIndex != INDEX_NONE && PawnOwner != nullptr && PawnOwner->IsPlayerControlled() == false)
+	{
+		// Players steer themselves, AI path following bends around the crowd.
+		if (UCrowdAvoidanceSubsystem* CrowdAvoidanceSubsystem = GetWorld()->GetSubsystem<UCrowdAvoidanceSubsystem>())
+		{
+			AvoidingVelocity = (MoveVelocity + CrowdAvoidanceSubsystem->GetAvoidanceOffset(this)).GetClampedToMaxSize(FMath::Max(MoveVelocity.Size(), GetMaxSpeed()));
+		}
+	}
+
+	Super::RequestDirectMove(AvoidingVelocity, bForceMaxSpeed);
+}
+
+void UARPGCharacterMovementComponent::HandleImpact(const FHitResult& Hit, float TimeSlice, const FVector& MoveDelta)
+{
+	if (Cast<APawn>(Hit.GetActor()) != nullptr)
+	{
+		TotalPawnImpacts++;
+	}
+
+	Super::HandleImpact(Hit, TimeSlice, MoveDelta);
+}
+
+void UARPGCharacterMovementComponent::OnMovementModeChanged(EMovementMode PreviousMovementMode, uint8 PreviousCustomMode)
+{
+	Super::OnMovementModeChanged(PreviousMovementMode, PreviousCustomMode);
+
+	// Counted here so knockback, falling and EvaluateMovementMode each enter and leave nav walking once.
+	if (MovementMode == MOVE_NavWalking && PreviousMovementMode != MOVE_NavWalking)
+	{
+		INC_DWORD_STAT(STAT_AINavWalking);
+	}
+	else if (MovementMode != MOVE_NavWalking && PreviousMovementMode == MOVE_NavWalking)
+	{
+		DEC_DWORD_STAT(STAT_AINavWalking);
+	}
+}
+
+bool UARPGCharacterMovementComponent::ResolvePenetrationImpl(const FVector& Adjustment, const FHitResult& Hit, const FQuat& NewRotation)
+{
+	TotalDepenetrations++;
+	return Super::ResolvePenetrationImpl(Adjustment, Hit, NewRotation);
+}
+
+float UARPGCharacterMovementComponent::GetAvoidanceRadius() const
+{
+	return CharacterOwner != nullptr ? CharacterOwner->GetCapsuleComponent()->GetScaledCapsuleRadius() : 0.0f;
+}
+
+void UARPGCharacterMovementComponent::ApplyKnockback(const FVector& Impulse)
+{
+	KnockbackEndTime = GetWorld()->GetTimeSeconds() + KnockbackDuration;
+	if (MovementMode == MOVE_NavWalking)
+	{
+		SetMovementMode(MOVE_Walking);
+	}
+	AddImpulse(Impulse, true);
+}
+
+void UARPGCharacterMovementComponent::EvaluateMovementMode()
+{
+	// Leave falling, flying and custom modes alone.
+	if (PawnOwner == nullptr || PawnOwner->IsPlayerControlled() || (MovementMode != MOVE_Walking && MovementMode != MOVE_NavWalking))
+	{
+		return;
+	}
+
+	bool bNeedsFullWalking = bAINavWalkingEnabled == false || GetWorld()->GetTimeSeconds() < KnockbackEndTime;
+
+	const FVector Location = PawnOwner->GetActorLocation();
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It && bNeedsFullWalking == false; ++It)
+	{
+		APlayerController* PlayerController = It->Get();
+		APawn* PlayerPawn = PlayerController ? PlayerController->GetPawn() : nullptr;
+		if (PlayerPawn != nullptr && FVector::DistSquared(Location, PlayerPawn->GetActorLocation()) < FMath::Square(FullWalkingDistance))
+		{
+			bNeedsFullWalking = true;
+		}
+	}
+
+	const EMovementMode DesiredMode = bNeedsFullWalking ? MOVE_Walking : MOVE_NavWalking;
+	if (MovementMode != DesiredMode)
+	{
+		SetMovementMode(DesiredMode);
+	}
+}
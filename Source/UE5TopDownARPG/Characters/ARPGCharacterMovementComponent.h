@@ -0,0 +1,77 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "ARPGCharacterMovementComponent.generated.h"
+
+/**
+ * Moves AI characters in nav walking while they are away from players, which follows the
+ * navmesh instead of sweeping for a floor every frame. Full walking returns near players
+ * and during knockback, where collision against the level matters.
+ */
+UCLASS()
+class UE5TOPDOWNARPG_API UARPGCharacterMovementComponent : public UCharacterMovementComponent
+{
+	GENERATED_BODY()
+
+public:
+	UARPGCharacterMovementComponent();
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+	virtual void RequestDirectMove(const FVector& MoveVelocity, bool bForceMaxSpeed) override;
+	virtual void HandleImpact(const FHitResult& Hit, float TimeSlice = 0.0f, const FVector& MoveDelta = FVector::ZeroVector) override;
+	virtual float GetMaxSpeed() const override;
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	/** Pushes the character and keeps it in full walking until the push settles. */
+	void ApplyKnockback(const FVector& Impulse);
+
+	/** Movement time accumulated by every instance, for benchmarks. */
+	static uint64 GetTotalTickCycles() { return TotalTickCycles; }
+
+	/** Collisions resolved by every instance, for benchmarks. */
+	static uint64 GetTotalDepenetrations() { return TotalDepenetrations; }
+	static uint64 GetTotalPawnImpacts() { return TotalPawnImpacts; }
+
+	float GetAvoidanceRadius() const;
+
+	/** Scales max speed, set on the server by slowing status effects and replicated so the owning client predicts it. */
+	void SetSpeedMultiplier(float InSpeedMultiplier) { SpeedMultiplier = InSpeedMultiplier; }
+
+protected:
+	virtual void OnMovementModeChanged(EMovementMode PreviousMovementMode, uint8 PreviousCustomMode) override;
+	virtual bool ResolvePenetrationImpl(const FVector& Adjustment, const FHitResult& Hit, const FQuat& NewRotation) override;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Character Movement: Nav Walking")
+	bool bUseNavWalkingForAI = true;
+
+	/** AI closer than this to a player pawn uses full walking. */
+	UPROPERTY(EditDefaultsOnly, Category = "Character Movement: Nav Walking")
+	float FullWalkingDistance = 600.0f;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Character Movement: Nav Walking")
+	float KnockbackDuration = 0.5f;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Character Movement: Nav Walking")
+	float EvaluateInterval = 0.25f;
+
+private:
+	void EvaluateMovementMode();
+
+	FTimerHandle EvaluateTimerHandle;
+	float KnockbackEndTime = 0.0f;
+
+	UPROPERTY(Replicated)
+	float SpeedMultiplier = 1.0f;
+
+	friend class UCrowdAvoidanceSubsystem;
+	int32 CrowdAgentIndex = INDEX_NONE;
+
+	static uint64 TotalTickCycles;
+	static uint64 TotalDepenetrations;
+	static uint64 TotalPawnImpacts;
+};
@@ -0,0 +1,268 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BaseCharacter.h"
+#include "Components/CapsuleComponent.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+#include "SkeletalMeshComponentBudgeted.h"
+#include "../Abilities/AbilityComponent.h"
+#include "../Arena/ArenaSubsystem.h"
+#include "ARPGCharacterMovementComponent.h"
+#include "DespawnSubsystem.h"
+#include "../Combat/LagCompensationSubsystem.h"
+#include "../Pickups/PickupSubsystem.h"
+#include "../Messages/GameplayMessageSubsystem.h"
+#include "../Net/NetPolicyComponent.h"
+#include "../Persistence/CheckpointSubsystem.h"
+#include "../Replay/GameplayRecorderSubsystem.h"
+#include "../Telemetry/GameplayMetrics.h"
+#include "../UE5TopDownARPGGameMode.h"
+#include "../UE5TopDownARPG.h"
+#include "Net/UnrealNetwork.h"
+
+namespace
+{
+	void DumpCharacterFootprint(UWorld* World)
+	{
+		struct FFootprint
+		{
+			int32 NumActors = 0;
+			int32 NumComponents = 0;
+			int64 Bytes = 0;
+		};
+
+		TMap<UClass*, FFootprint> Footprints;
+		for (TActorIterator<ABaseCharacter> It(World); It; ++It)
+		{
+			FFootprint& Footprint = Footprints.FindOrAdd(It->GetClass());
+			Footprint.NumActors++;
+			Footprint.Bytes += It->GetClass()->GetStructureSize() + It->GetResourceSizeBytes(EResourceSizeMode::Exclusive);
+
+			for (UActorComponent* Component : It->GetComponents())
+			{
+				Footprint.NumComponents++;
+				Footprint.Bytes += Component->GetClass()->GetStructureSize() + Component->GetResourceSizeBytes(EResourceSizeMode::Exclusive);
+			}
+		}
+
+		for (const TPair<UClass*, FFootprint>& Pair : Footprints)
+		{
+			const FFootprint& Footprint = Pair.Value;
+			UE_LOG(LogUE5TopDownARPG, Log, TEXT("%s: %d actors, %.1f components/actor, %.1f KB/actor"),
+				*Pair.Key->GetName(),
+				Footprint.NumActors,
+				float(Footprint.NumComponents) / Footprint.NumActors,
+				float(Footprint.Bytes) / Footprint.NumActors / 1024.0f);
+		}
+	}
+
+	FAutoConsoleCommandWithWorld DumpCharacterFootprintCommand(
+		TEXT("ARPG.DumpCharacterFootprint"),
+		TEXT("Logs component count and memory per character class."),
+		FConsoleCommandWithWorldDelegate::CreateStatic(&DumpCharacterFootprint));
+}
+
+ABaseCharacter::ABaseCharacter(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer
+		.SetDefaultSubobjectClass<USkeletalMeshComponentBudgeted>(ACharacter::MeshComponentName)
+		.SetDefaultSubobjectClass<UARPGCharacterMovementComponent>(ACharacter::CharacterMovementComponentName))
+{
+	// Set size for player capsule
+	GetCapsuleComponent()->InitCapsuleSize(42.f, 96.0f);
+	GetCapsuleComponent()->SetCollisionProfileName(ARPGCollisionProfiles::Hurtbox);
+
+	// Don't rotate character to camera direction
+	bUseControllerRotationPitch = false;
+	bUseControllerRotationYaw = false;
+	bUseControllerRotationRoll = false;
+
+	// Configure character movement
+	GetCharacterMovement()->bOrientRotationToMovement = true; // Rotate character to moving direction
+	GetCharacterMovement()->RotationRate = FRotator(0.f, 640.f, 0.f);
+	GetCharacterMovement()->bConstrainToPlane = true;
+	GetCharacterMovement()->bSnapToPlaneAtStart = true;
+
+	// Let the animation budget allocator throttle distant characters.
+	if (USkeletalMeshComponentBudgeted* BudgetedMesh = Cast<USkeletalMeshComponentBudgeted>(GetMesh()))
+	{
+		BudgetedMesh->SetAutoCalculateSignificance(true);
+	}
+
+	// Replicate idle enemies far from players less often.
+	NetPolicyComponent = CreateDefaultSubobject<UNetPolicyComponent>(TEXT("NetPolicyComponent"));
+	NetPolicyComponent->Policy = ENetPolicy::Proximity;
+
+	AbilityComponent = CreateDefaultSubobject<UAbilityComponent>(TEXT("AbilityComponent"));
+
+	// Combat characters have nothing to do per frame.
+	PrimaryActorTick.bCanEverTick = false;
+
+	OnTakeAnyDamage.AddDynamic(this, &ABaseCharacter::TakeAnyDamage);
+}
+
+void ABaseCharacter::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+
+	AbilityComponent->InsertAbilityClass(AbilityTemplate, 0);
+}
+
+void ABaseCharacter::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (HasAuthority())
+	{
+		if (ULagCompensationSubsystem* LagCompensationSubsystem = GetWorld()->GetSubsystem<ULagCompensationSubsystem>())
+		{
+			LagCompensationSubsystem->RegisterCharacter(this);
+		}
+
+		if (UCheckpointSubsystem* CheckpointSubsystem = UCheckpointSubsystem::Get(this))
+		{
+			CheckpointSubsystem->RegisterCharacter(this);
+		}
+	}
+}
+
+void ABaseCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (ULagCompensationSubsystem* LagCompensationSubsystem = GetWorld()->GetSubsystem<ULagCompensationSubsystem>())
+	{
+		LagCompensationSubsystem->UnregisterCharacter(this);
+	}
+
+	if (UCheckpointSubsystem* CheckpointSubsystem = UCheckpointSubsystem::Get(this))
+	{
+		CheckpointSubsystem->UnregisterCharacter(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ABaseCharacter::PossessedBy(AController* NewController)
+{
+	Super::PossessedBy(NewController);
+
+	// Spawned player pawns begin play before they are possessed, register again now they count as a player.
+	if (IsPlayerControlled())
+	{
+		if (UCheckpointSubsystem* CheckpointSubsystem = UCheckpointSubsystem::Get(this))
+		{
+			CheckpointSubsystem->RegisterCharacter(this);
+		}
+	}
+}
+
+void ABaseCharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(ABaseCharacter, Health);
+}
+
+bool ABaseCharacter::IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const
+{
+	return UArenaSubsystem::IsNetRelevantFor(this, RealViewer, ViewTarget) && Super::IsNetRelevantFor(RealViewer, ViewTarget, SrcLocation);
+}
+
+bool ABaseCharacter::ActivateAbility(FVector Location, int32 SlotIndex)
+{
+	if (AbilityComponent->ActivateAbility(SlotIndex, Location))
+	{
+		if (UGameplayRecorderSubsystem* Recorder = UGameplayRecorderSubsystem::Get(this))
+		{
+			Recorder->RecordAbilityActivation(this, Location);
+		}
+
+		NetPolicyComponent->NotifyActivity();
+		return true;
+	}
+	return false;
+}
+
+void ABaseCharacter::TakeAnyDamage(AActor* DamagedActor, float Damage, const UDamageType* DamageType, AController* InstigateBy, AActor* DamageCauser)
+{
+	if (bIsDead)
+	{
+		return;
+	}
+
+	Health -= Damage;
+	OnRep_SetHealth(Health + Damage);
+	NetPolicyComponent->NotifyActivity();
+
+	// Negative damage is healing.
+	if (Damage > 0.0f)
+	{
+		GameplayMetrics::Increment(EGameplayCounter::DamageDealt, FMath::RoundToInt64(Damage));
+		GameplayMetrics::Observe(EGameplayHistogram::DamagePerHit, Damage);
+	}
+
+	if (UCheckpointSubsystem* CheckpointSubsystem = UCheckpointSubsystem::Get(this))
+	{
+		CheckpointSubsystem->MarkDirty(this);
+	}
+	if (Health <= 0.0f)
+	{
+		UDespawnSubsystem* DespawnSubsystem = GetWorld()->GetSubsystem<UDespawnSubsystem>();
+		if (IsValid(DespawnSubsystem))
+		{
+			GameplayMetrics::Increment(EGameplayCounter::Deaths);
+			bIsDead = true;
+			DespawnSubsystem->QueueDeath(this, DeathDelay);
+		}
+	}
+}
+
+void ABaseCharacter::RestoreHealth(float NewHealth)
+{
+	const float OldHealth = Health;
+	Health = NewHealth;
+	OnRep_SetHealth(OldHealth);
+
+	if (UCheckpointSubsystem* CheckpointSubsystem = UCheckpointSubsystem::Get(this))
+	{
+		CheckpointSubsystem->MarkDirty(this);
+	}
+}
+
+void ABaseCharacter::OnRep_SetHealth(float OldHealth)
+{
+	if (UGameplayMessageSubsystem* MessageSubsystem = UGameplayMessageSubsystem::Get(this))
+	{
+		MessageSubsystem->PostHealthChanged(this, OldHealth, Health);
+	}
+}
+
+void ABaseCharacter::Death()
+{
+	if (UGameplayMessageSubsystem* MessageSubsystem = UGameplayMessageSubsystem::Get(this))
+	{
+		MessageSubsystem->PostDeath(this);
+	}
+
+	// Only a player's death loses, and only the match of the arena the player is in.
+	AUE5TopDownARPGGameMode* GameMode = Cast<AUE5TopDownARPGGameMode>(GetWorld()->GetAuthGameMode());
+	if (IsValid(GameMode) && IsPlayerControlled())
+	{
+		GameMode->EndGame(false, this);
+	}
+
+	// The actor lingers until the despawn queue destroys it; take it out of play now.
+	GetCharacterMovement()->DisableMovement();
+	SetActorEnableCollision(false);
+	SetActorHiddenInGame(true);
+}
+
+void ABaseCharacter::SpawnDeathLoot()
+{
+	UPickupSubsystem* PickupSubsystem = GetWorld()->GetSubsystem<UPickupSubsystem>();
+	if (IsValid(PickupSubsystem))
+	{
+		PickupSubsystem->DropLoot(LootTable, GetActorLocation());
+	}
+}
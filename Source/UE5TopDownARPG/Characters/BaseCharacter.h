@@ -0,0 +1,87 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Character.h"
+#include "../AI/EnemyStateMachine.h"
+#include "BaseCharacter.generated.h"
+
+/**
+ * Lean combat character shared by players and AI: health, ability and death.
+ * Player-only concerns (camera, cursor) live in AUE5TopDownARPGCharacter.
+ */
+UCLASS(Blueprintable)
+class UE5TOPDOWNARPG_API ABaseCharacter : public ACharacter
+{
+	GENERATED_BODY()
+
+public:
+	ABaseCharacter(const FObjectInitializer& ObjectInitializer);
+
+	virtual void PostInitializeComponents() override;
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void PossessedBy(AController* NewController) override;
+
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+	virtual bool IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const override;
+
+	FORCEINLINE class UBehaviorTree* GetBehaviorTree() const { return BehaviorTree; }
+	FORCEINLINE class UAbilityComponent* GetAbilityComponent() const { return AbilityComponent; }
+	EEnemyBrain GetBrain() const { return Brain; }
+	const FEnemyStateMachineSettings& GetStateMachineSettings() const { return StateMachineSettings; }
+
+	/** Overrides the class's brain on a character spawned deferred, before it is possessed. */
+	void SetBrain(EEnemyBrain InBrain) { Brain = InBrain; }
+
+	float GetHealth() const { return Health; }
+	bool IsDead() const { return bIsDead; }
+
+	/** Sets health directly, used when restoring a checkpoint. */
+	void RestoreHealth(float NewHealth);
+
+	bool ActivateAbility(FVector Location, int32 SlotIndex = 0);
+
+	// Death processing steps, run by UDespawnSubsystem.
+	void Death();
+	void SpawnDeathLoot();
+
+protected:
+	UPROPERTY(EditDefaultsOnly)
+	class UBehaviorTree* BehaviorTree;
+
+	/** How the AI controller runs this character. */
+	UPROPERTY(EditDefaultsOnly)
+	EEnemyBrain Brain = EEnemyBrain::BehaviorTree;
+
+	UPROPERTY(EditDefaultsOnly, meta = (EditCondition = "Brain == EEnemyBrain::StateMachine"))
+	FEnemyStateMachineSettings StateMachineSettings;
+
+	UPROPERTY(EditDefaultsOnly)
+	class UNetPolicyComponent* NetPolicyComponent;
+
+	UPROPERTY(EditDefaultsOnly)
+	class UAbilityComponent* AbilityComponent;
+
+	/** Primary ability, placed in slot 0 ahead of the ability component's own list. */
+	UPROPERTY(EditDefaultsOnly)
+	TSoftClassPtr<class UBaseAbility> AbilityTemplate;
+
+	UPROPERTY(ReplicatedUsing = OnRep_SetHealth, EditDefaultsOnly)
+	float Health = 100.0f;
+
+	UPROPERTY(EditDefaultsOnly)
+	float DeathDelay = 1.0f;
+
+	bool bIsDead = false;
+
+	UPROPERTY(EditDefaultsOnly)
+	class ULootTable* LootTable;
+
+	UFUNCTION()
+	void TakeAnyDamage(AActor* DamagedActor, float Damage, const class UDamageType* DamageType, class AController* InstigateBy, AActor* DamageCauser);
+
+	UFUNCTION()
+	void OnRep_SetHealth(float OldHealth);
+};
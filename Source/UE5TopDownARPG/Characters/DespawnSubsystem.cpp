@@ -0,0 +1,104 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "DespawnSubsystem.h"
+#include "BaseCharacter.h"
+#include "GameFramework/PlayerController.h"
+#include "Engine/World.h"
+#include "../Scheduling/GameplayWorkScheduler.h"
+#include "../UE5TopDownARPG.h"
+
+DECLARE_CYCLE_STAT(TEXT("Despawn Tick"), STAT_DespawnTick, STATGROUP_ARPG);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Deaths Queued"), STAT_DeathsQueued, STATGROUP_ARPG);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Deaths Processed"), STAT_DeathsProcessed, STATGROUP_ARPG);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Despawn Queue Length"), STAT_DespawnQueueLength, STATGROUP_ARPG);
+
+void UDespawnSubsystem::QueueDeath(ABaseCharacter* Character, float Delay)
+{
+	if (IsValid(Character) == false)
+	{
+		return;
+	}
+
+	Queue.Add({ Character, GetWorld()->GetTimeSeconds() + Delay });
+	INC_DWORD_STAT(STAT_DeathsQueued);
+}
+
+void UDespawnSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_DespawnTick);
+
+	const double Now = GetWorld()->GetTimeSeconds();
+	for (int32 Index = Queue.Num() - 1; Index >= 0; Index--)
+	{
+		if (Queue[Index].ReadyTime <= Now)
+		{
+			SubmitStage(Queue[Index].Character.Get(), EDeathStage::Death);
+			Queue.RemoveAtSwap(Index, 1, false);
+		}
+	}
+
+	SET_DWORD_STAT(STAT_DespawnQueueLength, Queue.Num() + NumInProgress);
+}
+
+TStatId UDespawnSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UDespawnSubsystem, STATGROUP_Tickables);
+}
+
+void UDespawnSubsystem::SubmitStage(ABaseCharacter* Character, EDeathStage Stage)
+{
+	UGameplayWorkScheduler* Scheduler = UGameplayWorkScheduler::Get(this);
+	if (IsValid(Scheduler) == false)
+	{
+		ProcessStage(Character, Stage);
+		return;
+	}
+
+	NumInProgress++;
+	TWeakObjectPtr<ABaseCharacter> WeakCharacter = Character;
+	Scheduler->Submit(EGameplayWorkPriority::Normal, this, [this, WeakCharacter, Stage]()
+	{
+		NumInProgress--;
+		ProcessStage(WeakCharacter, Stage);
+	});
+}
+
+void UDespawnSubsystem::ProcessStage(TWeakObjectPtr<ABaseCharacter> WeakCharacter, EDeathStage Stage)
+{
+	ABaseCharacter* Character = WeakCharacter.Get();
+	if (IsValid(Character) == false)
+	{
+		return;
+	}
+
+	switch (Stage)
+	{
+	case EDeathStage::Death:
+		Character->Death();
+		SubmitStage(Character, EDeathStage::SpawnLoot);
+		break;
+
+	case EDeathStage::SpawnLoot:
+		Character->SpawnDeathLoot();
+		SubmitStage(Character, EDeathStage::TeardownController);
+		break;
+
+	case EDeathStage::TeardownController:
+	{
+		AController* Controller = Character->GetController();
+		if (IsValid(Controller) && Controller->IsA<APlayerController>() == false)
+		{
+			Controller->UnPossess();
+			Controller->Destroy();
+		}
+		SubmitStage(Character, EDeathStage::Destroy);
+		break;
+	}
+
+	case EDeathStage::Destroy:
+		Character->Destroy();
+		INC_DWORD_STAT(STAT_DeathsProcessed);
+		break;
+	}
+}
@@ -0,0 +1,47 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "DespawnSubsystem.generated.h"
+
+/**
+ * Queues dead characters and hands their death processing (loot, controller teardown, destruction)
+ * to the gameplay work scheduler one step at a time, so wiping a whole wave does not land in a single frame.
+ */
+UCLASS()
+class UE5TOPDOWNARPG_API UDespawnSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	void QueueDeath(class ABaseCharacter* Character, float Delay);
+
+private:
+	enum class EDeathStage : uint8
+	{
+		Death,
+		SpawnLoot,
+		TeardownController,
+		Destroy
+	};
+
+	struct FDeathEntry
+	{
+		TWeakObjectPtr<class ABaseCharacter> Character;
+		double ReadyTime;
+	};
+
+	void SubmitStage(class ABaseCharacter* Character, EDeathStage Stage);
+	void ProcessStage(TWeakObjectPtr<class ABaseCharacter> WeakCharacter, EDeathStage Stage);
+
+	/** Deaths waiting for their delay to pass. */
+	TArray<FDeathEntry> Queue;
+
+	/** Deaths with a step in the scheduler. */
+	int32 NumInProgress = 0;
+};
@@ -0,0 +1,183 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LagCompensationSubsystem.h"
+#include "Algo/StableSort.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "../Characters/BaseCharacter.h"
+#include "../UE5TopDownARPG.h"
+
+DECLARE_CYCLE_STAT(TEXT("Lag Compensation Record"), STAT_LagCompensationRecord, STATGROUP_ARPG);
+DECLARE_CYCLE_STAT(TEXT("Lag Compensation Query"), STAT_LagCompensationQuery, STATGROUP_ARPG);
+
+namespace
+{
+	float MaxRewindMs = 250.0f;
+	FAutoConsoleVariableRef CVarMaxRewindMs(
+		TEXT("ARPG.LagCompensation.MaxRewindMs"),
+		MaxRewindMs,
+		TEXT("How far back the server rewinds characters to judge a client's projectile hits."));
+
+	void RunLagCompensationBenchmark(const TArray<FString>& Args)
+	{
+		const int32 NumPlayers = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 64;
+		const int32 NumQueries = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 100000;
+		if (NumPlayers <= 0 || NumQueries <= 0)
+		{
+			return;
+		}
+
+		const float FrameTime = 1.0f / 30.0f;
+		FRandomStream Stream(NumPlayers);
+
+		TArray<FPositionHistory> Histories;
+		Histories.SetNum(NumPlayers);
+		for (FPositionHistory& History : Histories)
+		{
+			FVector Location(Stream.FRandRange(-5000.0f, 5000.0f), Stream.FRandRange(-5000.0f, 5000.0f), 100.0f);
+			for (int32 Frame = 0; Frame < FPositionHistory::Capacity; Frame++)
+			{
+				Location += FVector(Stream.FRandRange(-20.0f, 20.0f), Stream.FRandRange(-20.0f, 20.0f), 0.0f);
+				History.Record(Frame * FrameTime, Location);
+			}
+		}
+
+		const float HistoryDuration = (FPositionHistory::Capacity - 1) * FrameTime;
+		const double StartTime = FPlatformTime::Seconds();
+		int32 NumSampled = 0;
+		for (int32 Query = 0; Query < NumQueries; Query++)
+		{
+			FVector Location;
+			NumSampled += Histories[Query % NumPlayers].Sample(Stream.FRandRange(0.0f, HistoryDuration), Location) ? 1 : 0;
+		}
+		const double DurationNs = (FPlatformTime::Seconds() - StartTime) * 1e9;
+
+		UE_LOG(LogUE5TopDownARPG, Log, TEXT("Lag compensation: %d players, %d bytes/character, %.1f KB total"),
+			NumPlayers, int32(sizeof(FPositionHistory)), float(NumPlayers * sizeof(FPositionHistory)) / 1024.0f);
+		UE_LOG(LogUE5TopDownARPG, Log, TEXT("Lag compensation: %d queries, %.1f ns/query"), NumSampled, DurationNs / NumQueries);
+	}
+
+	FAutoConsoleCommand LagCompensationBenchmarkCommand(
+		TEXT("ARPG.Bench.LagCompensation"),
+		TEXT("Measures position history memory and rewind query cost. Args: [NumPlayers=64] [NumQueries=100000]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&RunLagCompensationBenchmark));
+}
+
+void ULagCompensationSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_LagCompensationRecord);
+
+	const float Time = GetWorld()->GetTimeSeconds();
+	for (int32 Slot = 0; Slot < Tracked.Num(); Slot++)
+	{
+		const ABaseCharacter* Character = Tracked[Slot].Character.Get();
+		if (Character != nullptr)
+		{
+			Histories[Slot].Record(Time, Character->GetActorLocation());
+		}
+	}
+}
+
+TStatId ULagCompensationSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(ULagCompensationSubsystem, STATGROUP_Tickables);
+}
+
+void ULagCompensationSubsystem::RegisterCharacter(ABaseCharacter* Character)
+{
+	if (IsValid(Character) == false || SlotLookup.Contains(Character))
+	{
+		return;
+	}
+
+	const int32 Slot = FreeSlots.Num() > 0 ? FreeSlots.Pop(false) : Tracked.AddDefaulted();
+	if (Slot >= Histories.Num())
+	{
+		Histories.AddDefaulted();
+	}
+
+	const UCapsuleComponent* Capsule = Character->GetCapsuleComponent();
+	Tracked[Slot] = { Character, Capsule->GetScaledCapsuleRadius(), Capsule->GetScaledCapsuleHalfHeight() };
+	Histories[Slot].Reset();
+	Histories[Slot].Record(GetWorld()->GetTimeSeconds(), Character->GetActorLocation());
+	SlotLookup.Add(Character, Slot);
+}
+
+void ULagCompensationSubsystem::UnregisterCharacter(ABaseCharacter* Character)
+{
+	int32 Slot = INDEX_NONE;
+	if (SlotLookup.RemoveAndCopyValue(Character, Slot))
+	{
+		Tracked[Slot].Character.Reset();
+		FreeSlots.Add(Slot);
+	}
+}
+
+float ULagCompensationSubsystem::GetRewindTime(float ClientTimestamp) const
+{
+	const float Time = GetWorld()->GetTimeSeconds();
+	return FMath::Clamp(ClientTimestamp, Time - MaxRewindMs / 1000.0f, Time);
+}
+
+void ULagCompensationSubsystem::FindRewoundHits(const FVector& Start, const FVector& End, float HitRadius, float RewindTime, const AActor* IgnoredActor, TArray<FRewoundHit>& OutHits) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_LagCompensationQuery);
+
+	const float Time = GetWorld()->GetTimeSeconds();
+	const int32 FirstHit = OutHits.Num();
+	for (int32 Slot = 0; Slot < Tracked.Num(); Slot++)
+	{
+		const FTrackedCharacter& Character = Tracked[Slot];
+		ABaseCharacter* CharacterActor = Character.Character.Get();
+		if (CharacterActor == nullptr || CharacterActor == IgnoredActor || CharacterActor->GetActorEnableCollision() == false)
+		{
+			continue;
+		}
+
+		// Characters have moved since the last record this frame, so times past it interpolate toward where they are now.
+		FVector RewoundLocation;
+		if (Histories[Slot].SampleWithCurrent(RewindTime, Time, CharacterActor->GetActorLocation(), RewoundLocation) == false)
+		{
+			continue;
+		}
+
+		float HitTime = 0.0f;
+		if (SweepTouchesCapsule(Start, End, HitRadius, RewoundLocation, Character.CapsuleRadius, Character.CapsuleHalfHeight, HitTime))
+		{
+			OutHits.Add({ CharacterActor, HitTime });
+		}
+	}
+
+	// Stable, so characters reached at the same time stay in slot order.
+	Algo::StableSortBy(MakeArrayView(OutHits).Slice(FirstHit, OutHits.Num() - FirstHit), &FRewoundHit::Time);
+}
+
+bool ULagCompensationSubsystem::SweepTouchesCapsule(const FVector& Start, const FVector& End, float SphereRadius, const FVector& CapsuleCenter, float CapsuleRadius, float CapsuleHalfHeight, float& OutTime)
+{
+	const FVector ClosestPoint = FMath::ClosestPointOnSegment(CapsuleCenter, Start, End);
+	if (SphereTouchesCapsule(ClosestPoint, SphereRadius, CapsuleCenter, CapsuleRadius, CapsuleHalfHeight) == false)
+	{
+		return false;
+	}
+
+	// Entry into the combined radius in the horizontal plane, where upright capsules are round.
+	const FVector2D Offset(Start - CapsuleCenter);
+	const FVector2D Direction(End - Start);
+	const double A = Direction.SizeSquared();
+	const double B = Offset | Direction;
+	const double C = Offset.SizeSquared() - FMath::Square(double(SphereRadius + CapsuleRadius));
+	const double Discriminant = B * B - A * C;
+	OutTime = (C <= 0.0 || A <= UE_SMALL_NUMBER || Discriminant < 0.0) ? 0.0f : float(FMath::Clamp((-B - FMath::Sqrt(Discriminant)) / A, 0.0, 1.0));
+	return true;
+}
+
+bool ULagCompensationSubsystem::SphereTouchesCapsule(const FVector& SphereCenter, float SphereRadius, const FVector& CapsuleCenter, float CapsuleRadius, float CapsuleHalfHeight)
+{
+	// Capsules are upright, so the closest axis point only differs in height.
+	const float AxisHalfLength = FMath::Max(CapsuleHalfHeight - CapsuleRadius, 0.0f);
+	const FVector AxisPoint(CapsuleCenter.X, CapsuleCenter.Y,
+		FMath::Clamp(SphereCenter.Z, CapsuleCenter.Z - AxisHalfLength, CapsuleCenter.Z + AxisHalfLength));
+	return FVector::DistSquared(SphereCenter, AxisPoint) <= FMath::Square(SphereRadius + CapsuleRadius);
+}
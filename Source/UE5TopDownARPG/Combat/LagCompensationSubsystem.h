@@ -0,0 +1,56 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "PositionHistory.h"
+#include "LagCompensationSubsystem.generated.h"
+
+/**
+ * Records the position of every registered character each server frame and answers
+ * rewind queries, so hits can be judged against what the shooting client saw.
+ */
+UCLASS()
+class UE5TOPDOWNARPG_API ULagCompensationSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	void RegisterCharacter(class ABaseCharacter* Character);
+	void UnregisterCharacter(class ABaseCharacter* Character);
+
+	/** Server time to rewind to for a client timestamp, limited to ARPG.LagCompensation.MaxRewindMs. */
+	float GetRewindTime(float ClientTimestamp) const;
+
+	struct FRewoundHit
+	{
+		class ABaseCharacter* Character;
+		/** Fraction of the sweep at which the sphere reaches the capsule. */
+		float Time;
+	};
+
+	/** Characters whose rewound capsule is touched by a sphere swept from Start to End, earliest first. */
+	void FindRewoundHits(const FVector& Start, const FVector& End, float HitRadius, float RewindTime, const AActor* IgnoredActor, TArray<FRewoundHit>& OutHits) const;
+
+	static bool SphereTouchesCapsule(const FVector& SphereCenter, float SphereRadius, const FVector& CapsuleCenter, float CapsuleRadius, float CapsuleHalfHeight);
+
+	/** Whether a sphere swept from Start to End touches an upright capsule, and the fraction of the sweep where it first does. */
+	static bool SweepTouchesCapsule(const FVector& Start, const FVector& End, float SphereRadius, const FVector& CapsuleCenter, float CapsuleRadius, float CapsuleHalfHeight, float& OutTime);
+
+private:
+	struct FTrackedCharacter
+	{
+		TWeakObjectPtr<class ABaseCharacter> Character;
+		float CapsuleRadius;
+		float CapsuleHalfHeight;
+	};
+
+	TArray<FTrackedCharacter> Tracked;
+	TArray<FPositionHistory> Histories;
+	TArray<int32> FreeSlots;
+	TMap<TObjectKey<AActor>, int32> SlotLookup;
+};
@@ -0,0 +1,67 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "OverlapAccounting.h"
+#include "GameFramework/Actor.h"
+#include "HAL/IConsoleManager.h"
+#include "../UE5TopDownARPG.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Overlap Events"), STAT_OverlapEvents, STATGROUP_ARPG);
+
+namespace
+{
+	struct FOverlapPairStats
+	{
+		int64 Total = 0;
+		int32 CurrentFrameCount = 0;
+		int32 PeakPerFrame = 0;
+		uint64 CurrentFrame = 0;
+	};
+
+	TMap<TPair<FName, FName>, FOverlapPairStats> PairStats;
+	uint64 FirstFrame = 0;
+
+	void OverlapReport(const TArray<FString>& Args)
+	{
+		if (Args.Num() > 0 && Args[0] == TEXT("reset"))
+		{
+			PairStats.Reset();
+			FirstFrame = GFrameCounter;
+			return;
+		}
+
+		const uint64 NumFrames = FMath::Max<uint64>(GFrameCounter - FirstFrame, 1);
+		PairStats.ValueSort([](const FOverlapPairStats& A, const FOverlapPairStats& B) { return A.Total > B.Total; });
+
+		int64 Total = 0;
+		for (const TPair<TPair<FName, FName>, FOverlapPairStats>& Pair : PairStats)
+		{
+			const FOverlapPairStats& Stats = Pair.Value;
+			UE_LOG(LogUE5TopDownARPG, Log, TEXT("Overlaps %s -> %s: %lld total, %.2f/frame, peak %d/frame"),
+				*Pair.Key.Key.ToString(), *Pair.Key.Value.ToString(), Stats.Total, double(Stats.Total) / NumFrames, Stats.PeakPerFrame);
+			Total += Stats.Total;
+		}
+		UE_LOG(LogUE5TopDownARPG, Log, TEXT("Overlaps: %lld events over %llu frames, %.2f/frame"), Total, NumFrames, double(Total) / NumFrames);
+	}
+
+	FAutoConsoleCommand OverlapReportCommand(
+		TEXT("ARPG.OverlapReport"),
+		TEXT("Logs begin-overlap events per receiving and overlapping actor class. Pass reset to start a new measurement."),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&OverlapReport));
+}
+
+void OverlapAccounting::RecordOverlap(const AActor* Receiver, const AActor* Other)
+{
+	INC_DWORD_STAT(STAT_OverlapEvents);
+
+	const FName ReceiverClass = Receiver ? Receiver->GetClass()->GetFName() : NAME_None;
+	const FName OtherClass = Other ? Other->GetClass()->GetFName() : NAME_None;
+	FOverlapPairStats& Stats = PairStats.FindOrAdd(TPair<FName, FName>(ReceiverClass, OtherClass));
+	if (Stats.CurrentFrame != GFrameCounter)
+	{
+		Stats.CurrentFrame = GFrameCounter;
+		Stats.CurrentFrameCount = 0;
+	}
+	Stats.Total++;
+	Stats.PeakPerFrame = FMath::Max(Stats.PeakPerFrame, ++Stats.CurrentFrameCount);
+}
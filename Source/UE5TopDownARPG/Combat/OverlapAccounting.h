@@ -0,0 +1,14 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Counts the begin-overlap events gameplay components receive, per pair of actor classes and per frame.
+ * Game thread only. ARPG.OverlapReport logs the counts, ARPG.OverlapReport reset clears them.
+ */
+namespace OverlapAccounting
+{
+	void RecordOverlap(const AActor* Receiver, const AActor* Other);
+}
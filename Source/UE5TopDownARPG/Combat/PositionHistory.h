@@ -0,0 +1,104 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/StaticArray.h"
+
+/**
+ * Fixed-size ring buffer of timestamped positions. Recording and querying never allocate.
+ */
+struct FPositionHistory
+{
+	/** Two seconds of history at a 30 Hz server tick. */
+	static constexpr int32 Capacity = 64;
+
+	struct FSample
+	{
+		float Time;
+		FVector3f Location;
+	};
+
+	void Reset()
+	{
+		Head = 0;
+		Num = 0;
+	}
+
+	void Record(float Time, const FVector& Location)
+	{
+		Samples[Head] = { Time, FVector3f(Location) };
+		Head = (Head + 1) % Capacity;
+		Num = FMath::Min(Num + 1, Capacity);
+	}
+
+	/** Interpolated position at Time, clamped to the recorded range. */
+	bool Sample(float Time, FVector& OutLocation) const
+	{
+		if (Num == 0)
+		{
+			return false;
+		}
+
+		const FSample& Newest = GetByAge(0);
+		const FSample& Oldest = GetByAge(Num - 1);
+		if (Time >= Newest.Time)
+		{
+			OutLocation = FVector(Newest.Location);
+			return true;
+		}
+		if (Time <= Oldest.Time)
+		{
+			OutLocation = FVector(Oldest.Location);
+			return true;
+		}
+
+		// Samples get older with age, find the youngest one at or before Time.
+		int32 Low = 1;
+		int32 High = Num - 1;
+		while (Low < High)
+		{
+			const int32 Middle = (Low + High) / 2;
+			if (GetByAge(Middle).Time <= Time)
+			{
+				High = Middle;
+			}
+			else
+			{
+				Low = Middle + 1;
+			}
+		}
+
+		const FSample& Older = GetByAge(Low);
+		const FSample& Newer = GetByAge(Low - 1);
+		const float Alpha = (Time - Older.Time) / FMath::Max(Newer.Time - Older.Time, KINDA_SMALL_NUMBER);
+		OutLocation = FVector(FMath::Lerp(Older.Location, Newer.Location, Alpha));
+		return true;
+	}
+
+	/**
+	 * Like Sample, but treats CurrentLocation as a sample at CurrentTime, so times after the newest
+	 * record interpolate toward where the character is now instead of clamping to the last frame.
+	 */
+	bool SampleWithCurrent(float Time, float CurrentTime, const FVector& CurrentLocation, FVector& OutLocation) const
+	{
+		if (Num > 0 && Time > GetByAge(0).Time && CurrentTime > GetByAge(0).Time)
+		{
+			const FSample& Newest = GetByAge(0);
+			const float Alpha = FMath::Min((Time - Newest.Time) / (CurrentTime - Newest.Time), 1.0f);
+			OutLocation = FMath::Lerp(FVector(Newest.Location), CurrentLocation, Alpha);
+			return true;
+		}
+		return Sample(Time, OutLocation);
+	}
+
+private:
+	const FSample& GetByAge(int32 Age) const
+	{
+		return Samples[(Head - 1 - Age + Capacity) % Capacity];
+	}
+
+	TStaticArray<FSample, Capacity> Samples;
+	int32 Head = 0;
+	int32 Num = 0;
+};
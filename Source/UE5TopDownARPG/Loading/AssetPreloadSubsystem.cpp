@@ -0,0 +1,191 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AssetPreloadSubsystem.h"
+#include "PreloadManifest.h"
+#include "Engine/AssetManager.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "../Memory/GarbageCollectionSubsystem.h"
+#include "../Startup/StartupProfiler.h"
+#include "../UE5TopDownARPG.h"
+
+namespace
+{
+	void LogPreloadReport(UWorld* World)
+	{
+		if (UAssetPreloadSubsystem* Subsystem = World ? World->GetSubsystem<UAssetPreloadSubsystem>() : nullptr)
+		{
+			Subsystem->LogReport();
+		}
+	}
+
+	FAutoConsoleCommandWithWorld PreloadReportCommand(
+		TEXT("ARPG.PreloadReport"),
+		TEXT("Logs async preload timings and first-use hitches caused by assets that were not preloaded."),
+		FConsoleCommandWithWorldDelegate::CreateStatic(&LogPreloadReport));
+}
+
+bool UAssetPreloadSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	UWorld* World = Cast<UWorld>(Outer);
+	return Super::ShouldCreateSubsystem(Outer) && IsValid(World) && World->IsGameWorld();
+}
+
+void UAssetPreloadSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	LoadManifests();
+}
+
+void UAssetPreloadSubsystem::Deinitialize()
+{
+	for (const TSharedPtr<FStreamableHandle>& Handle : ActiveHandles)
+	{
+		if (Handle.IsValid())
+		{
+			Handle->ReleaseHandle();
+		}
+	}
+	ActiveHandles.Reset();
+
+	Super::Deinitialize();
+}
+
+void UAssetPreloadSubsystem::LoadManifests()
+{
+	if (UAssetManager::IsValid() == false)
+	{
+		return;
+	}
+
+	UAssetManager& AssetManager = UAssetManager::Get();
+
+	TArray<FPrimaryAssetId> ManifestIds;
+	AssetManager.GetPrimaryAssetIdList(UPreloadManifest::PrimaryAssetType, ManifestIds);
+	if (ManifestIds.Num() == 0)
+	{
+		return;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	TSharedPtr<FStreamableHandle> Handle = AssetManager.LoadPrimaryAssets(ManifestIds, MapLoadBundles,
+		FStreamableDelegate::CreateUObject(this, &UAssetPreloadSubsystem::OnPreloadCompleted, FName(TEXT("MapLoad")), StartTime, ManifestIds.Num()));
+	TrackHandle(Handle);
+}
+
+void UAssetPreloadSubsystem::RequestPreload(const TArray<FSoftObjectPath>& AssetPaths, FName Context, FStreamableDelegate OnLoaded)
+{
+	TArray<FSoftObjectPath> PathsToLoad;
+	for (const FSoftObjectPath& AssetPath : AssetPaths)
+	{
+		if (AssetPath.IsNull() == false && AssetPath.ResolveObject() == nullptr)
+		{
+			PathsToLoad.AddUnique(AssetPath);
+		}
+	}
+
+	if (PathsToLoad.Num() == 0)
+	{
+		OnLoaded.ExecuteIfBound();
+		return;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	const int32 NumAssets = PathsToLoad.Num();
+	TSharedPtr<FStreamableHandle> Handle = UAssetManager::GetStreamableManager().RequestAsyncLoad(PathsToLoad,
+		FStreamableDelegate::CreateWeakLambda(this, [this, Context, StartTime, NumAssets, OnLoaded]()
+		{
+			OnPreloadCompleted(Context, StartTime, NumAssets);
+			OnLoaded.ExecuteIfBound();
+		}));
+	TrackHandle(Handle);
+}
+
+bool UAssetPreloadSubsystem::IsPreloading() const
+{
+	return ActiveHandles.ContainsByPredicate([](const TSharedPtr<FStreamableHandle>& Handle)
+	{
+		return Handle.IsValid() && Handle->IsLoadingInProgress();
+	});
+}
+
+UClass* UAssetPreloadSubsystem::ResolveClass(const FSoftObjectPath& ClassPath)
+{
+	const double StartTime = FPlatformTime::Seconds();
+	UClass* LoadedClass = Cast<UClass>(UAssetManager::GetStreamableManager().LoadSynchronous(ClassPath));
+	const double DurationMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+	Hitches.Add({ ClassPath, DurationMs });
+	UE_LOG(LogUE5TopDownARPG, Warning, TEXT("%s was not preloaded, first use hitched for %.2f ms"), *ClassPath.ToString(), DurationMs);
+
+	return LoadedClass;
+}
+
+void UAssetPreloadSubsystem::OnPreloadCompleted(FName Context, double StartTime, int32 NumAssets)
+{
+	const double DurationMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+	PreloadTimings.Add({ Context, NumAssets, DurationMs });
+	UE_LOG(LogUE5TopDownARPG, Log, TEXT("Preload %s: %d assets in %.2f ms"), *Context.ToString(), NumAssets, DurationMs);
+
+	ReleaseCompletedHandles();
+
+	if (UGarbageCollectionSubsystem* GarbageCollectionSubsystem = UGarbageCollectionSubsystem::Get())
+	{
+		GarbageCollectionSubsystem->ClusterResidentAssets();
+	}
+}
+
+void UAssetPreloadSubsystem::TrackHandle(TSharedPtr<FStreamableHandle> Handle)
+{
+	if (Handle.IsValid() == false)
+	{
+		return;
+	}
+
+	// While the server starts, the AI asset load phase runs from the first preload until the last one finished,
+	// in both boot modes, see UStartupSubsystem::TickStartup.
+	if (StartupProfiler::IsPhaseOpen(EStartupPhase::AIAssetLoad) == false)
+	{
+		StartupProfiler::BeginPhase(EStartupPhase::AIAssetLoad);
+	}
+	ActiveHandles.Add(Handle);
+}
+
+void UAssetPreloadSubsystem::ReleaseCompletedHandles()
+{
+	for (int32 Index = ActiveHandles.Num() - 1; Index >= 0; Index--)
+	{
+		const TSharedPtr<FStreamableHandle>& Handle = ActiveHandles[Index];
+		if (Handle.IsValid() && Handle->IsLoadingInProgress())
+		{
+			continue;
+		}
+
+		if (Handle.IsValid())
+		{
+			TArray<UObject*> LoadedAssets;
+			Handle->GetLoadedAssets(LoadedAssets);
+			for (UObject* LoadedAsset : LoadedAssets)
+			{
+				PreloadedAssets.AddUnique(LoadedAsset);
+			}
+			Handle->ReleaseHandle();
+		}
+		ActiveHandles.RemoveAtSwap(Index, 1, false);
+	}
+}
+
+void UAssetPreloadSubsystem::LogReport() const
+{
+	for (const FPreloadTiming& Timing : PreloadTimings)
+	{
+		UE_LOG(LogUE5TopDownARPG, Log, TEXT("Preload %s: %d assets in %.2f ms"), *Timing.Context.ToString(), Timing.NumAssets, Timing.DurationMs);
+	}
+
+	for (const FHitchRecord& Hitch : Hitches)
+	{
+		UE_LOG(LogUE5TopDownARPG, Log, TEXT("First-use hitch %s: %.2f ms"), *Hitch.AssetPath.ToString(), Hitch.DurationMs);
+	}
+}
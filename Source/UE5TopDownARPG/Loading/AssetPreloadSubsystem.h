@@ -0,0 +1,88 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Engine/World.h"
+#include "Engine/StreamableManager.h"
+#include "AssetPreloadSubsystem.generated.h"
+
+/**
+ * Streams gameplay classes in asynchronously so the first bolt or wave does not hitch.
+ * Loads the preload manifest bundles when the map starts and accepts ad-hoc requests,
+ * e.g. from ASpawnTrigger during its InitialDelay.
+ */
+UCLASS(config = Game)
+class UE5TOPDOWNARPG_API UAssetPreloadSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	void RequestPreload(const TArray<FSoftObjectPath>& AssetPaths, FName Context, FStreamableDelegate OnLoaded = FStreamableDelegate());
+
+	/** Whether any preload is still streaming. */
+	bool IsPreloading() const;
+
+	/** Returns the class, loading it synchronously (and recording the hitch) if it was not preloaded. */
+	UClass* ResolveClass(const FSoftObjectPath& ClassPath);
+
+	template<typename T>
+	static TSubclassOf<T> Resolve(const UObject* WorldContextObject, const TSoftClassPtr<T>& SoftClass)
+	{
+		if (SoftClass.IsNull())
+		{
+			return nullptr;
+		}
+
+		if (UClass* LoadedClass = SoftClass.Get())
+		{
+			return LoadedClass;
+		}
+
+		UWorld* World = IsValid(WorldContextObject) ? WorldContextObject->GetWorld() : nullptr;
+		UAssetPreloadSubsystem* Subsystem = World ? World->GetSubsystem<UAssetPreloadSubsystem>() : nullptr;
+		if (Subsystem == nullptr)
+		{
+			return SoftClass.LoadSynchronous();
+		}
+		return Subsystem->ResolveClass(SoftClass.ToSoftObjectPath());
+	}
+
+	void LogReport() const;
+
+private:
+	void LoadManifests();
+	void OnPreloadCompleted(FName Context, double StartTime, int32 NumAssets);
+	void ReleaseCompletedHandles();
+	void TrackHandle(TSharedPtr<FStreamableHandle> Handle);
+
+	/** Bundles of the preload manifests that are streamed in as soon as the map starts. */
+	UPROPERTY(Config)
+	TArray<FName> MapLoadBundles;
+
+	struct FPreloadTiming
+	{
+		FName Context;
+		int32 NumAssets;
+		double DurationMs;
+	};
+
+	struct FHitchRecord
+	{
+		FSoftObjectPath AssetPath;
+		double DurationMs;
+	};
+
+	/** Assets of finished preloads, kept loaded for the rest of the map once their handle is released. */
+	UPROPERTY(Transient)
+	TArray<UObject*> PreloadedAssets;
+
+	TArray<FPreloadTiming> PreloadTimings;
+	TArray<FHitchRecord> Hitches;
+	TArray<TSharedPtr<FStreamableHandle>> ActiveHandles;
+};
@@ -0,0 +1,15 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PreloadManifest.h"
+#include "../Abilities/BaseAbility.h"
+#include "../Projectiles/Projectile.h"
+#include "../Characters/BaseCharacter.h"
+#include "../Pickups/LootTable.h"
+
+const FPrimaryAssetType UPreloadManifest::PrimaryAssetType = TEXT("PreloadManifest");
+
+FPrimaryAssetId UPreloadManifest::GetPrimaryAssetId() const
+{
+	return FPrimaryAssetId(PrimaryAssetType, GetFName());
+}
@@ -0,0 +1,35 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "PreloadManifest.generated.h"
+
+/**
+ * Lists the gameplay classes that should be streamed in before first use.
+ * Each list is tagged with an asset bundle so the asset manager can load them selectively.
+ */
+UCLASS()
+class UE5TOPDOWNARPG_API UPreloadManifest : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	static const FPrimaryAssetType PrimaryAssetType;
+
+	virtual FPrimaryAssetId GetPrimaryAssetId() const override;
+
+protected:
+	UPROPERTY(EditDefaultsOnly, meta = (AssetBundles = "Abilities"))
+	TArray<TSoftClassPtr<class UBaseAbility>> Abilities;
+
+	UPROPERTY(EditDefaultsOnly, meta = (AssetBundles = "Projectiles"))
+	TArray<TSoftClassPtr<class AProjectile>> Projectiles;
+
+	UPROPERTY(EditDefaultsOnly, meta = (AssetBundles = "Enemies"))
+	TArray<TSoftClassPtr<class ABaseCharacter>> Enemies;
+
+	UPROPERTY(EditDefaultsOnly, meta = (AssetBundles = "Loot"))
+	TArray<TSoftObjectPtr<class ULootTable>> LootTables;
+};
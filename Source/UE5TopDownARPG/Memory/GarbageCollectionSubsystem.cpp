@@ -0,0 +1,367 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GarbageCollectionSubsystem.h"
+#include "ResidentObjectCluster.h"
+#include "BehaviorTree/BehaviorTree.h"
+#include "BehaviorTree/BlackboardData.h"
+#include "Engine/DamageEvents.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
+#include "TimerManager.h"
+#include "UObject/GarbageCollection.h"
+#include "UObject/UObjectArray.h"
+#include "UObject/UObjectClusters.h"
+#include "UObject/UObjectIterator.h"
+#include "../AI/CrowdBenchmark.h"
+#include "../Abilities/BaseAbility.h"
+#include "../Characters/BaseCharacter.h"
+#include "../Loading/PreloadManifest.h"
+#include "../Pickups/LootTable.h"
+#include "../Pickups/PickupDefinition.h"
+#include "../Projectiles/ProjectilePoolSubsystem.h"
+#include "../Telemetry/GameplayMetrics.h"
+#include "../UE5TopDownARPG.h"
+
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("GC Incremental Purge ms"), STAT_GCPurgeMs, STATGROUP_ARPG);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("GC Resident Cluster Size"), STAT_GCResidentClusterSize, STATGROUP_ARPG);
+
+namespace
+{
+	float GCPurgeBudgetMs = 1.0f;
+	FAutoConsoleVariableRef CVarGCPurgeBudgetMs(
+		TEXT("ARPG.GC.PurgeBudgetMs"),
+		GCPurgeBudgetMs,
+		TEXT("Time per frame spent destroying objects left by a collection. 0 leaves purging to the engine."));
+
+	bool bClusterResidentAssets = true;
+	FAutoConsoleVariableRef CVarClusterResidentAssets(
+		TEXT("ARPG.GC.ClusterResidentAssets"),
+		bClusterResidentAssets,
+		TEXT("Puts loaded AI, ability, pickup and loot assets in one GC cluster. Cooked games only."));
+
+	bool CanJoinResidentCluster(UObject* Object)
+	{
+		if (IsValid(Object) == false || Object->HasAnyFlags(RF_NeedLoad | RF_NeedPostLoad) || Object->HasAnyInternalFlags(EInternalObjectFlags::Async))
+		{
+			return false;
+		}
+
+		// Objects already owned by a cluster, rooted or disregarded for GC gain nothing from another one.
+		const FUObjectItem* ObjectItem = GUObjectArray.ObjectToObjectItem(Object);
+		return Object->CanBeInCluster()
+			&& GUObjectArray.IsDisregardForGC(Object) == false
+			&& ObjectItem->GetOwnerIndex() == 0
+			&& ObjectItem->HasAnyFlags(EInternalObjectFlags::ClusterRoot) == false
+			&& Object->IsRooted() == false;
+	}
+
+	template<typename T>
+	void GatherResidentAssets(TArray<UObject*>& OutObjects)
+	{
+		for (TObjectIterator<T> It; It; ++It)
+		{
+			OutObjects.Add(*It);
+		}
+	}
+
+	void LogGCReport(const TArray<FString>& Args)
+	{
+		if (UGarbageCollectionSubsystem* Subsystem = UGarbageCollectionSubsystem::Get())
+		{
+			Subsystem->LogReport();
+			if (Args.Num() > 0 && Args[0] == TEXT("reset"))
+			{
+				Subsystem->ResetStats();
+			}
+		}
+	}
+
+	FAutoConsoleCommandWithArgs GCReportCommand(
+		TEXT("ARPG.GCReport"),
+		TEXT("Logs GC pause and purge percentiles, object counts and the resident cluster size. Args: [reset]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&LogGCReport));
+
+	struct FGCSoak
+	{
+		TArray<TPair<TWeakObjectPtr<ABaseCharacter>, double>> Enemies;
+		FTimerHandle TimerHandle;
+		TWeakObjectPtr<UClass> EnemyClass;
+		FVector Center = FVector::ZeroVector;
+		double EndTime = 0.0;
+		float EnemiesPerSecond = 4.0f;
+		float EnemyLifetime = 5.0f;
+		float SpawnDebt = 0.0f;
+		int32 NumSpawned = 0;
+	};
+
+	void FinishGCSoak(UWorld* World, FGCSoak& Soak)
+	{
+		World->GetTimerManager().ClearTimer(Soak.TimerHandle);
+		for (const TPair<TWeakObjectPtr<ABaseCharacter>, double>& Enemy : Soak.Enemies)
+		{
+			if (Enemy.Key.IsValid())
+			{
+				Enemy.Key->Destroy();
+			}
+		}
+
+		UE_LOG(LogUE5TopDownARPG, Log, TEXT("GC soak finished: %d enemies spawned"), Soak.NumSpawned);
+		if (UGarbageCollectionSubsystem* Subsystem = UGarbageCollectionSubsystem::Get())
+		{
+			Subsystem->LogReport();
+		}
+		if (UProjectilePoolSubsystem* Pool = UProjectilePoolSubsystem::Get(World))
+		{
+			Pool->LogReport();
+		}
+
+		if (FParse::Param(FCommandLine::Get(), TEXT("ARPGSoakExit")))
+		{
+			FPlatformMisc::RequestExit(false);
+		}
+	}
+
+	void TickGCSoak(UWorld* World, FGCSoak& Soak)
+	{
+		const double Now = World->GetTimeSeconds();
+		if (Now >= Soak.EndTime)
+		{
+			FinishGCSoak(World, Soak);
+			return;
+		}
+
+		// Old enemies die through the regular damage path, so death, loot and despawn churn objects as in a match.
+		for (int32 Index = Soak.Enemies.Num() - 1; Index >= 0; Index--)
+		{
+			ABaseCharacter* Enemy = Soak.Enemies[Index].Key.Get();
+			if (IsValid(Enemy) == false || Enemy->IsDead())
+			{
+				Soak.Enemies.RemoveAtSwap(Index, 1, false);
+				continue;
+			}
+
+			if (Now - Soak.Enemies[Index].Value >= Soak.EnemyLifetime)
+			{
+				Enemy->TakeDamage(Enemy->GetHealth(), FDamageEvent(UDamageType::StaticClass()), nullptr, nullptr);
+				continue;
+			}
+
+			Enemy->ActivateAbility(Soak.Center + FVector(FMath::FRandRange(-1000.0f, 1000.0f), FMath::FRandRange(-1000.0f, 1000.0f), 0.0f));
+		}
+
+		Soak.SpawnDebt += Soak.EnemiesPerSecond;
+		for (; Soak.SpawnDebt >= 1.0f && Soak.EnemyClass.IsValid(); Soak.SpawnDebt -= 1.0f)
+		{
+			const float Angle = FMath::FRandRange(0.0f, 2.0f * PI);
+			const FVector Location = Soak.Center + FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.0f) * FMath::FRandRange(300.0f, 1200.0f);
+			if (ABaseCharacter* Enemy = CrowdBenchmark::SpawnClone(World, Soak.EnemyClass.Get(), Location))
+			{
+				Soak.Enemies.Emplace(Enemy, Now);
+				Soak.NumSpawned++;
+			}
+		}
+	}
+
+	void RunGCSoak(const TArray<FString>& Args, UWorld* World)
+	{
+		const float Minutes = Args.Num() > 0 ? FCString::Atof(*Args[0]) : 30.0f;
+		if (World == nullptr || World->GetNetMode() == NM_Client)
+		{
+			UE_LOG(LogUE5TopDownARPG, Log, TEXT("ARPG.Soak.GC needs to run on the server"));
+			return;
+		}
+
+		ABaseCharacter* EnemyToClone = CrowdBenchmark::FindEnemyToClone(World);
+		if (EnemyToClone == nullptr)
+		{
+			UE_LOG(LogUE5TopDownARPG, Log, TEXT("ARPG.Soak.GC needs an enemy in the level to clone"));
+			return;
+		}
+
+		TSharedRef<FGCSoak> Soak = MakeShared<FGCSoak>();
+		Soak->EnemyClass = EnemyToClone->GetClass();
+		Soak->Center = EnemyToClone->GetActorLocation();
+
+		Soak->EnemiesPerSecond = Args.Num() > 1 ? FCString::Atof(*Args[1]) : 4.0f;
+		Soak->EnemyLifetime = Args.Num() > 2 ? FCString::Atof(*Args[2]) : 5.0f;
+		Soak->EndTime = World->GetTimeSeconds() + Minutes * 60.0f;
+
+		if (UGarbageCollectionSubsystem* Subsystem = UGarbageCollectionSubsystem::Get())
+		{
+			Subsystem->ResetStats();
+		}
+
+		UE_LOG(LogUE5TopDownARPG, Log, TEXT("GC soak started: %.1f minutes, %.1f enemies/s living %.1f s"), Minutes, Soak->EnemiesPerSecond, Soak->EnemyLifetime);
+		TWeakObjectPtr<UWorld> WeakWorld = World;
+		World->GetTimerManager().SetTimer(Soak->TimerHandle, FTimerDelegate::CreateLambda([Soak, WeakWorld]()
+		{
+			if (UWorld* World = WeakWorld.Get())
+			{
+				TickGCSoak(World, *Soak);
+			}
+		}), 1.0f, true);
+	}
+
+	FAutoConsoleCommandWithWorldAndArgs GCSoakCommand(
+		TEXT("ARPG.Soak.GC"),
+		TEXT("Spawns, fights and kills enemies for a while, then logs GC pauses. Pass -ARPGSoakExit to quit afterwards. Args: [Minutes=30] [EnemiesPerSecond=4] [EnemyLifetime=5]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&RunGCSoak));
+}
+
+void UGarbageCollectionSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	FCoreUObjectDelegates::GetPreGarbageCollectDelegate().AddUObject(this, &UGarbageCollectionSubsystem::OnPreGarbageCollect);
+	FCoreUObjectDelegates::GetPostGarbageCollect().AddUObject(this, &UGarbageCollectionSubsystem::OnPostGarbageCollect);
+	FCoreUObjectDelegates::PreLoadMap.AddUObject(this, &UGarbageCollectionSubsystem::OnPreLoadMap);
+	FWorldDelegates::OnWorldTickStart.AddUObject(this, &UGarbageCollectionSubsystem::OnWorldTickStart);
+
+	ResetStats();
+}
+
+void UGarbageCollectionSubsystem::Deinitialize()
+{
+	FCoreUObjectDelegates::GetPreGarbageCollectDelegate().RemoveAll(this);
+	FCoreUObjectDelegates::GetPostGarbageCollect().RemoveAll(this);
+	FCoreUObjectDelegates::PreLoadMap.RemoveAll(this);
+	FWorldDelegates::OnWorldTickStart.RemoveAll(this);
+
+	Super::Deinitialize();
+}
+
+UGarbageCollectionSubsystem* UGarbageCollectionSubsystem::Get()
+{
+	return GEngine ? GEngine->GetEngineSubsystem<UGarbageCollectionSubsystem>() : nullptr;
+}
+
+void UGarbageCollectionSubsystem::ClusterResidentAssets()
+{
+	// Like the engine's asset clusters, only cooked data is stable enough; the editor keeps modifying assets.
+	if (FPlatformProperties::RequiresCookedData() == false || bClusterResidentAssets == false)
+	{
+		return;
+	}
+
+	TArray<UObject*> Candidates;
+	GatherResidentAssets<UBehaviorTree>(Candidates);
+	GatherResidentAssets<UBlackboardData>(Candidates);
+	GatherResidentAssets<UPickupDefinition>(Candidates);
+	GatherResidentAssets<ULootTable>(Candidates);
+	GatherResidentAssets<UPreloadManifest>(Candidates);
+	for (TObjectIterator<UClass> It; It; ++It)
+	{
+		if (It->IsChildOf(UBaseAbility::StaticClass()) && It->HasAnyClassFlags(CLASS_Abstract) == false)
+		{
+			Candidates.Add(It->GetDefaultObject(false));
+		}
+	}
+
+	if (ResidentCluster == nullptr)
+	{
+		ResidentCluster = NewObject<UResidentObjectCluster>(GetTransientPackage(), NAME_None, RF_Transient);
+	}
+
+	const bool bClusterCreated = GUObjectArray.ObjectToObjectItem(ResidentCluster)->HasAnyFlags(EInternalObjectFlags::ClusterRoot);
+	const int32 NumBefore = ResidentCluster->Objects.Num();
+	for (UObject* Object : Candidates)
+	{
+		if (CanJoinResidentCluster(Object) == false)
+		{
+			continue;
+		}
+
+		ResidentCluster->Objects.Add(Object);
+		if (bClusterCreated)
+		{
+			Object->AddToCluster(ResidentCluster);
+		}
+	}
+
+	if (bClusterCreated == false && ResidentCluster->Objects.Num() > 0)
+	{
+		ResidentCluster->CreateCluster();
+	}
+
+	SET_DWORD_STAT(STAT_GCResidentClusterSize, ResidentCluster->Objects.Num());
+	UE_LOG(LogUE5TopDownARPG, Log, TEXT("Resident GC cluster: %d objects added, %d total"),
+		ResidentCluster->Objects.Num() - NumBefore, ResidentCluster->Objects.Num());
+}
+
+void UGarbageCollectionSubsystem::OnPreGarbageCollect()
+{
+	CollectStartTime = FPlatformTime::Seconds();
+}
+
+void UGarbageCollectionSubsystem::OnPostGarbageCollect()
+{
+	if (CollectStartTime > 0.0)
+	{
+		PauseMs.Add(float((FPlatformTime::Seconds() - CollectStartTime) * 1000.0));
+		CollectStartTime = 0.0;
+	}
+}
+
+void UGarbageCollectionSubsystem::OnPreLoadMap(const FString& MapName)
+{
+	// The next map brings its own assets; the old ones must be free to unload with their map.
+	if (ResidentCluster != nullptr)
+	{
+		GUObjectClusters.DissolveCluster(ResidentCluster);
+		ResidentCluster = nullptr;
+		SET_DWORD_STAT(STAT_GCResidentClusterSize, 0);
+	}
+}
+
+void UGarbageCollectionSubsystem::OnWorldTickStart(UWorld* World, ELevelTick TickType, float DeltaTime)
+{
+	if (GCPurgeBudgetMs <= 0.0f || LastPurgeFrame == GFrameCounter || IsIncrementalPurgePending() == false)
+	{
+		return;
+	}
+	LastPurgeFrame = GFrameCounter;
+
+	// The engine purges at the end of the frame with its own time limit; delaying its GC step for this
+	// frame leaves the purge to our budget. No new collection can start before the purge finished anyway.
+	const double StartTime = FPlatformTime::Seconds();
+	IncrementalPurgeGarbage(true, GCPurgeBudgetMs / 1000.0f);
+	const float DurationMs = float((FPlatformTime::Seconds() - StartTime) * 1000.0);
+	PurgeMs.Add(DurationMs);
+	INC_FLOAT_STAT_BY(STAT_GCPurgeMs, DurationMs);
+
+	if (GEngine)
+	{
+		GEngine->DelayGarbageCollection();
+	}
+}
+
+void UGarbageCollectionSubsystem::ResetStats()
+{
+	PauseMs.Reset();
+	PurgeMs.Reset();
+	StatsStartTime = FPlatformTime::Seconds();
+	StatsStartObjects = GUObjectArray.GetObjectArrayNumMinusAvailable();
+}
+
+void UGarbageCollectionSubsystem::LogReport() const
+{
+	float MaxPauseMs = 0.0f;
+	for (float Sample : PauseMs)
+	{
+		MaxPauseMs = FMath::Max(MaxPauseMs, Sample);
+	}
+
+	const int32 NumObjects = GUObjectArray.GetObjectArrayNumMinusAvailable();
+	UE_LOG(LogUE5TopDownARPG, Log, TEXT("GC over %.1f minutes: %d collections, pause p50 %.2f ms, p90 %.2f ms, p99 %.2f ms, max %.2f ms"),
+		(FPlatformTime::Seconds() - StatsStartTime) / 60.0, PauseMs.Num(),
+		GameplayMetrics::GetPercentile(PauseMs, 0.5f), GameplayMetrics::GetPercentile(PauseMs, 0.9f), GameplayMetrics::GetPercentile(PauseMs, 0.99f), MaxPauseMs);
+	UE_LOG(LogUE5TopDownARPG, Log, TEXT("GC purge: %d slices, p50 %.2f ms, p99 %.2f ms, budget %.2f ms"),
+		PurgeMs.Num(), GameplayMetrics::GetPercentile(PurgeMs, 0.5f), GameplayMetrics::GetPercentile(PurgeMs, 0.99f), GCPurgeBudgetMs);
+	UE_LOG(LogUE5TopDownARPG, Log, TEXT("GC objects: %d live (%+d), %d in resident cluster, %d disregarded"),
+		NumObjects, NumObjects - StatsStartObjects, ResidentCluster ? ResidentCluster->Objects.Num() : 0,
+		GUObjectArray.GetObjectArrayNumPermanent());
+}
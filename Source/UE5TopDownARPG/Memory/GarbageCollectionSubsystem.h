@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineBaseTypes.h"
+#include "Subsystems/EngineSubsystem.h"
+#include "GarbageCollectionSubsystem.generated.h"
+
+/**
+ * Keeps garbage collection out of the frame time of a long running server:
+ * - Loaded AI assets, ability definitions, pickup definitions and preload manifests are put in one GC
+ *   cluster once they finished loading, see UResidentObjectCluster. Clusters are only built in cooked
+ *   games, like the engine's own asset clusters.
+ * - Objects left by a collection are purged under ARPG.GC.PurgeBudgetMs per frame.
+ * - Every collection pause and purge slice is recorded for ARPG.GCReport and the ARPG.Soak.GC run.
+ */
+UCLASS()
+class UE5TOPDOWNARPG_API UGarbageCollectionSubsystem : public UEngineSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	static UGarbageCollectionSubsystem* Get();
+
+	/** Adds the long-lived gameplay assets loaded so far to the resident cluster. Call once loads complete. */
+	void ClusterResidentAssets();
+
+	void ResetStats();
+	void LogReport() const;
+
+private:
+	void OnPreGarbageCollect();
+	void OnPostGarbageCollect();
+	void OnPreLoadMap(const FString& MapName);
+	void OnWorldTickStart(UWorld* World, ELevelTick TickType, float DeltaTime);
+
+	UPROPERTY(Transient)
+	class UResidentObjectCluster* ResidentCluster = nullptr;
+
+	// Off the UObject heap, a soak keeps one entry per collection and per purge slice.
+	TArray<float> PauseMs;
+	TArray<float> PurgeMs;
+
+	double CollectStartTime = 0.0;
+	double StatsStartTime = 0.0;
+	int32 StatsStartObjects = 0;
+	uint64 LastPurgeFrame = 0;
+};
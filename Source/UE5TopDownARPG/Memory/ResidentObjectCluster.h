@@ -0,0 +1,24 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "ResidentObjectCluster.generated.h"
+
+/**
+ * GC cluster root for gameplay assets that stay loaded and unchanged while a map runs. While the root
+ * is reachable, reachability analysis marks the whole cluster at once instead of visiting every member
+ * and its references. Members must not gain references to new objects after they were added.
+ */
+UCLASS(Transient)
+class UE5TOPDOWNARPG_API UResidentObjectCluster : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool CanBeClusterRoot() const override { return true; }
+
+	UPROPERTY()
+	TArray<UObject*> Objects;
+};
@@ -0,0 +1,148 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GameplayMessageSubsystem.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "../UE5TopDownARPG.h"
+
+DECLARE_CYCLE_STAT(TEXT("Message Delivery"), STAT_MessageDelivery, STATGROUP_ARPG);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Messages Posted"), STAT_MessagesPosted, STATGROUP_ARPG);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Messages Coalesced"), STAT_MessagesCoalesced, STATGROUP_ARPG);
+
+namespace
+{
+	bool bShowDebugOverlay = false;
+	FAutoConsoleVariableRef CVarShowDebugOverlay(
+		TEXT("ARPG.Messages.DebugOverlay"),
+		bShowDebugOverlay,
+		TEXT("Shows the latest health of each actor on screen, one line per actor."));
+}
+
+void UGameplayMessageSubsystem::FPendingMessages::Reset()
+{
+	HealthChanged.Reset();
+	HealthChangedLookup.Reset();
+	Deaths.Reset();
+	GameEnded.Reset();
+}
+
+void UGameplayMessageSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	OnHealthChanged.AddUObject(this, &UGameplayMessageSubsystem::LogMessages);
+	OnDeath.AddUObject(this, &UGameplayMessageSubsystem::LogDeaths);
+	OnGameEnded.AddUObject(this, &UGameplayMessageSubsystem::LogGameEnded);
+}
+
+UGameplayMessageSubsystem* UGameplayMessageSubsystem::Get(const UObject* WorldContextObject)
+{
+	UWorld* World = IsValid(WorldContextObject) ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UGameplayMessageSubsystem>() : nullptr;
+}
+
+void UGameplayMessageSubsystem::PostHealthChanged(AActor* Actor, float OldHealth, float NewHealth)
+{
+	INC_DWORD_STAT(STAT_MessagesPosted);
+
+	FPendingMessages& Pending = Buffers[PostIndex];
+	if (const int32* ExistingIndex = Pending.HealthChangedLookup.Find(Actor))
+	{
+		// Keep the health from before the first hit of the frame.
+		Pending.HealthChanged[*ExistingIndex].NewHealth = NewHealth;
+		NumCoalesced++;
+		INC_DWORD_STAT(STAT_MessagesCoalesced);
+		return;
+	}
+
+	Pending.HealthChangedLookup.Add(Actor, Pending.HealthChanged.Add({ Actor, OldHealth, NewHealth }));
+}
+
+void UGameplayMessageSubsystem::PostDeath(AActor* Actor)
+{
+	INC_DWORD_STAT(STAT_MessagesPosted);
+
+	FPendingMessages& Pending = Buffers[PostIndex];
+	if (Pending.Deaths.ContainsByPredicate([Actor](const FDeathMessage& Message) { return Message.Actor == Actor; }))
+	{
+		NumCoalesced++;
+		INC_DWORD_STAT(STAT_MessagesCoalesced);
+		return;
+	}
+
+	Pending.Deaths.Add({ Actor, Actor->GetActorLocation() });
+}
+
+void UGameplayMessageSubsystem::PostGameEnded(bool bIsWin, int32 ArenaId)
+{
+	INC_DWORD_STAT(STAT_MessagesPosted);
+
+	FPendingMessages& Pending = Buffers[PostIndex];
+	if (FGameEndedMessage* Existing = Pending.GameEnded.FindByPredicate([ArenaId](const FGameEndedMessage& Message) { return Message.ArenaId == ArenaId; }))
+	{
+		NumCoalesced++;
+		INC_DWORD_STAT(STAT_MessagesCoalesced);
+		Existing->bIsWin = bIsWin;
+		return;
+	}
+	Pending.GameEnded.Add(FGameEndedMessage{ bIsWin, ArenaId });
+}
+
+void UGameplayMessageSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_MessageDelivery);
+
+	FPendingMessages& Delivering = Buffers[PostIndex];
+	PostIndex = 1 - PostIndex;
+
+	if (Delivering.HealthChanged.Num() > 0)
+	{
+		OnHealthChanged.Broadcast(Delivering.HealthChanged);
+	}
+	if (Delivering.Deaths.Num() > 0)
+	{
+		OnDeath.Broadcast(Delivering.Deaths);
+	}
+	for (const FGameEndedMessage& Message : Delivering.GameEnded)
+	{
+		OnGameEnded.Broadcast(Message);
+	}
+
+	Delivering.Reset();
+}
+
+TStatId UGameplayMessageSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UGameplayMessageSubsystem, STATGROUP_Tickables);
+}
+
+void UGameplayMessageSubsystem::LogMessages(TArrayView<const FHealthChangedMessage> Messages) const
+{
+	for (const FHealthChangedMessage& Message : Messages)
+	{
+		const AActor* Actor = Message.Actor.Get();
+		UE_LOG(LogUE5TopDownARPG, Verbose, TEXT("%s health %.1f -> %.1f"), *GetNameSafe(Actor), Message.OldHealth, Message.NewHealth);
+
+		if (bShowDebugOverlay && GEngine && Actor != nullptr)
+		{
+			// Keyed by actor so each one updates its own line instead of stacking new ones.
+			GEngine->AddOnScreenDebugMessage(uint64(Actor->GetUniqueID()), 2.0f, FColor::Yellow,
+				FString::Printf(TEXT("%s health %.0f"), *Actor->GetName(), Message.NewHealth));
+		}
+	}
+}
+
+void UGameplayMessageSubsystem::LogDeaths(TArrayView<const FDeathMessage> Messages) const
+{
+	for (const FDeathMessage& Message : Messages)
+	{
+		UE_LOG(LogUE5TopDownARPG, Log, TEXT("Death %s"), *GetNameSafe(Message.Actor.Get()));
+	}
+}
+
+void UGameplayMessageSubsystem::LogGameEnded(const FGameEndedMessage& Message) const
+{
+	UE_LOG(LogUE5TopDownARPG, Log, TEXT("%s in arena %d"), Message.bIsWin ? TEXT("Win") : TEXT("Lose"), Message.ArenaId);
+}
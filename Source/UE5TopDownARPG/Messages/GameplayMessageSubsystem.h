@@ -0,0 +1,79 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "GameplayMessageSubsystem.generated.h"
+
+struct FHealthChangedMessage
+{
+	TWeakObjectPtr<AActor> Actor;
+	float OldHealth;
+	float NewHealth;
+};
+
+struct FDeathMessage
+{
+	TWeakObjectPtr<AActor> Actor;
+	FVector Location;
+};
+
+struct FGameEndedMessage
+{
+	bool bIsWin;
+	int32 ArenaId;
+};
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnHealthChangedMessages, TArrayView<const FHealthChangedMessage>);
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnDeathMessages, TArrayView<const FDeathMessage>);
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnGameEndedMessage, const FGameEndedMessage&);
+
+/**
+ * Typed gameplay message bus. Messages posted during a frame are coalesced per actor
+ * and delivered once, at the end of the frame, to the subscribers of each type.
+ */
+UCLASS()
+class UE5TOPDOWNARPG_API UGameplayMessageSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	static UGameplayMessageSubsystem* Get(const UObject* WorldContextObject);
+
+	void PostHealthChanged(AActor* Actor, float OldHealth, float NewHealth);
+	void PostDeath(AActor* Actor);
+	void PostGameEnded(bool bIsWin, int32 ArenaId = 0);
+
+	FOnHealthChangedMessages OnHealthChanged;
+	FOnDeathMessages OnDeath;
+	FOnGameEndedMessage OnGameEnded;
+
+	int64 GetNumCoalesced() const { return NumCoalesced; }
+
+private:
+	struct FPendingMessages
+	{
+		TArray<FHealthChangedMessage> HealthChanged;
+		TMap<TObjectKey<AActor>, int32> HealthChangedLookup;
+		TArray<FDeathMessage> Deaths;
+		/** At most one per arena. */
+		TArray<FGameEndedMessage, TInlineAllocator<1>> GameEnded;
+
+		void Reset();
+	};
+
+	void LogMessages(TArrayView<const FHealthChangedMessage> Messages) const;
+	void LogDeaths(TArrayView<const FDeathMessage> Messages) const;
+	void LogGameEnded(const FGameEndedMessage& Message) const;
+
+	// Posting goes to one buffer while the other is delivered, so subscribers may post.
+	FPendingMessages Buffers[2];
+	int32 PostIndex = 0;
+
+	int64 NumCoalesced = 0;
+};
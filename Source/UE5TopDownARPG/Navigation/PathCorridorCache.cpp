@@ -0,0 +1,245 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PathCorridorCache.h"
+#include "HAL/IConsoleManager.h"
+#include "NavigationSystem.h"
+#include "../UE5TopDownARPG.h"
+
+DECLARE_CYCLE_STAT(TEXT("Click Path Plan"), STAT_ClickPathPlan, STATGROUP_ARPG);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Click Path Full Queries"), STAT_ClickPathFullQueries, STATGROUP_ARPG);
+
+namespace
+{
+	bool bPathCorridorCacheEnabled = true;
+	FAutoConsoleVariableRef CVarPathCorridorCache(
+		TEXT("ARPG.ClickMove.PathCache"),
+		bPathCorridorCacheEnabled,
+		TEXT("Reuses the followed path and recent paths for click-to-move instead of a full query per click."));
+
+	float CorridorRadius = 75.0f;
+	FAutoConsoleVariableRef CVarCorridorRadius(
+		TEXT("ARPG.ClickMove.CorridorRadius"),
+		CorridorRadius,
+		TEXT("How far from the followed path a destination may be and still reuse it."));
+
+	float TailReplanDistance = 800.0f;
+	FAutoConsoleVariableRef CVarTailReplanDistance(
+		TEXT("ARPG.ClickMove.TailReplanDistance"),
+		TailReplanDistance,
+		TEXT("Destinations this close to the end of the followed path only replan from that end."));
+
+	const float CacheStartTolerance = 100.0f;
+	const float CacheEndTolerance = 50.0f;
+	const float MaxCorridorHeightDifference = 100.0f;
+}
+
+FPathCorridorCache::EPlanResult FPathCorridorCache::FindPath(UNavigationSystemV1& NavSys, const ANavigationData& NavData, UObject* Querier,
+	const FVector& Start, const FVector& Destination, FNavPathSharedPtr& OutPath)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ClickPathPlan);
+
+	EPlanResult Result = EPlanResult::Failed;
+	TArray<FVector> Points;
+	const int32 CurrentSegment = bPathCorridorCacheEnabled ? FindCorridorSegment(Start) : INDEX_NONE;
+	const bool bHasCurrentPath = CurrentSegment != INDEX_NONE;
+
+	if (bHasCurrentPath && TryCorridor(NavData, Start, Destination, CurrentSegment, Points))
+	{
+		Result = EPlanResult::CorridorReuse;
+	}
+	else if (bPathCorridorCacheEnabled && TryCache(Start, Destination, Points))
+	{
+		Result = EPlanResult::CacheHit;
+	}
+	else
+	{
+		const bool bReplanTail = bHasCurrentPath
+			&& FVector::DistSquared(Corridor->GetPathPoints().Last().Location, Destination) <= FMath::Square(TailReplanDistance);
+		const FVector QueryStart = bReplanTail ? Corridor->GetPathPoints().Last().Location : Start;
+
+		FPathFindingQuery Query(Querier, NavData, QueryStart, Destination);
+		const FPathFindingResult QueryResult = NavSys.FindPathSync(Query);
+		INC_DWORD_STAT(STAT_ClickPathFullQueries);
+		if (QueryResult.IsSuccessful() && QueryResult.Path.IsValid())
+		{
+			const TArray<FNavPathPoint>& QueryPoints = QueryResult.Path->GetPathPoints();
+			if (bReplanTail)
+			{
+				// Keep the part of the followed path ahead of us and continue from its end.
+				const TArray<FNavPathPoint>& CurrentPoints = Corridor->GetPathPoints();
+				Points.Add(Start);
+				for (int32 Index = CurrentSegment + 1; Index < CurrentPoints.Num(); Index++)
+				{
+					Points.Add(CurrentPoints[Index].Location);
+				}
+				for (int32 Index = 1; Index < QueryPoints.Num(); Index++)
+				{
+					Points.Add(QueryPoints[Index].Location);
+				}
+				Result = EPlanResult::TailReplan;
+			}
+			else
+			{
+				OutPath = QueryResult.Path;
+				Result = EPlanResult::FullQuery;
+			}
+		}
+	}
+
+	if (Points.Num() > 1)
+	{
+		OutPath = MakePath(NavData, Querier, Points);
+	}
+	if (Result == EPlanResult::FullQuery || Result == EPlanResult::TailReplan)
+	{
+		AddToCache(OutPath, Start, Destination);
+	}
+
+	Corridor = OutPath;
+	NumResults[(int32)Result]++;
+	return Result;
+}
+
+int32 FPathCorridorCache::FindCorridorSegment(const FVector& Start) const
+{
+	if (Corridor.IsValid() == false || Corridor->IsValid() == false)
+	{
+		return INDEX_NONE;
+	}
+
+	const TArray<FNavPathPoint>& PathPoints = Corridor->GetPathPoints();
+	int32 ClosestSegment = INDEX_NONE;
+	float ClosestDistanceSquared = FMath::Square(2.0f * CorridorRadius);
+	for (int32 Index = 0; Index < PathPoints.Num() - 1; Index++)
+	{
+		const float DistanceSquared = float(FMath::PointDistToSegmentSquared(Start, PathPoints[Index].Location, PathPoints[Index + 1].Location));
+		if (DistanceSquared <= ClosestDistanceSquared)
+		{
+			ClosestDistanceSquared = DistanceSquared;
+			ClosestSegment = Index;
+		}
+	}
+	return ClosestSegment;
+}
+
+bool FPathCorridorCache::TryCorridor(const ANavigationData& NavData, const FVector& Start, const FVector& Destination, int32 CurrentSegment, TArray<FVector>& OutPoints) const
+{
+	const TArray<FNavPathPoint>& PathPoints = Corridor->GetPathPoints();
+	for (int32 Index = CurrentSegment; Index < PathPoints.Num() - 1; Index++)
+	{
+		const FVector SegmentStart = Index == CurrentSegment ? Start : PathPoints[Index].Location;
+		const FVector SegmentEnd = PathPoints[Index + 1].Location;
+		const FVector Closest = FMath::ClosestPointOnSegment(Destination, SegmentStart, SegmentEnd);
+		if (FVector::DistSquared2D(Closest, Destination) > FMath::Square(CorridorRadius)
+			|| FMath::Abs(Closest.Z - Destination.Z) > MaxCorridorHeightDifference)
+		{
+			continue;
+		}
+
+		// A navmesh raycast is much cheaper than a path query and catches a destination across a thin wall.
+		FVector HitLocation;
+		if (NavData.Raycast(Closest, Destination, HitLocation, nullptr))
+		{
+			continue;
+		}
+
+		OutPoints.Add(Start);
+		for (int32 PointIndex = CurrentSegment + 1; PointIndex <= Index; PointIndex++)
+		{
+			OutPoints.Add(PathPoints[PointIndex].Location);
+		}
+		if (FVector::DistSquared(Closest, OutPoints.Last()) > KINDA_SMALL_NUMBER)
+		{
+			OutPoints.Add(Closest);
+		}
+		OutPoints.Add(Destination);
+		return true;
+	}
+	return false;
+}
+
+bool FPathCorridorCache::TryCache(const FVector& Start, const FVector& Destination, TArray<FVector>& OutPoints)
+{
+	for (FCachedPath& Entry : Cache)
+	{
+		if (FVector::DistSquared(Entry.Start, Start) > FMath::Square(CacheStartTolerance)
+			|| FVector::DistSquared(Entry.End, Destination) > FMath::Square(CacheEndTolerance))
+		{
+			continue;
+		}
+
+		const TArray<FNavPathPoint>& PathPoints = Entry.Path->GetPathPoints();
+		OutPoints.Add(Start);
+		for (int32 Index = 1; Index < PathPoints.Num() - 1; Index++)
+		{
+			OutPoints.Add(PathPoints[Index].Location);
+		}
+		OutPoints.Add(Destination);
+		Entry.LastUsed = ++UseCounter;
+		return true;
+	}
+	return false;
+}
+
+void FPathCorridorCache::AddToCache(const FNavPathSharedPtr& Path, const FVector& Start, const FVector& End)
+{
+	if (Path.IsValid() == false)
+	{
+		return;
+	}
+
+	FCachedPath* Entry = nullptr;
+	if (Cache.Num() < CacheSize)
+	{
+		Entry = &Cache.AddDefaulted_GetRef();
+	}
+	else
+	{
+		Entry = &Cache[0];
+		for (FCachedPath& Candidate : Cache)
+		{
+			if (Candidate.LastUsed < Entry->LastUsed)
+			{
+				Entry = &Candidate;
+			}
+		}
+	}
+
+	Entry->Path = Path;
+	Entry->Start = Start;
+	Entry->End = End;
+	Entry->LastUsed = ++UseCounter;
+}
+
+FNavPathSharedPtr FPathCorridorCache::MakePath(const ANavigationData& NavData, UObject* Querier, const TArray<FVector>& Points) const
+{
+	FNavPathSharedPtr Path = MakeShared<FNavigationPath, ESPMode::ThreadSafe>(Points);
+	Path->SetNavigationDataUsed(&NavData);
+	Path->SetQuerier(Querier);
+	Path->SetTimeStamp(NavData.GetWorldTimeStamp());
+	return Path;
+}
+
+void FPathCorridorCache::Reset()
+{
+	Corridor.Reset();
+	Cache.Reset();
+}
+
+const TCHAR* FPathCorridorCache::GetResultName(EPlanResult Result)
+{
+	switch (Result)
+	{
+	case EPlanResult::CorridorReuse:
+		return TEXT("corridor reuse");
+	case EPlanResult::CacheHit:
+		return TEXT("cache hit");
+	case EPlanResult::TailReplan:
+		return TEXT("tail replan");
+	case EPlanResult::FullQuery:
+		return TEXT("full query");
+	default:
+		return TEXT("failed");
+	}
+}
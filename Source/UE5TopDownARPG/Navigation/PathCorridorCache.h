@@ -0,0 +1,65 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "NavigationData.h"
+
+/**
+ * Plans click-to-move paths while avoiding full navmesh queries where it can. The last planned path
+ * is kept as the corridor being followed. A destination on or next to it truncates the corridor,
+ * a destination near its end only replans the tail, and a recent path with a matching start and
+ * end is reused. Only the rest run a full query.
+ */
+class FPathCorridorCache
+{
+public:
+	enum class EPlanResult : uint8
+	{
+		CorridorReuse,
+		CacheHit,
+		TailReplan,
+		FullQuery,
+		Failed,
+		Num
+	};
+
+	/** Plans from Start to Destination and makes the result the corridor for the next click. */
+	EPlanResult FindPath(class UNavigationSystemV1& NavSys, const ANavigationData& NavData, UObject* Querier,
+		const FVector& Start, const FVector& Destination, FNavPathSharedPtr& OutPath);
+
+	/** Forgets the corridor, for when the pawn moved off it. */
+	void ClearCorridor() { Corridor.Reset(); }
+
+	void Reset();
+
+	int32 GetNumResults(EPlanResult Result) const { return NumResults[(int32)Result]; }
+
+	static const TCHAR* GetResultName(EPlanResult Result);
+
+private:
+	struct FCachedPath
+	{
+		FNavPathSharedPtr Path;
+		FVector Start;
+		FVector End;
+		uint64 LastUsed = 0;
+	};
+
+	/** Segment of the corridor the pawn is on, INDEX_NONE when it has left the corridor. */
+	int32 FindCorridorSegment(const FVector& Start) const;
+
+	bool TryCorridor(const ANavigationData& NavData, const FVector& Start, const FVector& Destination, int32 CurrentSegment, TArray<FVector>& OutPoints) const;
+	bool TryCache(const FVector& Start, const FVector& Destination, TArray<FVector>& OutPoints);
+	void AddToCache(const FNavPathSharedPtr& Path, const FVector& Start, const FVector& End);
+
+	FNavPathSharedPtr MakePath(const ANavigationData& NavData, UObject* Querier, const TArray<FVector>& Points) const;
+
+	FNavPathSharedPtr Corridor;
+
+	static constexpr int32 CacheSize = 8;
+	TArray<FCachedPath, TInlineAllocator<CacheSize>> Cache;
+	uint64 UseCounter = 0;
+
+	int32 NumResults[(int32)EPlanResult::Num] = {};
+};
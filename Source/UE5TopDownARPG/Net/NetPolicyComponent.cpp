@@ -0,0 +1,267 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NetPolicyComponent.h"
+#include "Engine/World.h"
+#include "Engine/NetDriver.h"
+#include "Engine/NetConnection.h"
+#include "Net/NetworkObjectList.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/Pawn.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/CommandLine.h"
+#include "TimerManager.h"
+#include "../UE5TopDownARPG.h"
+
+namespace
+{
+	struct FConnectionNetStats
+	{
+		FString Name;
+		int64 NumConsidered = 0;
+		int32 MaxConsidered = 0;
+	};
+
+	struct FNetPolicyStatsRun
+	{
+		TWeakObjectPtr<UWorld> World;
+		TMap<TWeakObjectPtr<UNetConnection>, FConnectionNetStats> Connections;
+		float Seconds = 10.0f;
+		int32 NumClients = 0;
+		double EndTime = -1.0;
+		int32 NumFrames = 0;
+		int64 NumActive = 0;
+		FDelegateHandle PostActorTickHandle;
+	};
+
+	/**
+	 * Actors the net driver's replication pass considers for the connection this frame: active objects due
+	 * for an update, not dormant for the connection and relevant to its viewer.
+	 */
+	int32 CountConsideredActors(const UWorld& World, const FNetworkObjectList& NetworkObjects, UNetConnection& Connection)
+	{
+		APlayerController* Viewer = Connection.PlayerController;
+		if (Viewer == nullptr)
+		{
+			return 0;
+		}
+
+		const AActor* ViewTarget = Connection.ViewTarget ? Connection.ViewTarget.Get() : Viewer;
+		FVector ViewLocation;
+		FRotator ViewRotation;
+		Viewer->GetPlayerViewPoint(ViewLocation, ViewRotation);
+
+		const TWeakObjectPtr<UNetConnection> WeakConnection = &Connection;
+		int32 NumConsidered = 0;
+		for (const TSharedPtr<FNetworkObjectInfo>& ObjectInfo : NetworkObjects.GetActiveObjects())
+		{
+			const AActor* Actor = ObjectInfo->Actor;
+			if (Actor == nullptr
+				|| (ObjectInfo->bPendingNetUpdate == false && World.GetTimeSeconds() <= ObjectInfo->NextUpdateTime)
+				|| ObjectInfo->DormantConnections.Contains(WeakConnection)
+				|| Actor->IsNetRelevantFor(Viewer, ViewTarget, ViewLocation) == false)
+			{
+				continue;
+			}
+			NumConsidered++;
+		}
+		return NumConsidered;
+	}
+
+	void FinishNetPolicyStats(FNetPolicyStatsRun& Run)
+	{
+		const double NumFrames = FMath::Max(Run.NumFrames, 1);
+		UE_LOG(LogUE5TopDownARPG, Log, TEXT("Net policy stats over %d frames: %.1f active network objects/frame"), Run.NumFrames, Run.NumActive / NumFrames);
+		for (const TPair<TWeakObjectPtr<UNetConnection>, FConnectionNetStats>& Connection : Run.Connections)
+		{
+			UE_LOG(LogUE5TopDownARPG, Log, TEXT("  %s: %.1f actors considered/frame, max %d"),
+				*Connection.Value.Name, Connection.Value.NumConsidered / NumFrames, Connection.Value.MaxConsidered);
+		}
+
+		FWorldDelegates::OnWorldPostActorTick.Remove(Run.PostActorTickHandle);
+		if (FParse::Param(FCommandLine::Get(), TEXT("ARPGNetPolicyStatsExit")))
+		{
+			FPlatformMisc::RequestExit(false);
+		}
+	}
+
+	void TickNetPolicyStats(FNetPolicyStatsRun& Run, UWorld& World)
+	{
+		UNetDriver* NetDriver = World.GetNetDriver();
+		if (IsValid(NetDriver) == false)
+		{
+			return;
+		}
+
+		// Sampling starts once every expected client has a player controller.
+		if (Run.EndTime < 0.0)
+		{
+			int32 NumReady = 0;
+			for (UNetConnection* Connection : NetDriver->ClientConnections)
+			{
+				NumReady += IsValid(Connection) && Connection->PlayerController != nullptr ? 1 : 0;
+			}
+			if (NumReady < Run.NumClients)
+			{
+				return;
+			}
+			Run.EndTime = World.GetTimeSeconds() + Run.Seconds;
+			UE_LOG(LogUE5TopDownARPG, Log, TEXT("Net policy stats: sampling %d connections for %.1f s"), NumReady, Run.Seconds);
+		}
+
+		// After actors ticked, like the replication pass that follows in the same frame.
+		const FNetworkObjectList& NetworkObjects = NetDriver->GetNetworkObjectList();
+		Run.NumActive += NetworkObjects.GetActiveObjects().Num();
+		Run.NumFrames++;
+		for (UNetConnection* Connection : NetDriver->ClientConnections)
+		{
+			if (IsValid(Connection))
+			{
+				FConnectionNetStats& Stats = Run.Connections.FindOrAdd(Connection);
+				Stats.Name = Connection->LowLevelGetRemoteAddress();
+				const int32 NumConsidered = CountConsideredActors(World, NetworkObjects, *Connection);
+				Stats.NumConsidered += NumConsidered;
+				Stats.MaxConsidered = FMath::Max(Stats.MaxConsidered, NumConsidered);
+			}
+		}
+
+		if (World.GetTimeSeconds() >= Run.EndTime)
+		{
+			FinishNetPolicyStats(Run);
+		}
+	}
+
+	void RunNetPolicyStats(const TArray<FString>& Args, UWorld* World)
+	{
+		UNetDriver* NetDriver = World ? World->GetNetDriver() : nullptr;
+		if (IsValid(NetDriver) == false || NetDriver->IsServer() == false)
+		{
+			UE_LOG(LogUE5TopDownARPG, Log, TEXT("ARPG.NetPolicyStats must run on a server"));
+			return;
+		}
+
+		TSharedRef<FNetPolicyStatsRun> Run = MakeShared<FNetPolicyStatsRun>();
+		Run->World = World;
+		Run->Seconds = Args.Num() > 0 ? FCString::Atof(*Args[0]) : 10.0f;
+		Run->NumClients = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 0;
+		Run->PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddLambda([Run](UWorld* TickedWorld, ELevelTick TickType, float DeltaSeconds)
+		{
+			// Finishing removes this lambda and the reference it holds.
+			TSharedRef<FNetPolicyStatsRun> RunningStats = Run;
+			if (RunningStats->World.IsValid() == false)
+			{
+				FinishNetPolicyStats(*RunningStats);
+			}
+			else if (TickedWorld == RunningStats->World.Get())
+			{
+				TickNetPolicyStats(*RunningStats, *TickedWorld);
+			}
+		});
+	}
+
+	FAutoConsoleCommandWithWorldAndArgs NetPolicyStatsCommand(
+		TEXT("ARPG.NetPolicyStats"),
+		TEXT("Samples the actors considered for replication per client connection every frame, then logs the average and peak. ")
+		TEXT("Waits for NumClients connections first. Pass -ARPGNetPolicyStatsExit to quit afterwards. Args: [Seconds=10] [NumClients=0]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&RunNetPolicyStats));
+}
+
+UNetPolicyComponent::UNetPolicyComponent()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+}
+
+void UNetPolicyComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	AActor* Owner = GetOwner();
+	if (Owner->HasAuthority() == false)
+	{
+		return;
+	}
+
+	switch (Policy)
+	{
+	case ENetPolicy::Static:
+		// Dormancy only means something for actors that replicate.
+		if (Owner->GetIsReplicated() == false)
+		{
+			break;
+		}
+		Owner->NetUpdateFrequency = StaticNetUpdateFrequency;
+		Owner->SetNetDormancy(DORM_DormantAll);
+		break;
+
+	case ENetPolicy::Proximity:
+		// Spread the evaluations of a freshly spawned wave over the interval, seeded by the actor's name so runs repeat.
+		GetWorld()->GetTimerManager().SetTimer(EvaluateTimerHandle, this, &UNetPolicyComponent::EvaluateProximity,
+			EvaluateInterval, true, FRandomStream(GetTypeHash(Owner->GetFName())).FRandRange(0.0f, EvaluateInterval));
+		break;
+	}
+}
+
+void UNetPolicyComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	GetWorld()->GetTimerManager().ClearTimer(EvaluateTimerHandle);
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UNetPolicyComponent::WakeForStateChange()
+{
+	AActor* Owner = GetOwner();
+	if (Owner->HasAuthority())
+	{
+		Owner->FlushNetDormancy();
+	}
+}
+
+void UNetPolicyComponent::NotifyActivity()
+{
+	AActor* Owner = GetOwner();
+	if (Policy != ENetPolicy::Proximity || Owner->HasAuthority() == false)
+	{
+		return;
+	}
+
+	const bool bWasActive = GetWorld()->GetTimeSeconds() - LastActivityTime < ActivityDuration;
+	LastActivityTime = GetWorld()->GetTimeSeconds();
+	if (bWasActive == false)
+	{
+		EvaluateProximity();
+		Owner->ForceNetUpdate();
+	}
+}
+
+void UNetPolicyComponent::EvaluateProximity()
+{
+	AActor* Owner = GetOwner();
+
+	// Player pawns keep the engine's replication settings.
+	APawn* OwnerPawn = Cast<APawn>(Owner);
+	if (OwnerPawn != nullptr && OwnerPawn->IsPlayerControlled())
+	{
+		return;
+	}
+
+	const FVector OwnerLocation = Owner->GetActorLocation();
+
+	float ClosestDistanceSquared = MAX_flt;
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		APlayerController* PlayerController = It->Get();
+		APawn* PlayerPawn = PlayerController ? PlayerController->GetPawn() : nullptr;
+		if (PlayerPawn != nullptr && PlayerPawn != Owner)
+		{
+			ClosestDistanceSquared = FMath::Min(ClosestDistanceSquared, float(FVector::DistSquared(OwnerLocation, PlayerPawn->GetActorLocation())));
+		}
+	}
+
+	const bool bIsActive = GetWorld()->GetTimeSeconds() - LastActivityTime < ActivityDuration;
+	const float Distance = FMath::Sqrt(ClosestDistanceSquared);
+	const float Alpha = bIsActive ? 0.0f : FMath::GetRangePct(NearDistance, FarDistance, FMath::Clamp(Distance, NearDistance, FarDistance));
+
+	Owner->NetUpdateFrequency = FMath::Lerp(MaxNetUpdateFrequency, MinNetUpdateFrequency, Alpha);
+	Owner->NetCullDistanceSquared = FMath::Square(bIsActive || Distance < FarDistance ? ActiveNetCullDistance : IdleNetCullDistance);
+}
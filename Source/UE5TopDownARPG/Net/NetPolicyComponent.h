@@ -0,0 +1,75 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "NetPolicyComponent.generated.h"
+
+UENUM()
+enum class ENetPolicy : uint8
+{
+	/** Dormant until the owner reports a state change. Does nothing for owners that do not replicate. */
+	Static,
+	/** Update frequency and cull distance follow the distance to the closest player and recent activity. */
+	Proximity
+};
+
+/**
+ * Server-side replication policy for the owning actor.
+ */
+UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
+class UE5TOPDOWNARPG_API UNetPolicyComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UNetPolicyComponent();
+
+	/** Static policy: push the owner's new state to clients. */
+	void WakeForStateChange();
+
+	/** Proximity policy: replicate at full rate for a while, e.g. after taking damage or casting. */
+	void NotifyActivity();
+
+	UPROPERTY(EditDefaultsOnly, Category = Net)
+	ENetPolicy Policy = ENetPolicy::Static;
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	void EvaluateProximity();
+
+	UPROPERTY(EditDefaultsOnly, Category = Net)
+	float StaticNetUpdateFrequency = 1.0f;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Net|Proximity")
+	float NearDistance = 1500.0f;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Net|Proximity")
+	float FarDistance = 6000.0f;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Net|Proximity")
+	float MaxNetUpdateFrequency = 30.0f;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Net|Proximity")
+	float MinNetUpdateFrequency = 2.0f;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Net|Proximity")
+	float ActiveNetCullDistance = 15000.0f;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Net|Proximity")
+	float IdleNetCullDistance = 7000.0f;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Net|Proximity")
+	float ActivityDuration = 2.0f;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Net|Proximity")
+	float EvaluateInterval = 0.5f;
+
+private:
+	FTimerHandle EvaluateTimerHandle;
+
+	float LastActivityTime = -1000.0f;
+};
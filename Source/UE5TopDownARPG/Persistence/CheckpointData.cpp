@@ -0,0 +1,95 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CheckpointData.h"
+
+const uint32 FCheckpointData::FileMagic = 0x43505241; // "ARPC"
+const uint16 FCheckpointData::FileVersion = 1;
+
+namespace
+{
+	void SerializePackedInt(FArchive& Ar, int32& Value)
+	{
+		uint32 PackedValue = uint32(Value + 1); // INDEX_NONE packs to zero.
+		Ar.SerializeIntPacked(PackedValue);
+		Value = int32(PackedValue) - 1;
+	}
+
+	template<typename RecordType, typename AllocatorType, typename SerializeRecordType>
+	void SerializeRecords(FArchive& Ar, TArray<RecordType, AllocatorType>& Records, SerializeRecordType SerializeRecord)
+	{
+		int32 Num = Records.Num();
+		SerializePackedInt(Ar, Num);
+		if (Ar.IsLoading())
+		{
+			// Bound the allocation by what is left to read, a corrupt count must not exhaust memory.
+			if (Num < 0 || Num > Ar.TotalSize() - Ar.Tell())
+			{
+				Ar.SetError();
+				return;
+			}
+			Records.SetNum(Num);
+		}
+
+		for (RecordType& Record : Records)
+		{
+			SerializeRecord(Ar, Record);
+			if (Ar.IsError())
+			{
+				return;
+			}
+		}
+	}
+}
+
+bool FCheckpointData::Serialize(FArchive& Ar)
+{
+	uint32 Magic = FileMagic;
+	uint16 Version = FileVersion;
+	Ar << Magic;
+	Ar << Version;
+	if (Magic != FileMagic || Version != FileVersion)
+	{
+		return false;
+	}
+
+	SerializeRecords(Ar, ClassPaths, [](FArchive& Ar, FString& Path) { Ar << Path; });
+	SerializeRecords(Ar, PickupPaths, [](FArchive& Ar, FString& Path) { Ar << Path; });
+
+	SerializeRecords(Ar, Triggers, [](FArchive& Ar, FCheckpointTriggerRecord& Record)
+	{
+		Ar << Record.Id;
+		SerializePackedInt(Ar, Record.Wave);
+		Ar << Record.TimeToNextWave;
+	});
+
+	SerializeRecords(Ar, Characters, [](FArchive& Ar, FCheckpointCharacterRecord& Record)
+	{
+		SerializePackedInt(Ar, Record.ClassIndex);
+		uint8 bIsPlayer = Record.bIsPlayer ? 1 : 0;
+		Ar << bIsPlayer;
+		Record.bIsPlayer = bIsPlayer != 0;
+		Ar << Record.Location;
+
+		// A top-down character only needs its heading, at 16 bits.
+		uint16 PackedYaw = FRotator3f::CompressAxisToShort(Record.Yaw);
+		Ar << PackedYaw;
+		Record.Yaw = FRotator3f::DecompressAxisFromShort(PackedYaw);
+
+		Ar << Record.Health;
+		SerializeRecords(Ar, Record.Slots, [](FArchive& Ar, FCheckpointSlotRecord& Slot)
+		{
+			Ar << Slot.DefinitionIndex;
+			Ar << Slot.Charges;
+			Ar << Slot.CooldownRemaining;
+		});
+	});
+
+	SerializeRecords(Ar, Pickups, [](FArchive& Ar, FCheckpointPickupRecord& Record)
+	{
+		SerializePackedInt(Ar, Record.DefinitionIndex);
+		Ar << Record.Location;
+	});
+
+	return Ar.IsError() == false;
+}
@@ -0,0 +1,56 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FCheckpointSlotRecord
+{
+	uint8 DefinitionIndex = 0;
+	uint8 Charges = 0;
+	float CooldownRemaining = 0.0f;
+};
+
+struct FCheckpointCharacterRecord
+{
+	int32 ClassIndex = INDEX_NONE;
+	bool bIsPlayer = false;
+	FVector3f Location = FVector3f::ZeroVector;
+	float Yaw = 0.0f;
+	float Health = 0.0f;
+	TArray<FCheckpointSlotRecord, TInlineAllocator<4>> Slots;
+};
+
+struct FCheckpointTriggerRecord
+{
+	uint32 Id = 0;
+	int32 Wave = 0;
+	/** Negative when the trigger is not spawning. */
+	float TimeToNextWave = -1.0f;
+};
+
+struct FCheckpointPickupRecord
+{
+	int32 DefinitionIndex = INDEX_NONE;
+	FVector3f Location = FVector3f::ZeroVector;
+};
+
+/**
+ * Encounter state as written to a checkpoint file. Classes and pickup definitions are stored
+ * once in path tables and referenced by index from the records.
+ */
+struct FCheckpointData
+{
+	static const uint32 FileMagic;
+	static const uint16 FileVersion;
+
+	TArray<FString> ClassPaths;
+	TArray<FString> PickupPaths;
+
+	TArray<FCheckpointTriggerRecord> Triggers;
+	TArray<FCheckpointCharacterRecord> Characters;
+	TArray<FCheckpointPickupRecord> Pickups;
+
+	/** Reads or writes the whole checkpoint. Returns false when reading something that is not a checkpoint of this version. */
+	bool Serialize(FArchive& Ar);
+};
@@ -0,0 +1,527 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CheckpointSubsystem.h"
+#include "Async/Async.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Async/MappedFileHandle.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "../Abilities/AbilityComponent.h"
+#include "../Characters/BaseCharacter.h"
+#include "../Pickups/PickupDefinition.h"
+#include "../Pickups/PickupSubsystem.h"
+#include "../Trigger/SpawnTrigger.h"
+#include "../UE5TopDownARPG.h"
+
+DECLARE_CYCLE_STAT(TEXT("Checkpoint Gather"), STAT_CheckpointGather, STATGROUP_ARPG);
+DECLARE_CYCLE_STAT(TEXT("Checkpoint Load"), STAT_CheckpointLoad, STATGROUP_ARPG);
+
+namespace
+{
+	float CheckpointIntervalSeconds = 10.0f;
+	FAutoConsoleVariableRef CVarCheckpointIntervalSeconds(
+		TEXT("ARPG.Checkpoint.IntervalSeconds"),
+		CheckpointIntervalSeconds,
+		TEXT("Time between automatic checkpoints on the server. 0 disables them."));
+
+	void SaveCheckpoint(const TArray<FString>& Args, UWorld* World)
+	{
+		if (UCheckpointSubsystem* Subsystem = UCheckpointSubsystem::Get(World))
+		{
+			Subsystem->SaveCheckpoint(Args.Num() > 0 ? Args[0] : UCheckpointSubsystem::GetDefaultPath());
+		}
+	}
+
+	void LoadCheckpoint(const TArray<FString>& Args, UWorld* World)
+	{
+		if (UCheckpointSubsystem* Subsystem = UCheckpointSubsystem::Get(World))
+		{
+			Subsystem->LoadCheckpoint(Args.Num() > 0 ? Args[0] : UCheckpointSubsystem::GetDefaultPath());
+		}
+	}
+
+	void LogCheckpointReport(UWorld* World)
+	{
+		if (UCheckpointSubsystem* Subsystem = UCheckpointSubsystem::Get(World))
+		{
+			Subsystem->LogReport();
+		}
+	}
+
+	FAutoConsoleCommandWithWorldAndArgs CheckpointSaveCommand(
+		TEXT("ARPG.Checkpoint.Save"),
+		TEXT("Writes a checkpoint of the encounter. Args: [FilePath]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&SaveCheckpoint));
+
+	FAutoConsoleCommandWithWorldAndArgs CheckpointLoadCommand(
+		TEXT("ARPG.Checkpoint.Load"),
+		TEXT("Restores the encounter from a checkpoint. Args: [FilePath]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&LoadCheckpoint));
+
+	FAutoConsoleCommandWithWorld CheckpointReportCommand(
+		TEXT("ARPG.Checkpoint.Report"),
+		TEXT("Logs timings and size of the last checkpoint save and load."),
+		FConsoleCommandWithWorldDelegate::CreateStatic(&LogCheckpointReport));
+
+	bool ReadCheckpointFile(const FString& FilePath, FCheckpointData& OutData)
+	{
+		// Map the file instead of copying it; fall back to a plain read where mapping is not supported.
+		IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+		TUniquePtr<IMappedFileHandle> MappedFile(PlatformFile.OpenMapped(*FilePath));
+		TUniquePtr<IMappedFileRegion> MappedRegion(MappedFile.IsValid() ? MappedFile->MapRegion() : nullptr);
+
+		TArray<uint8> FileData;
+		TArrayView<const uint8> Bytes;
+		if (MappedRegion.IsValid())
+		{
+			Bytes = MakeArrayView(MappedRegion->GetMappedPtr(), int32(MappedRegion->GetMappedSize()));
+		}
+		else if (FFileHelper::LoadFileToArray(FileData, *FilePath, FILEREAD_Silent))
+		{
+			Bytes = FileData;
+		}
+		else
+		{
+			return false;
+		}
+
+		FMemoryReaderView Reader(Bytes);
+		return OutData.Serialize(Reader);
+	}
+
+	void RunCheckpointBenchmark(const TArray<FString>& Args)
+	{
+		const int32 NumActors = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 1000;
+		if (NumActors <= 0)
+		{
+			return;
+		}
+
+		// Typical encounter mix: mostly enemies, some pickups, a few triggers.
+		FRandomStream Stream(NumActors);
+		FCheckpointData Data;
+		Data.ClassPaths = { TEXT("/Game/TopDown/Blueprints/BP_TopDownCharacter.BP_TopDownCharacter_C"), TEXT("/Game/TopDown/Blueprints/BP_TopDownCharacterEnemy.BP_TopDownCharacterEnemy_C") };
+		Data.PickupPaths = { TEXT("/Game/TopDown/Pickups/DA_HealthPickup.DA_HealthPickup") };
+		for (int32 Index = 0; Index < NumActors; Index++)
+		{
+			const FVector3f Location(Stream.FRandRange(-5000.0f, 5000.0f), Stream.FRandRange(-5000.0f, 5000.0f), 100.0f);
+			if (Index % 10 == 9)
+			{
+				Data.Pickups.Add({ 0, Location });
+				continue;
+			}
+
+			FCheckpointCharacterRecord& Record = Data.Characters.AddDefaulted_GetRef();
+			Record.ClassIndex = Index == 0 ? 0 : 1;
+			Record.bIsPlayer = Index == 0;
+			Record.Location = Location;
+			Record.Yaw = Stream.FRandRange(-180.0f, 180.0f);
+			Record.Health = Stream.FRandRange(1.0f, 100.0f);
+			Record.Slots.Add({ 0, 1, Stream.FRandRange(0.0f, 1.0f) });
+		}
+		for (int32 Index = 0; Index < 8; Index++)
+		{
+			Data.Triggers.Add({ uint32(Index), 2, 0.5f });
+		}
+
+		double StartTime = FPlatformTime::Seconds();
+		TArray<uint8> Bytes;
+		FMemoryWriter Writer(Bytes);
+		Data.Serialize(Writer);
+		const double SerializeMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+		const FString FilePath = FPaths::ProjectSavedDir() / TEXT("Checkpoints") / TEXT("Benchmark.arpgsav");
+		StartTime = FPlatformTime::Seconds();
+		FFileHelper::SaveArrayToFile(Bytes, *FilePath);
+		const double WriteMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+		StartTime = FPlatformTime::Seconds();
+		FCheckpointData LoadedData;
+		const bool bLoaded = ReadCheckpointFile(FilePath, LoadedData);
+		const double LoadMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+		IFileManager::Get().Delete(*FilePath);
+
+		UE_LOG(LogUE5TopDownARPG, Log, TEXT("Checkpoint of %d actors: %d bytes (%.1f bytes/actor), serialize %.3f ms, write %.3f ms, mapped load %.3f ms%s"),
+			NumActors, Bytes.Num(), float(Bytes.Num()) / NumActors, SerializeMs, WriteMs, LoadMs,
+			bLoaded && LoadedData.Characters.Num() == Data.Characters.Num() ? TEXT("") : TEXT(" (load FAILED)"));
+	}
+
+	FAutoConsoleCommand CheckpointBenchmarkCommand(
+		TEXT("ARPG.Bench.Checkpoint"),
+		TEXT("Measures checkpoint save and load time and file size. Args: [NumActors=1000]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&RunCheckpointBenchmark));
+}
+
+bool UCheckpointSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	UWorld* World = Cast<UWorld>(Outer);
+	return Super::ShouldCreateSubsystem(Outer) && IsValid(World) && World->IsGameWorld();
+}
+
+void UCheckpointSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	LastSaveTime = InWorld.GetTimeSeconds();
+
+	FString CheckpointPath;
+	if (InWorld.GetNetMode() != NM_Client && FParse::Value(FCommandLine::Get(), TEXT("ARPGCheckpoint="), CheckpointPath))
+	{
+		LoadCheckpoint(CheckpointPath);
+	}
+}
+
+void UCheckpointSubsystem::Deinitialize()
+{
+	// Let an in-flight write finish before the world goes away.
+	while (bSaveInProgress)
+	{
+		FPlatformProcess::Sleep(0.001f);
+	}
+
+	Super::Deinitialize();
+}
+
+UCheckpointSubsystem* UCheckpointSubsystem::Get(const UObject* WorldContextObject)
+{
+	UWorld* World = IsValid(WorldContextObject) ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UCheckpointSubsystem>() : nullptr;
+}
+
+FString UCheckpointSubsystem::GetDefaultPath()
+{
+	return FPaths::ProjectSavedDir() / TEXT("Checkpoints") / TEXT("Checkpoint.arpgsav");
+}
+
+void UCheckpointSubsystem::Tick(float DeltaTime)
+{
+	const double Now = GetWorld()->GetTimeSeconds();
+	if (CheckpointIntervalSeconds > 0.0f && Now - LastSaveTime >= CheckpointIntervalSeconds && GetWorld()->GetNetMode() != NM_Client)
+	{
+		SaveCheckpoint(GetDefaultPath());
+	}
+}
+
+TStatId UCheckpointSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UCheckpointSubsystem, STATGROUP_Tickables);
+}
+
+void UCheckpointSubsystem::RegisterCharacter(ABaseCharacter* Character)
+{
+	FTrackedCharacter& Tracked = TrackedCharacters.FindOrAdd(Character);
+	Tracked.Character = Character;
+	Tracked.bIsDirty = true;
+
+	// A checkpoint loaded at startup is applied before any player has a pawn.
+	if (PendingPlayerRecords.Num() > 0 && Character->IsPlayerControlled())
+	{
+		RestoreCharacter(Character, PendingPlayerRecords[0]);
+		PendingPlayerRecords.RemoveAt(0);
+	}
+}
+
+void UCheckpointSubsystem::UnregisterCharacter(ABaseCharacter* Character)
+{
+	TrackedCharacters.Remove(Character);
+}
+
+void UCheckpointSubsystem::MarkDirty(ABaseCharacter* Character)
+{
+	if (FTrackedCharacter* Tracked = TrackedCharacters.Find(Character))
+	{
+		Tracked->bIsDirty = true;
+	}
+}
+
+bool UCheckpointSubsystem::SaveCheckpoint(const FString& FilePath)
+{
+	if (bSaveInProgress)
+	{
+		return false;
+	}
+
+	LastSaveTime = GetWorld()->GetTimeSeconds();
+
+	TSharedRef<FCheckpointData> Data = MakeShared<FCheckpointData>();
+	{
+		SCOPE_CYCLE_COUNTER(STAT_CheckpointGather);
+		const double StartTime = FPlatformTime::Seconds();
+
+		for (TActorIterator<ASpawnTrigger> It(GetWorld()); It; ++It)
+		{
+			FCheckpointTriggerRecord& Record = Data->Triggers.AddDefaulted_GetRef();
+			Record.Id = FCrc::StrCrc32(*It->GetName());
+			Record.Wave = It->GetCurrentWave();
+			Record.TimeToNextWave = It->GetTimeToNextWave();
+		}
+
+		const float Now = GetWorld()->GetTimeSeconds();
+		LastNumRebuilt = 0;
+		Data->Characters.Reserve(TrackedCharacters.Num());
+		for (TPair<TObjectKey<ABaseCharacter>, FTrackedCharacter>& Pair : TrackedCharacters)
+		{
+			FTrackedCharacter& Tracked = Pair.Value;
+			const ABaseCharacter* Character = Tracked.Character.Get();
+			if (Character == nullptr || Character->IsDead())
+			{
+				continue;
+			}
+
+			// Characters move and cooldowns run down every frame, the rest of the record only changes when marked dirty.
+			if (Tracked.bIsDirty)
+			{
+				RefreshRecord(Tracked);
+				LastNumRebuilt++;
+			}
+			Tracked.Record.Location = FVector3f(Character->GetActorLocation());
+			Tracked.Record.Yaw = Character->GetActorRotation().Yaw;
+			for (int32 SlotIndex = 0; SlotIndex < Tracked.Record.Slots.Num(); SlotIndex++)
+			{
+				Tracked.Record.Slots[SlotIndex].CooldownRemaining = FMath::Max(Tracked.CooldownEndTimes[SlotIndex] - Now, 0.0f);
+			}
+			Data->Characters.Add(Tracked.Record);
+		}
+
+		GatherPickups(*Data);
+		Data->ClassPaths = ClassPaths;
+		Data->PickupPaths = PickupPaths;
+
+		LastGatherMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+	}
+
+	bSaveInProgress = true;
+	TWeakObjectPtr<UCheckpointSubsystem> WeakThis = this;
+	std::atomic<bool>* SaveInProgress = &bSaveInProgress;
+	Async(EAsyncExecution::ThreadPool, [Data, FilePath, WeakThis, SaveInProgress]()
+	{
+		double StartTime = FPlatformTime::Seconds();
+		TArray<uint8> Bytes;
+		FMemoryWriter Writer(Bytes);
+		Data->Serialize(Writer);
+		const double SerializeMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+		// Write next to the target and swap it in, so a crash mid-write keeps the previous checkpoint.
+		StartTime = FPlatformTime::Seconds();
+		const FString TempPath = FilePath + TEXT(".tmp");
+		const bool bSucceeded = FFileHelper::SaveArrayToFile(Bytes, *TempPath) && IFileManager::Get().Move(*FilePath, *TempPath, true);
+		const double WriteMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+		const int64 NumBytes = Bytes.Num();
+		AsyncTask(ENamedThreads::GameThread, [WeakThis, NumBytes, SerializeMs, WriteMs, bSucceeded]()
+		{
+			if (UCheckpointSubsystem* Subsystem = WeakThis.Get())
+			{
+				Subsystem->OnSaveCompleted(NumBytes, SerializeMs, WriteMs, bSucceeded);
+			}
+		});
+
+		// Deinitialize waits on this flag, so it is the last thing the worker touches.
+		*SaveInProgress = false;
+	});
+	return true;
+}
+
+void UCheckpointSubsystem::OnSaveCompleted(int64 NumBytes, double SerializeMs, double WriteMs, bool bSucceeded)
+{
+	LastSaveBytes = NumBytes;
+	LastSerializeMs = SerializeMs;
+	LastWriteMs = WriteMs;
+
+	if (bSucceeded == false)
+	{
+		UE_LOG(LogUE5TopDownARPG, Error, TEXT("Failed to write checkpoint"));
+		return;
+	}
+
+	UE_LOG(LogUE5TopDownARPG, Verbose, TEXT("Checkpoint saved: %lld bytes, gather %.3f ms (%d records rebuilt), serialize %.3f ms, write %.3f ms"),
+		NumBytes, LastGatherMs, LastNumRebuilt, SerializeMs, WriteMs);
+}
+
+void UCheckpointSubsystem::RefreshRecord(FTrackedCharacter& Tracked)
+{
+	ABaseCharacter* Character = Tracked.Character.Get();
+	FCheckpointCharacterRecord& Record = Tracked.Record;
+	Record.ClassIndex = FindOrAddClass(Character->GetClass());
+	Record.bIsPlayer = Character->IsPlayerControlled();
+	Record.Health = Character->GetHealth();
+
+	Record.Slots.Reset();
+	Tracked.CooldownEndTimes.Reset();
+	for (const FAbilitySlotState& Slot : Character->GetAbilityComponent()->GetSlots())
+	{
+		Record.Slots.Add({ Slot.DefinitionIndex, Slot.Charges, 0.0f });
+		Tracked.CooldownEndTimes.Add(Slot.CooldownEndTime);
+	}
+
+	Tracked.bIsDirty = false;
+}
+
+void UCheckpointSubsystem::GatherPickups(FCheckpointData& Data)
+{
+	UPickupSubsystem* PickupSubsystem = GetWorld()->GetSubsystem<UPickupSubsystem>();
+	if (IsValid(PickupSubsystem) == false)
+	{
+		return;
+	}
+
+	if (PickupSubsystem->GetRevision() != PickupRevision)
+	{
+		PickupRevision = PickupSubsystem->GetRevision();
+		PickupRecords.Reset();
+		PickupSubsystem->ForEachPickup([this](const UPickupDefinition* Definition, const FVector& Location)
+		{
+			const int32 DefinitionIndex = PickupPaths.AddUnique(FSoftObjectPath(Definition).ToString());
+			PickupRecords.Add({ DefinitionIndex, FVector3f(Location) });
+		});
+	}
+	Data.Pickups = PickupRecords;
+}
+
+int32 UCheckpointSubsystem::FindOrAddClass(UClass* Class)
+{
+	if (const int32* ExistingIndex = ClassIndices.Find(Class))
+	{
+		return *ExistingIndex;
+	}
+
+	const int32 ClassIndex = ClassPaths.Add(FSoftClassPath(Class).ToString());
+	ClassIndices.Add(Class, ClassIndex);
+	return ClassIndex;
+}
+
+bool UCheckpointSubsystem::LoadCheckpoint(const FString& FilePath)
+{
+	SCOPE_CYCLE_COUNTER(STAT_CheckpointLoad);
+	const double StartTime = FPlatformTime::Seconds();
+
+	FCheckpointData Data;
+	if (ReadCheckpointFile(FilePath, Data) == false)
+	{
+		UE_LOG(LogUE5TopDownARPG, Error, TEXT("%s is not a version %d checkpoint"), *FilePath, FCheckpointData::FileVersion);
+		return false;
+	}
+
+	ApplyCheckpoint(Data);
+
+	LastLoadMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+	UE_LOG(LogUE5TopDownARPG, Log, TEXT("Checkpoint %s loaded in %.2f ms: %d characters, %d pickups, %d triggers"),
+		*FilePath, LastLoadMs, Data.Characters.Num(), Data.Pickups.Num(), Data.Triggers.Num());
+	return true;
+}
+
+void UCheckpointSubsystem::ApplyCheckpoint(const FCheckpointData& Data)
+{
+	UWorld* World = GetWorld();
+
+	for (TActorIterator<ASpawnTrigger> It(World); It; ++It)
+	{
+		const uint32 Id = FCrc::StrCrc32(*It->GetName());
+		if (const FCheckpointTriggerRecord* Record = Data.Triggers.FindByPredicate([Id](const FCheckpointTriggerRecord& Record) { return Record.Id == Id; }))
+		{
+			It->RestoreWaveProgress(Record->Wave, Record->TimeToNextWave);
+		}
+	}
+
+	// The checkpointed enemies replace whatever the level started with.
+	TArray<ABaseCharacter*> Players;
+	for (TActorIterator<ABaseCharacter> It(World); It; ++It)
+	{
+		if (It->IsPlayerControlled())
+		{
+			Players.Add(*It);
+		}
+		else
+		{
+			It->Destroy();
+		}
+	}
+
+	TArray<UClass*> Classes;
+	for (const FString& ClassPath : Data.ClassPaths)
+	{
+		Classes.Add(FSoftClassPath(ClassPath).TryLoadClass<ABaseCharacter>());
+	}
+
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+	PendingPlayerRecords.Reset();
+	int32 NextPlayer = 0;
+	for (const FCheckpointCharacterRecord& Record : Data.Characters)
+	{
+		ABaseCharacter* Character = nullptr;
+		if (Record.bIsPlayer)
+		{
+			if (Players.IsValidIndex(NextPlayer) == false)
+			{
+				// Restored once a player possesses a character, see RegisterCharacter.
+				PendingPlayerRecords.Add(Record);
+				continue;
+			}
+			Character = Players[NextPlayer++];
+		}
+		else if (Classes.IsValidIndex(Record.ClassIndex) && Classes[Record.ClassIndex] != nullptr)
+		{
+			Character = World->SpawnActor<ABaseCharacter>(Classes[Record.ClassIndex], FVector(Record.Location), FRotator(0.0f, Record.Yaw, 0.0f), SpawnParameters);
+		}
+
+		if (IsValid(Character))
+		{
+			RestoreCharacter(Character, Record);
+		}
+	}
+
+	if (UPickupSubsystem* PickupSubsystem = World->GetSubsystem<UPickupSubsystem>())
+	{
+		PickupSubsystem->ClearPickups();
+
+		TArray<UPickupDefinition*> Definitions;
+		for (const FString& PickupPath : Data.PickupPaths)
+		{
+			Definitions.Add(Cast<UPickupDefinition>(FSoftObjectPath(PickupPath).TryLoad()));
+		}
+
+		for (const FCheckpointPickupRecord& Record : Data.Pickups)
+		{
+			if (Definitions.IsValidIndex(Record.DefinitionIndex) && Definitions[Record.DefinitionIndex] != nullptr)
+			{
+				PickupSubsystem->SpawnPickup(Definitions[Record.DefinitionIndex], FVector(Record.Location));
+			}
+		}
+	}
+}
+
+void UCheckpointSubsystem::RestoreCharacter(ABaseCharacter* Character, const FCheckpointCharacterRecord& Record) const
+{
+	Character->RestoreHealth(Record.Health);
+
+	const float Now = GetWorld()->GetTimeSeconds();
+	TArray<FAbilitySlotState, TInlineAllocator<4>> Slots;
+	for (const FCheckpointSlotRecord& SlotRecord : Record.Slots)
+	{
+		FAbilitySlotState& Slot = Slots.AddDefaulted_GetRef();
+		Slot.DefinitionIndex = SlotRecord.DefinitionIndex;
+		Slot.Charges = SlotRecord.Charges;
+		Slot.CooldownEndTime = Now + SlotRecord.CooldownRemaining;
+	}
+	Character->GetAbilityComponent()->RestoreSlots(Slots);
+}
+
+void UCheckpointSubsystem::LogReport() const
+{
+	UE_LOG(LogUE5TopDownARPG, Log, TEXT("Last checkpoint save: %lld bytes, %d characters tracked, %d records rebuilt"),
+		LastSaveBytes, TrackedCharacters.Num(), LastNumRebuilt);
+	UE_LOG(LogUE5TopDownARPG, Log, TEXT("  game thread gather %.3f ms, worker serialize %.3f ms, worker write %.3f ms"),
+		LastGatherMs, LastSerializeMs, LastWriteMs);
+	UE_LOG(LogUE5TopDownARPG, Log, TEXT("Last checkpoint load: %.3f ms"), LastLoadMs);
+}
@@ -0,0 +1,88 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "CheckpointData.h"
+#include <atomic>
+#include "CheckpointSubsystem.generated.h"
+
+/**
+ * Saves spawn wave progress, character health and cooldowns, and dropped pickups to a binary
+ * checkpoint, and restores them after a server restart.
+ *
+ * Character records are only rebuilt when the character was marked dirty; the game thread copies
+ * the records and a worker thread serializes and writes the file. Loading memory-maps the file.
+ *
+ * Save: every ARPG.Checkpoint.IntervalSeconds, or ARPG.Checkpoint.Save.
+ * Load: -ARPGCheckpoint=<file> on the command line, or ARPG.Checkpoint.Load [file].
+ */
+UCLASS()
+class UE5TOPDOWNARPG_API UCheckpointSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	static UCheckpointSubsystem* Get(const UObject* WorldContextObject);
+	static FString GetDefaultPath();
+
+	/** Also called when a player takes control of the character, to hand it a checkpointed player record. */
+	void RegisterCharacter(class ABaseCharacter* Character);
+	void UnregisterCharacter(class ABaseCharacter* Character);
+
+	/** Health or cooldowns changed, rebuild the character's record on the next save. */
+	void MarkDirty(class ABaseCharacter* Character);
+
+	/** Starts an asynchronous save. Returns false when a previous save is still being written. */
+	bool SaveCheckpoint(const FString& FilePath);
+	bool LoadCheckpoint(const FString& FilePath);
+
+	void LogReport() const;
+
+private:
+	struct FTrackedCharacter
+	{
+		TWeakObjectPtr<class ABaseCharacter> Character;
+		FCheckpointCharacterRecord Record;
+		/** Per record slot, converted to the remaining cooldown on every save. */
+		TArray<float, TInlineAllocator<4>> CooldownEndTimes;
+		bool bIsDirty = true;
+	};
+
+	void RefreshRecord(FTrackedCharacter& Tracked);
+	void RestoreCharacter(class ABaseCharacter* Character, const FCheckpointCharacterRecord& Record) const;
+	void GatherPickups(FCheckpointData& Data);
+	int32 FindOrAddClass(UClass* Class);
+	void ApplyCheckpoint(const FCheckpointData& Data);
+	void OnSaveCompleted(int64 NumBytes, double SerializeMs, double WriteMs, bool bSucceeded);
+
+	TMap<TObjectKey<class ABaseCharacter>, FTrackedCharacter> TrackedCharacters;
+
+	/** Loaded player records waiting for a player to possess a character, in checkpoint order. */
+	TArray<FCheckpointCharacterRecord> PendingPlayerRecords;
+
+	TArray<FString> ClassPaths;
+	TMap<UClass*, int32> ClassIndices;
+
+	TArray<FString> PickupPaths;
+	TArray<FCheckpointPickupRecord> PickupRecords;
+	uint32 PickupRevision = MAX_uint32;
+
+	std::atomic<bool> bSaveInProgress { false };
+	double LastSaveTime = 0.0;
+
+	// Timings of the last save and load.
+	double LastGatherMs = 0.0;
+	double LastSerializeMs = 0.0;
+	double LastWriteMs = 0.0;
+	int64 LastSaveBytes = 0;
+	int32 LastNumRebuilt = 0;
+	double LastLoadMs = 0.0;
+};
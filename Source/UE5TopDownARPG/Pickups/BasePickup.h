@@ -1,25 +1,30 @@
-// Fill out your copyright notice in the Description page of Project Settings.
-
-#pragma once
-
-#include "CoreMinimal.h"
-#include "GameFramework/Actor.h"
-#include "BasePickup.generated.h"
-
-UCLASS()
-class UE5TOPDOWNARPG_API ABasePickup : public AActor
-{
-	GENERATED_BODY()
-	
-public:	
-	ABasePickup();
-
-protected:
-	virtual void OnPickup(class AUE5TopDownARPGCharacter* Character);
-
-	UFUNCTION()
-	void OnBeginOverlap(UPrimitiveComponent* OverlappedComponent, AActor* Other, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
-
-	UPROPERTY(EditDefaultsOnly)
-	class USphereComponent* SphereComponent;
-};
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "BasePickup.generated.h"
+
+UCLASS()
+class UE5TOPDOWNARPG_API ABasePickup : public AActor
+{
+	GENERATED_BODY()
+	
+public:	
+	ABasePickup();
+
+	virtual bool IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const override;
+
+protected:
+	virtual void OnPickup(class AUE5TopDownARPGCharacter* Character);
+
+	UFUNCTION()
+	void OnBeginOverlap(UPrimitiveComponent* OverlappedComponent, AActor* Other, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
+
+	UPROPERTY(EditDefaultsOnly)
+	class USphereComponent* SphereComponent;
+
+	UPROPERTY(EditDefaultsOnly)
+	class UNetPolicyComponent* NetPolicyComponent;
+};
@@ -0,0 +1,30 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LootTable.h"
+#include "PickupDefinition.h"
+
+UPickupDefinition* ULootTable::Roll(FRandomStream& RandomStream) const
+{
+	float TotalWeight = 0.0f;
+	for (const FLootTableEntry& Entry : Entries)
+	{
+		TotalWeight += Entry.Weight;
+	}
+
+	if (TotalWeight <= 0.0f)
+	{
+		return nullptr;
+	}
+
+	float Roll = RandomStream.FRandRange(0.0f, TotalWeight);
+	for (const FLootTableEntry& Entry : Entries)
+	{
+		if (Roll < Entry.Weight)
+		{
+			return Entry.Pickup;
+		}
+		Roll -= Entry.Weight;
+	}
+	return Entries.Last().Pickup;
+}
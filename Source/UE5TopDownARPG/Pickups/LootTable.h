@@ -0,0 +1,36 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "LootTable.generated.h"
+
+USTRUCT()
+struct FLootTableEntry
+{
+	GENERATED_BODY()
+
+	/** Pickup to drop. Leave empty for a "nothing drops" entry. */
+	UPROPERTY(EditDefaultsOnly)
+	class UPickupDefinition* Pickup = nullptr;
+
+	UPROPERTY(EditDefaultsOnly, meta = (ClampMin = "0.0"))
+	float Weight = 1.0f;
+};
+
+/**
+ * Weighted drop table rolled when a character dies.
+ */
+UCLASS()
+class UE5TOPDOWNARPG_API ULootTable : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	class UPickupDefinition* Roll(FRandomStream& RandomStream) const;
+
+protected:
+	UPROPERTY(EditDefaultsOnly)
+	TArray<FLootTableEntry> Entries;
+};
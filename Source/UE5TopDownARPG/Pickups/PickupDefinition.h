@@ -0,0 +1,39 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "PickupDefinition.generated.h"
+
+UENUM()
+enum class EPickupEffect : uint8
+{
+	Heal
+};
+
+/**
+ * Data for a lightweight pickup owned by UPickupSubsystem. Pickups of the same
+ * definition are rendered as instances of one mesh.
+ */
+UCLASS()
+class UE5TOPDOWNARPG_API UPickupDefinition : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditDefaultsOnly)
+	class UStaticMesh* Mesh;
+
+	UPROPERTY(EditDefaultsOnly)
+	FVector MeshScale = FVector::OneVector;
+
+	UPROPERTY(EditDefaultsOnly)
+	float PickupRadius = 100.0f;
+
+	UPROPERTY(EditDefaultsOnly)
+	EPickupEffect Effect = EPickupEffect::Heal;
+
+	UPROPERTY(EditDefaultsOnly)
+	float Magnitude = 50.0f;
+};
@@ -0,0 +1,252 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PickupSubsystem.h"
+#include "LootTable.h"
+#include "PickupDefinition.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Engine/DamageEvents.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "../Characters/BaseCharacter.h"
+#include "../Telemetry/GameplayMetrics.h"
+#include "../UE5TopDownARPG.h"
+
+DECLARE_CYCLE_STAT(TEXT("Pickup Tick"), STAT_PickupTick, STATGROUP_ARPG);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Active Pickups"), STAT_ActivePickups, STATGROUP_ARPG);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pickups Collected"), STAT_PickupsCollected, STATGROUP_ARPG);
+
+namespace
+{
+	int32 LootSeed = 0;
+	FAutoConsoleVariableRef CVarLootSeed(
+		TEXT("ARPG.Loot.Seed"),
+		LootSeed,
+		TEXT("Seed for loot rolls when a world starts. 0 picks a random seed."));
+
+	const float PickupGridCellSize = 512.0f;
+}
+
+void UPickupSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	SetLootSeed(LootSeed != 0 ? LootSeed : FMath::Rand());
+}
+
+void UPickupSubsystem::SetLootSeed(int32 Seed)
+{
+	LootStream.Initialize(Seed);
+	UE_LOG(LogUE5TopDownARPG, Log, TEXT("Loot seed %d"), Seed);
+}
+
+void UPickupSubsystem::DropLoot(const ULootTable* LootTable, const FVector& Location)
+{
+	if (IsValid(LootTable) == false)
+	{
+		return;
+	}
+
+	UPickupDefinition* Definition = LootTable->Roll(LootStream);
+	if (IsValid(Definition))
+	{
+		SpawnPickup(Definition, Location);
+	}
+}
+
+int32 UPickupSubsystem::SpawnPickup(UPickupDefinition* Definition, const FVector& Location)
+{
+	const int32 DefinitionIndex = FindOrAddDefinition(Definition);
+	if (DefinitionIndex == INDEX_NONE)
+	{
+		return INDEX_NONE;
+	}
+
+	const int32 RecordIndex = FreeRecords.Num() > 0 ? FreeRecords.Pop(false) : Records.AddDefaulted();
+	FPickupRecord& Record = Records[RecordIndex];
+	Record.Location = Location;
+	Record.DefinitionIndex = DefinitionIndex;
+
+	UInstancedStaticMeshComponent* InstancedMesh = InstancedMeshes[DefinitionIndex];
+	const FTransform InstanceTransform(FQuat::Identity, Location, Definition->MeshScale);
+	TArray<int32>& DefinitionFreeInstances = FreeInstances[DefinitionIndex];
+	if (DefinitionFreeInstances.Num() > 0)
+	{
+		Record.InstanceIndex = DefinitionFreeInstances.Pop(false);
+		InstancedMesh->UpdateInstanceTransform(Record.InstanceIndex, InstanceTransform, true, false, true);
+	}
+	else
+	{
+		Record.InstanceIndex = InstancedMesh->AddInstance(InstanceTransform, true);
+	}
+	DirtyMeshes.Add(InstancedMesh);
+
+	Grid.FindOrAdd(GetCell(Location)).Add(RecordIndex);
+	Revision++;
+	return RecordIndex;
+}
+
+void UPickupSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_PickupTick);
+
+	UWorld* World = GetWorld();
+	if (GetNumActivePickups() > 0 && World->GetNetMode() != NM_Client)
+	{
+		const FVector SearchExtent(MaxPickupRadius, MaxPickupRadius, 0.0f);
+		for (FConstPlayerControllerIterator It = World->GetPlayerControllerIterator(); It; ++It)
+		{
+			APlayerController* PlayerController = It->Get();
+			ABaseCharacter* Character = PlayerController ? Cast<ABaseCharacter>(PlayerController->GetPawn()) : nullptr;
+			if (IsValid(Character) == false)
+			{
+				continue;
+			}
+
+			const FVector CharacterLocation = Character->GetActorLocation();
+			const FIntPoint MinCell = GetCell(CharacterLocation - SearchExtent);
+			const FIntPoint MaxCell = GetCell(CharacterLocation + SearchExtent);
+			for (int32 X = MinCell.X; X <= MaxCell.X; X++)
+			{
+				for (int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++)
+				{
+					TArray<int32>* Cell = Grid.Find(FIntPoint(X, Y));
+					if (Cell == nullptr)
+					{
+						continue;
+					}
+
+					// Iterate backwards so RemoveAtSwap only moves already visited entries.
+					for (int32 Index = Cell->Num() - 1; Index >= 0; Index--)
+					{
+						const int32 RecordIndex = (*Cell)[Index];
+						const FPickupRecord& Record = Records[RecordIndex];
+						const float PickupRadius = Definitions[Record.DefinitionIndex]->PickupRadius;
+						if (FVector::DistSquared(Record.Location, CharacterLocation) <= FMath::Square(PickupRadius))
+						{
+							Cell->RemoveAtSwap(Index, 1, false);
+							CollectPickup(RecordIndex, Character);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	for (UInstancedStaticMeshComponent* InstancedMesh : DirtyMeshes)
+	{
+		if (IsValid(InstancedMesh))
+		{
+			InstancedMesh->MarkRenderStateDirty();
+		}
+	}
+	DirtyMeshes.Reset();
+
+	SET_DWORD_STAT(STAT_ActivePickups, GetNumActivePickups());
+}
+
+TStatId UPickupSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UPickupSubsystem, STATGROUP_Tickables);
+}
+
+void UPickupSubsystem::CollectPickup(int32 RecordIndex, ABaseCharacter* Character)
+{
+	ApplyEffect(Definitions[Records[RecordIndex].DefinitionIndex], Character);
+	INC_DWORD_STAT(STAT_PickupsCollected);
+	GameplayMetrics::Increment(EGameplayCounter::PickupsCollected);
+
+	ReleaseRecord(RecordIndex);
+}
+
+void UPickupSubsystem::ReleaseRecord(int32 RecordIndex)
+{
+	FPickupRecord& Record = Records[RecordIndex];
+
+	// Hide the instance and keep it for the next drop of the same definition.
+	UInstancedStaticMeshComponent* InstancedMesh = InstancedMeshes[Record.DefinitionIndex];
+	InstancedMesh->UpdateInstanceTransform(Record.InstanceIndex, FTransform(FQuat::Identity, Record.Location, FVector::ZeroVector), true, false, true);
+	DirtyMeshes.Add(InstancedMesh);
+	FreeInstances[Record.DefinitionIndex].Add(Record.InstanceIndex);
+
+	Record.DefinitionIndex = INDEX_NONE;
+	Record.InstanceIndex = INDEX_NONE;
+	FreeRecords.Add(RecordIndex);
+	Revision++;
+}
+
+void UPickupSubsystem::ForEachPickup(TFunctionRef<void(const UPickupDefinition*, const FVector&)> Visitor) const
+{
+	for (const FPickupRecord& Record : Records)
+	{
+		if (Record.DefinitionIndex != INDEX_NONE)
+		{
+			Visitor(Definitions[Record.DefinitionIndex], Record.Location);
+		}
+	}
+}
+
+void UPickupSubsystem::ClearPickups()
+{
+	for (int32 RecordIndex = 0; RecordIndex < Records.Num(); RecordIndex++)
+	{
+		if (Records[RecordIndex].DefinitionIndex != INDEX_NONE)
+		{
+			ReleaseRecord(RecordIndex);
+		}
+	}
+	Grid.Reset();
+}
+
+void UPickupSubsystem::ApplyEffect(const UPickupDefinition* Definition, ABaseCharacter* Character) const
+{
+	switch (Definition->Effect)
+	{
+	case EPickupEffect::Heal:
+		Character->TakeDamage(-Definition->Magnitude, FDamageEvent(UDamageType::StaticClass()), nullptr, nullptr);
+		break;
+	}
+}
+
+int32 UPickupSubsystem::FindOrAddDefinition(UPickupDefinition* Definition)
+{
+	if (IsValid(Definition) == false || IsValid(Definition->Mesh) == false)
+	{
+		return INDEX_NONE;
+	}
+
+	const int32 ExistingIndex = Definitions.Find(Definition);
+	if (ExistingIndex != INDEX_NONE)
+	{
+		return ExistingIndex;
+	}
+
+	if (IsValid(RenderActor) == false)
+	{
+		FActorSpawnParameters SpawnParameters;
+		SpawnParameters.ObjectFlags |= RF_Transient;
+		RenderActor = GetWorld()->SpawnActor<AActor>(AActor::StaticClass(), FTransform::Identity, SpawnParameters);
+
+		USceneComponent* RootComponent = NewObject<USceneComponent>(RenderActor, TEXT("Root"));
+		RenderActor->SetRootComponent(RootComponent);
+		RootComponent->RegisterComponent();
+	}
+
+	UInstancedStaticMeshComponent* InstancedMesh = NewObject<UInstancedStaticMeshComponent>(RenderActor);
+	InstancedMesh->SetStaticMesh(Definition->Mesh);
+	InstancedMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	InstancedMesh->SetupAttachment(RenderActor->GetRootComponent());
+	InstancedMesh->RegisterComponent();
+	RenderActor->AddInstanceComponent(InstancedMesh);
+
+	MaxPickupRadius = FMath::Max(MaxPickupRadius, Definition->PickupRadius);
+	FreeInstances.AddDefaulted();
+	InstancedMeshes.Add(InstancedMesh);
+	return Definitions.Add(Definition);
+}
+
+FIntPoint UPickupSubsystem::GetCell(const FVector& Location) const
+{
+	return FIntPoint(FMath::FloorToInt(Location.X / PickupGridCellSize), FMath::FloorToInt(Location.Y / PickupGridCellSize));
+}
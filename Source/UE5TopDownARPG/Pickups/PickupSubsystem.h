@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "PickupSubsystem.generated.h"
+
+/**
+ * Owns every dropped pickup as a pooled record instead of an actor.
+ * Pickups are drawn as instanced meshes per definition and collected
+ * with a grid-accelerated distance check against player pawns.
+ */
+UCLASS()
+class UE5TOPDOWNARPG_API UPickupSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/** Rolls the table with the loot random stream and drops the result, if any. */
+	void DropLoot(const class ULootTable* LootTable, const FVector& Location);
+
+	int32 SpawnPickup(class UPickupDefinition* Definition, const FVector& Location);
+
+	void SetLootSeed(int32 Seed);
+	int32 GetLootSeed() const { return LootStream.GetInitialSeed(); }
+
+	int32 GetNumActivePickups() const { return Records.Num() - FreeRecords.Num(); }
+
+	/** Changes whenever a pickup is added or removed. */
+	uint32 GetRevision() const { return Revision; }
+
+	void ForEachPickup(TFunctionRef<void(const class UPickupDefinition*, const FVector&)> Visitor) const;
+
+	/** Removes every pickup without applying its effect. */
+	void ClearPickups();
+
+private:
+	struct FPickupRecord
+	{
+		FVector Location;
+		int32 DefinitionIndex = INDEX_NONE;
+		int32 InstanceIndex = INDEX_NONE;
+	};
+
+	int32 FindOrAddDefinition(class UPickupDefinition* Definition);
+	void CollectPickup(int32 RecordIndex, class ABaseCharacter* Character);
+	void ReleaseRecord(int32 RecordIndex);
+	void ApplyEffect(const class UPickupDefinition* Definition, class ABaseCharacter* Character) const;
+
+	FIntPoint GetCell(const FVector& Location) const;
+
+	UPROPERTY(Transient)
+	TArray<class UPickupDefinition*> Definitions;
+
+	UPROPERTY(Transient)
+	TArray<class UInstancedStaticMeshComponent*> InstancedMeshes;
+
+	UPROPERTY(Transient)
+	AActor* RenderActor;
+
+	/** Hidden instances per definition, ready for reuse. */
+	TArray<TArray<int32>> FreeInstances;
+
+	TArray<FPickupRecord> Records;
+	TArray<int32> FreeRecords;
+
+	TMap<FIntPoint, TArray<int32>> Grid;
+	float MaxPickupRadius = 0.0f;
+
+	TSet<class UInstancedStaticMeshComponent*> DirtyMeshes;
+
+	FRandomStream LootStream;
+
+	uint32 Revision = 0;
+};
@@ -1,37 +1,575 @@
-// Fill out your copyright notice in the Description page of Project Settings.
-
-
-#include "Projectile.h"
-#include "Components/SphereComponent.h"
-#include "GameFramework/ProjectileMovementComponent.h"
-#include "Engine/DamageEvents.h"
-
-// Sets default values
-AProjectile::AProjectile()
-{
- 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
-	SetReplicates(true);
-
-	SphereComponent = CreateDefaultSubobject<USphereComponent>(TEXT("CollisionSphereComponent"));
-	SphereComponent->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Overlap);
-	SphereComponent->SetupAttachment(RootComponent);
-
-	SphereComponent->OnComponentBeginOverlap.AddUniqueDynamic(this, &AProjectile::OnBeginOverlap);
-
-	MovementComponent = CreateDefaultSubobject<UProjectileMovementComponent>(TEXT("MovementComponent"));
-}
-
-void AProjectile::OnBeginOverlap(UPrimitiveComponent* OverlappedComponent, AActor* Other, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
-{
-	if (IsValid(Other))
-	{
-		Other->TakeDamage(Damage, FDamageEvent(UDamageType::StaticClass()), nullptr, this);
-	}
-
-	Destroy();
-}
-
-
-
-
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Projectile.h"
+#include "Components/SphereComponent.h"
+#include "GameFramework/ProjectileMovementComponent.h"
+#include "Engine/DamageEvents.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
+#include "Net/UnrealNetwork.h"
+#include "UObject/UObjectIterator.h"
+#include "ProjectilePoolSubsystem.h"
+#include "../AI/CrowdBenchmark.h"
+#include "../Arena/ArenaSubsystem.h"
+#include "../Characters/BaseCharacter.h"
+#include "../Combat/LagCompensationSubsystem.h"
+#include "../Combat/OverlapAccounting.h"
+#include "../Telemetry/GameplayMetrics.h"
+#include "../UE5TopDownARPG.h"
+
+DECLARE_CYCLE_STAT(TEXT("Projectile Sweep"), STAT_ProjectileSweep, STATGROUP_ARPG);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Projectile Substeps"), STAT_ProjectileSubsteps, STATGROUP_ARPG);
+
+AProjectile::FOnSweepHit AProjectile::OnSweepHit;
+
+namespace
+{
+	float ProjectileSubstepHz = 60.0f;
+	FAutoConsoleVariableRef CVarProjectileSubstepHz(
+		TEXT("ARPG.Projectile.SubstepHz"),
+		ProjectileSubstepHz,
+		TEXT("Rate of the fixed substeps projectiles sweep on the server, independent of the tick rate. 0 sweeps once per frame."));
+
+	const float TestTickRates[] = { 20.0f, 30.0f, 60.0f };
+	const float TestDuration = 1.0f;
+	const int32 TestNumTargets = 6;
+
+	/** Every rate has a frame on multiples of this, the only times all of them record a character's position. */
+	const float TestSharedFrameSeconds = 0.1f;
+
+	// Hits must agree to within float precision of the world time the histories are recorded in.
+	const double TestHitTimeTolerance = 0.001;
+	const float TestHitDistanceTolerance = 1.0f;
+
+	/** Scripted target motion: runs, then turns or stops, then runs off in another direction. */
+	struct FTargetPath
+	{
+		FVector Start = FVector::ZeroVector;
+
+		/** Velocity of each leg in turn, zero while standing. The last leg never ends. */
+		TArray<FVector, TInlineAllocator<3>> Velocities;
+		TArray<float, TInlineAllocator<3>> Durations;
+
+		FVector GetLocation(float Time) const
+		{
+			FVector Location = Start;
+			for (int32 Leg = 0; Leg < Velocities.Num() && Time > 0.0f; Leg++)
+			{
+				const float LegTime = Leg == Velocities.Num() - 1 ? Time : FMath::Min(Time, Durations[Leg]);
+				Location += Velocities[Leg] * LegTime;
+				Time -= LegTime;
+			}
+			return Location;
+		}
+	};
+
+	struct FTickRateHit
+	{
+		bool bHit = false;
+		/** Index of the scripted target hit, INDEX_NONE for anything else. */
+		int32 Target = INDEX_NONE;
+		/** Seconds since launch, from the substep sweep. */
+		double Time = 0.0;
+		FVector Location = FVector::ZeroVector;
+	};
+
+	/**
+	 * Fires real projectiles through scripted characters on the server, once per tick rate under a fixed
+	 * time step, so the hits come from AProjectile's substep sweeps against lag compensation history.
+	 */
+	struct FProjectileTickRateTest
+	{
+		TWeakObjectPtr<UWorld> World;
+		TWeakObjectPtr<APawn> Shooter;
+		TWeakObjectPtr<UClass> ProjectileClass;
+		TWeakObjectPtr<UClass> EnemyClass;
+		FVector Center = FVector::ZeroVector;
+		FRandomStream Stream;
+		int32 NumTrials = 0;
+
+		// The trial every tick rate replays.
+		int32 Trial = 0;
+		FTransform BoltTransform;
+		TArray<FTargetPath> Paths;
+		TArray<FTickRateHit> RateHits;
+
+		// The tick rate being flown, StartTime is negative until its fixed time step applies.
+		int32 RateIndex = 0;
+		double StartTime = -1.0;
+		TArray<TWeakObjectPtr<ABaseCharacter>> Targets;
+		TWeakObjectPtr<AProjectile> Bolt;
+		FTickRateHit Hit;
+
+		int32 NumHits = 0;
+		int32 NumMismatches = 0;
+		double MaxTimeDifference = 0.0;
+		float MaxDistance = 0.0f;
+
+		bool bOriginalUseFixedTimeStep = false;
+		double OriginalFixedDeltaTime = 0.0;
+		FDelegateHandle TickStartHandle;
+		FDelegateHandle SweepHitHandle;
+	};
+
+	void StartTickRateTrial(FProjectileTickRateTest& Test)
+	{
+		// A fast, thin bolt across a field of characters that turn and stop.
+		const FRotator BoltRotation(0.0f, Test.Stream.FRandRange(-10.0f, 10.0f), 0.0f);
+		Test.BoltTransform = FTransform(BoltRotation, Test.Center + FVector(-2000.0f, Test.Stream.FRandRange(-300.0f, 300.0f), 0.0f));
+
+		Test.Paths.Reset();
+		for (int32 Target = 0; Target < TestNumTargets; Target++)
+		{
+			FTargetPath& Path = Test.Paths.AddDefaulted_GetRef();
+			Path.Start = Test.Center + FVector(Test.Stream.FRandRange(-1500.0f, 2000.0f), Test.Stream.FRandRange(-600.0f, 600.0f), 0.0f);
+
+			// Turns and stops on frames every rate shares, so all of them record the corners of the path. A turn
+			// between 20 Hz frames is smoothed by the 20 Hz history and could not give identical hits.
+			const FVector Velocity = FRotator(0.0f, Test.Stream.FRandRange(-180.0f, 180.0f), 0.0f).Vector() * Test.Stream.FRandRange(200.0f, 600.0f);
+			const bool bStops = Test.Stream.FRand() < 0.5f;
+			Path.Velocities = { Velocity, bStops ? FVector::ZeroVector : Velocity.RotateAngleAxis(Test.Stream.FRandRange(45.0f, 135.0f), FVector::UpVector), -Velocity };
+			Path.Durations = { TestSharedFrameSeconds * Test.Stream.RandRange(1, 5), TestSharedFrameSeconds * Test.Stream.RandRange(1, 3), 0.0f };
+		}
+
+		Test.RateHits.Reset();
+		Test.RateIndex = 0;
+	}
+
+	void StartTickRate(FProjectileTickRateTest& Test)
+	{
+		FApp::SetFixedDeltaTime(1.0 / TestTickRates[Test.RateIndex]);
+		Test.StartTime = -1.0;
+	}
+
+	void SpawnTickRateTargets(FProjectileTickRateTest& Test, UWorld* World)
+	{
+		Test.Targets.Reset();
+		for (const FTargetPath& Path : Test.Paths)
+		{
+			// Without a controller the character stays wherever the path puts it.
+			ABaseCharacter* Character = CrowdBenchmark::SpawnClone(World, Test.EnemyClass.Get(), Path.Start, [](ABaseCharacter& Character)
+			{
+				Character.AutoPossessAI = EAutoPossessAI::Disabled;
+			});
+			Test.Targets.Add(Character);
+		}
+
+		UProjectilePoolSubsystem* ProjectilePool = UProjectilePoolSubsystem::Get(World);
+		Test.Bolt = ProjectilePool ? ProjectilePool->Acquire(Test.ProjectileClass.Get(), Test.BoltTransform, Test.Shooter.Get(), World->GetTimeSeconds()) : nullptr;
+		Test.Hit = FTickRateHit();
+	}
+
+	void FinishTickRateTest(FProjectileTickRateTest& Test)
+	{
+		FApp::SetUseFixedTimeStep(Test.bOriginalUseFixedTimeStep);
+		FApp::SetFixedDeltaTime(Test.OriginalFixedDeltaTime);
+
+		UE_LOG(LogUE5TopDownARPG, Log, TEXT("Projectile hits at 20, 30 and 60 Hz over %d trials, substep %.1f ms:"),
+			Test.Trial, ProjectileSubstepHz > 0.0f ? 1000.0f / ProjectileSubstepHz : 0.0f);
+		UE_LOG(LogUE5TopDownARPG, Log, TEXT("  %d hits, hit times up to %.3f ms and locations up to %.2f units apart"),
+			Test.NumHits, Test.MaxTimeDifference * 1000.0, Test.MaxDistance);
+		if (Test.Trial < Test.NumTrials)
+		{
+			UE_LOG(LogUE5TopDownARPG, Error, TEXT("ARPG.Test.ProjectileTickRates FAILED: the world went away after %d of %d trials"), Test.Trial, Test.NumTrials);
+		}
+		else if (Test.NumMismatches > 0)
+		{
+			UE_LOG(LogUE5TopDownARPG, Error, TEXT("ARPG.Test.ProjectileTickRates FAILED: %d of %d trials differ"), Test.NumMismatches, Test.Trial);
+		}
+		else
+		{
+			UE_LOG(LogUE5TopDownARPG, Log, TEXT("ARPG.Test.ProjectileTickRates PASSED: every rate found the same hit in all %d trials"), Test.Trial);
+		}
+		AProjectile::OnSweepHit.Remove(Test.SweepHitHandle);
+		FWorldDelegates::OnWorldTickStart.Remove(Test.TickStartHandle);
+	}
+
+	void FinishTickRate(FProjectileTickRateTest& Test)
+	{
+		for (const TWeakObjectPtr<ABaseCharacter>& Target : Test.Targets)
+		{
+			if (Target.IsValid())
+			{
+				Target->Destroy();
+			}
+		}
+		Test.Targets.Reset();
+		if (Test.Bolt.IsValid() && Test.Bolt->IsPooled() == false)
+		{
+			UProjectilePoolSubsystem::Release(Test.Bolt.Get());
+		}
+
+		Test.RateHits.Add(Test.Hit);
+		if (++Test.RateIndex < UE_ARRAY_COUNT(TestTickRates))
+		{
+			StartTickRate(Test);
+			return;
+		}
+
+		// Substeps run on the same fixed times at every rate, so the sweeps must find the same hit.
+		const FTickRateHit& Reference = Test.RateHits[0];
+		bool bMismatch = false;
+		for (const FTickRateHit& RateHit : Test.RateHits)
+		{
+			bMismatch |= RateHit.bHit != Reference.bHit || RateHit.Target != Reference.Target;
+			if (RateHit.bHit && Reference.bHit)
+			{
+				const double TimeDifference = FMath::Abs(RateHit.Time - Reference.Time);
+				const float Distance = FVector::Dist(RateHit.Location, Reference.Location);
+				Test.MaxTimeDifference = FMath::Max(Test.MaxTimeDifference, TimeDifference);
+				Test.MaxDistance = FMath::Max(Test.MaxDistance, Distance);
+				bMismatch |= TimeDifference > TestHitTimeTolerance || Distance > TestHitDistanceTolerance;
+			}
+		}
+		Test.NumHits += Reference.bHit ? 1 : 0;
+		Test.NumMismatches += bMismatch ? 1 : 0;
+
+		if (++Test.Trial < Test.NumTrials)
+		{
+			StartTickRateTrial(Test);
+			StartTickRate(Test);
+			return;
+		}
+		FinishTickRateTest(Test);
+	}
+
+	void TickProjectileTickRateTest(FProjectileTickRateTest& Test, UWorld* World, float DeltaSeconds)
+	{
+		// Runs before the world advances its time, so this frame ends at Now + DeltaSeconds.
+		const double Now = World->GetTimeSeconds();
+		if (Test.StartTime < 0.0)
+		{
+			SpawnTickRateTargets(Test, World);
+			Test.StartTime = Now;
+		}
+		else if (Test.Hit.bHit || Now - Test.StartTime >= TestDuration)
+		{
+			FinishTickRate(Test);
+			return;
+		}
+
+		const float FrameEndTime = float(Now + DeltaSeconds - Test.StartTime);
+		for (int32 Target = 0; Target < Test.Targets.Num(); Target++)
+		{
+			if (Test.Targets[Target].IsValid())
+			{
+				Test.Targets[Target]->SetActorLocation(Test.Paths[Target].GetLocation(FrameEndTime), false, nullptr, ETeleportType::TeleportPhysics);
+			}
+		}
+	}
+
+	UClass* FindLoadedProjectileClass()
+	{
+		// Blueprint projectiles carry the speed; the native class does not move.
+		for (TObjectIterator<UClass> It; It; ++It)
+		{
+			if (It->IsChildOf(AProjectile::StaticClass()) && *It != AProjectile::StaticClass()
+				&& It->HasAnyClassFlags(CLASS_Abstract | CLASS_Deprecated | CLASS_NewerVersionExists) == false
+				&& It->GetName().StartsWith(TEXT("SKEL_")) == false && It->GetName().StartsWith(TEXT("REINST_")) == false)
+			{
+				return *It;
+			}
+		}
+		return nullptr;
+	}
+
+	void RunProjectileTickRateTest(const TArray<FString>& Args, UWorld* World)
+	{
+		APlayerController* PlayerController = World ? World->GetFirstPlayerController() : nullptr;
+		APawn* PlayerPawn = PlayerController ? PlayerController->GetPawn() : nullptr;
+		if (PlayerPawn == nullptr || World->GetNetMode() == NM_Client)
+		{
+			UE_LOG(LogUE5TopDownARPG, Log, TEXT("ARPG.Test.ProjectileTickRates needs a local player pawn on the server"));
+			return;
+		}
+
+		ABaseCharacter* Enemy = CrowdBenchmark::FindEnemyToClone(World);
+		UClass* ProjectileClass = FindLoadedProjectileClass();
+		if (Enemy == nullptr || ProjectileClass == nullptr)
+		{
+			UE_LOG(LogUE5TopDownARPG, Log, TEXT("ARPG.Test.ProjectileTickRates needs an enemy in the level and a loaded projectile class"));
+			return;
+		}
+
+		TSharedRef<FProjectileTickRateTest> Test = MakeShared<FProjectileTickRateTest>();
+		Test->NumTrials = FMath::Max(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 50, 1);
+		Test->World = World;
+		Test->Shooter = PlayerPawn;
+		Test->ProjectileClass = ProjectileClass;
+		Test->EnemyClass = Enemy->GetClass();
+		// High above the player, clear of the level and its other characters. The shooter is ignored by its bolts.
+		Test->Center = PlayerPawn->GetActorLocation() + FVector(0.0f, 0.0f, 2000.0f);
+		Test->Stream.Initialize(Test->NumTrials);
+
+		Test->bOriginalUseFixedTimeStep = FApp::UseFixedTimeStep();
+		Test->OriginalFixedDeltaTime = FApp::GetFixedDeltaTime();
+		FApp::SetUseFixedTimeStep(true);
+
+		TWeakPtr<FProjectileTickRateTest> WeakTest = Test;
+		Test->SweepHitHandle = AProjectile::OnSweepHit.AddLambda([WeakTest](const AProjectile* Projectile, const AActor* HitActor, double FlightTime, const FVector& Location)
+		{
+			TSharedPtr<FProjectileTickRateTest> RunningTest = WeakTest.Pin();
+			if (RunningTest.IsValid() && RunningTest->Hit.bHit == false && Projectile == RunningTest->Bolt.Get())
+			{
+				RunningTest->Hit.bHit = true;
+				RunningTest->Hit.Target = RunningTest->Targets.IndexOfByPredicate([HitActor](const TWeakObjectPtr<ABaseCharacter>& Target)
+				{
+					return Target.Get() == HitActor;
+				});
+				RunningTest->Hit.Time = FlightTime;
+				RunningTest->Hit.Location = Location;
+			}
+		});
+
+		StartTickRateTrial(*Test);
+		StartTickRate(*Test);
+		Test->TickStartHandle = FWorldDelegates::OnWorldTickStart.AddLambda([Test](UWorld* TickedWorld, ELevelTick TickType, float DeltaSeconds)
+		{
+			// Finishing removes this lambda and the reference it holds.
+			TSharedRef<FProjectileTickRateTest> RunningTest = Test;
+			if (RunningTest->World.IsValid() == false)
+			{
+				FinishTickRateTest(*RunningTest);
+			}
+			else if (TickedWorld == RunningTest->World.Get())
+			{
+				TickProjectileTickRateTest(*RunningTest, TickedWorld, DeltaSeconds);
+			}
+		});
+	}
+
+	FAutoConsoleCommandWithWorldAndArgs ProjectileTickRateTestCommand(
+		TEXT("ARPG.Test.ProjectileTickRates"),
+		TEXT("Fires projectiles through turning and stopping characters at 20, 30 and 60 Hz fixed server tick rates. Passes when every rate finds the same substep hit. Args: [NumTrials=50]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&RunProjectileTickRateTest));
+}
+
+// Sets default values
+AProjectile::AProjectile()
+{
+ 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
+	PrimaryActorTick.bCanEverTick = true;
+	SetReplicates(true);
+
+	SphereComponent = CreateDefaultSubobject<USphereComponent>(TEXT("CollisionSphereComponent"));
+	// Query-only, overlapping nothing but hurtboxes and level geometry.
+	SphereComponent->SetCollisionProfileName(ARPGCollisionProfiles::Projectile);
+	SphereComponent->SetupAttachment(RootComponent);
+
+	SphereComponent->OnComponentBeginOverlap.AddUniqueDynamic(this, &AProjectile::OnBeginOverlap);
+
+	MovementComponent = CreateDefaultSubobject<UProjectileMovementComponent>(TEXT("MovementComponent"));
+}
+
+bool AProjectile::IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const
+{
+	return UArenaSubsystem::IsNetRelevantFor(this, RealViewer, ViewTarget) && Super::IsNetRelevantFor(RealViewer, ViewTarget, SrcLocation);
+}
+
+void AProjectile::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(AProjectile, LaunchState);
+}
+
+void AProjectile::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// The server resolves hits with sweeps along the trajectory, overlaps only drive what clients see.
+	const bool bSweepHits = HasAuthority();
+	SphereComponent->SetGenerateOverlapEvents(bSweepHits == false);
+	SetActorTickEnabled(bSweepHits);
+
+	if (bSweepHits)
+	{
+		StartFlight();
+	}
+}
+
+void AProjectile::StartFlight()
+{
+	SpawnTime = GetWorld()->GetTimeSeconds();
+	Trajectory.Origin = GetActorLocation();
+	Trajectory.Velocity = MovementComponent->Velocity;
+	Trajectory.Acceleration = FVector(0.0f, 0.0f, MovementComponent->GetGravityZ());
+	Substepper.Reset(ProjectileSubstepHz > 0.0f ? 1.0f / ProjectileSubstepHz : 0.0f);
+
+	LaunchState.Location = GetActorLocation();
+	LaunchState.Rotation = GetActorRotation();
+	LaunchState.Serial = LaunchState.Serial == MAX_uint8 ? 1 : uint8(LaunchState.Serial + 1);
+	LaunchState.bPooled = false;
+}
+
+void AProjectile::Relaunch(const FTransform& Transform, APawn* NewInstigator)
+{
+	SetActorLocationAndRotation(Transform.GetLocation(), Transform.GetRotation(), false, nullptr, ETeleportType::ResetPhysics);
+	SetInstigator(NewInstigator);
+	SetLifeSpan(GetDefault<AProjectile>(GetClass())->InitialLifeSpan);
+	RewindOffset = 0.0f;
+
+	ResetMovement();
+	SetActorTickEnabled(true);
+	StartFlight();
+}
+
+void AProjectile::Deactivate()
+{
+	SetLifeSpan(0.0f);
+	StopMovement();
+	LaunchState.bPooled = true;
+}
+
+void AProjectile::ResetMovement()
+{
+	SetActorHiddenInGame(false);
+	SetActorEnableCollision(true);
+
+	// What UProjectileMovementComponent derives from its defaults when it initializes.
+	const UProjectileMovementComponent* DefaultMovement = GetDefault<AProjectile>(GetClass())->MovementComponent;
+	FVector Velocity = DefaultMovement->Velocity;
+	if (DefaultMovement->InitialSpeed > 0.0f)
+	{
+		Velocity = Velocity.GetSafeNormal() * DefaultMovement->InitialSpeed;
+	}
+	if (DefaultMovement->bInitialVelocityInLocalSpace)
+	{
+		Velocity = GetActorQuat().RotateVector(Velocity);
+	}
+
+	MovementComponent->SetUpdatedComponent(GetRootComponent());
+	MovementComponent->Velocity = Velocity;
+	MovementComponent->UpdateComponentVelocity();
+	MovementComponent->SetComponentTickEnabled(true);
+}
+
+void AProjectile::StopMovement()
+{
+	SetActorHiddenInGame(true);
+	SetActorEnableCollision(false);
+	SetActorTickEnabled(false);
+	MovementComponent->StopMovementImmediately();
+	MovementComponent->SetComponentTickEnabled(false);
+}
+
+void AProjectile::OnRep_LaunchState()
+{
+	// A new channel starts from the spawn transform, only a launch seen after an earlier one is a relaunch.
+	const bool bRelaunched = AppliedLaunchSerial != 0 && AppliedLaunchSerial != LaunchState.Serial;
+	AppliedLaunchSerial = LaunchState.Serial;
+
+	if (LaunchState.bPooled)
+	{
+		StopMovement();
+	}
+	else if (bRelaunched)
+	{
+		SetActorLocationAndRotation(LaunchState.Location, LaunchState.Rotation, false, nullptr, ETeleportType::ResetPhysics);
+		ResetMovement();
+	}
+}
+
+void AProjectile::LifeSpanExpired()
+{
+	UProjectilePoolSubsystem::Release(this);
+}
+
+void AProjectile::SetClientTimestamp(float ClientTimestamp)
+{
+	ULagCompensationSubsystem* LagCompensationSubsystem = GetWorld()->GetSubsystem<ULagCompensationSubsystem>();
+	if (IsValid(LagCompensationSubsystem))
+	{
+		RewindOffset = GetWorld()->GetTimeSeconds() - LagCompensationSubsystem->GetRewindTime(ClientTimestamp);
+	}
+}
+
+void AProjectile::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	Substepper.Advance(DeltaTime, [this](double StartTime, double EndTime)
+	{
+		return SweepSubstep(StartTime, EndTime);
+	});
+}
+
+bool AProjectile::SweepSubstep(double StartTime, double EndTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ProjectileSweep);
+	INC_DWORD_STAT(STAT_ProjectileSubsteps);
+
+	const FVector Start = Trajectory.GetLocation(StartTime);
+	const FVector End = Trajectory.GetLocation(EndTime);
+	const float Radius = SphereComponent->GetScaledSphereRadius();
+	UWorld* World = GetWorld();
+	ULagCompensationSubsystem* LagCompensationSubsystem = World->GetSubsystem<ULagCompensationSubsystem>();
+
+	// Level geometry, plus pawns when there is no position history to test them against.
+	FCollisionObjectQueryParams ObjectParams(ECC_WorldStatic);
+	if (IsValid(LagCompensationSubsystem) == false)
+	{
+		ObjectParams.AddObjectTypesToQuery(ECC_Pawn);
+	}
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(ProjectileSweep), false, this);
+	QueryParams.AddIgnoredActor(GetInstigator());
+
+	AActor* HitActor = nullptr;
+	float HitTime = MAX_flt;
+	FHitResult WorldHit;
+	if (World->SweepSingleByObjectType(WorldHit, Start, End, FQuat::Identity, ObjectParams, FCollisionShape::MakeSphere(Radius), QueryParams))
+	{
+		HitActor = WorldHit.GetActor();
+		HitTime = WorldHit.Time;
+	}
+
+	// Characters where they were at the end of the substep, as the shooter saw them when lag compensated.
+	if (IsValid(LagCompensationSubsystem))
+	{
+		TArray<ULagCompensationSubsystem::FRewoundHit, TInlineAllocator<4>> CharacterHits;
+		LagCompensationSubsystem->FindRewoundHits(Start, End, Radius, float(SpawnTime + EndTime) - RewindOffset, GetInstigator(), CharacterHits);
+		if (CharacterHits.Num() > 0 && CharacterHits[0].Time <= HitTime)
+		{
+			HitActor = CharacterHits[0].Character;
+			HitTime = CharacterHits[0].Time;
+		}
+	}
+
+	if (HitActor == nullptr)
+	{
+		return false;
+	}
+
+	const double HitFlightTime = FMath::Lerp(StartTime, EndTime, double(HitTime));
+	OnSweepHit.Broadcast(this, HitActor, HitFlightTime, Trajectory.GetLocation(HitFlightTime));
+	ApplyHit(HitActor);
+	return true;
+}
+
+void AProjectile::OnBeginOverlap(UPrimitiveComponent* OverlappedComponent, AActor* Other, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
+{
+	OverlapAccounting::RecordOverlap(this, Other);
+
+	ApplyHit(Other);
+}
+
+void AProjectile::ApplyHit(AActor* Other)
+{
+	if (IsValid(Other))
+	{
+		if (Other->IsA<ABaseCharacter>())
+		{
+			GameplayMetrics::Increment(EGameplayCounter::ProjectileHits);
+		}
+		Other->TakeDamage(Damage, FDamageEvent(UDamageType::StaticClass()), nullptr, this);
+	}
+
+	UProjectilePoolSubsystem::Release(this);
+}
+
+
+
+
@@ -1,30 +1,103 @@
-// Fill out your copyright notice in the Description page of Project Settings.
-
-#pragma once
-
-#include "CoreMinimal.h"
-#include "GameFramework/Actor.h"
-#include "Projectile.generated.h"
-
-UCLASS()
-class UE5TOPDOWNARPG_API AProjectile : public AActor
-{
-	GENERATED_BODY()
-	
-public:	
-	// Sets default values for this actor's properties
-	AProjectile();
-
-protected:
-	UFUNCTION()
-	void OnBeginOverlap(UPrimitiveComponent* OverlappedComponent, AActor* Other, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
-	
-	UPROPERTY(EditDefaultsOnly)
-	class USphereComponent* SphereComponent;
-
-	UPROPERTY(EditDefaultsOnly)
-	class UProjectileMovementComponent* MovementComponent;
-
-	UPROPERTY(EditDefaultsOnly)
-	float Damage = 10.0f;
-};
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "Engine/NetSerialization.h"
+#include "ProjectileSweep.h"
+#include "Projectile.generated.h"
+
+/** Where the projectile was last fired from, so clients can fire a pooled projectile again. */
+USTRUCT()
+struct FProjectileLaunch
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FVector_NetQuantize Location;
+
+	UPROPERTY()
+	FRotator Rotation = FRotator::ZeroRotator;
+
+	/** Changes on every launch, never zero once launched. */
+	UPROPERTY()
+	uint8 Serial = 0;
+
+	/** Set while the projectile waits in UProjectilePoolSubsystem. */
+	UPROPERTY()
+	bool bPooled = false;
+};
+
+UCLASS()
+class UE5TOPDOWNARPG_API AProjectile : public AActor
+{
+	GENERATED_BODY()
+	
+public:	
+	// Sets default values for this actor's properties
+	AProjectile();
+
+	virtual void BeginPlay() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual void LifeSpanExpired() override;
+	virtual bool IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const override;
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	/** Judge character hits against where targets were at the shooter's timestamp. Server only, call before FinishSpawning or after Relaunch. */
+	void SetClientTimestamp(float ClientTimestamp);
+
+	/** Fires a pooled projectile again from Transform with its class's initial velocity and lifespan. Server only. */
+	void Relaunch(const FTransform& Transform, APawn* NewInstigator);
+
+	/** Hides the projectile and stops it until Relaunch. Server only. */
+	void Deactivate();
+
+	bool IsPooled() const { return LaunchState.bPooled; }
+
+	/** Every hit found by a server sweep: the projectile, what it hit, the time since launch and the location on the trajectory. */
+	DECLARE_MULTICAST_DELEGATE_FourParams(FOnSweepHit, const AProjectile*, const AActor*, double, const FVector&);
+	static FOnSweepHit OnSweepHit;
+
+protected:
+	UFUNCTION()
+	void OnBeginOverlap(UPrimitiveComponent* OverlappedComponent, AActor* Other, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
+
+	UFUNCTION()
+	void OnRep_LaunchState();
+	
+	UPROPERTY(EditDefaultsOnly)
+	class USphereComponent* SphereComponent;
+
+	UPROPERTY(EditDefaultsOnly)
+	class UProjectileMovementComponent* MovementComponent;
+
+	UPROPERTY(EditDefaultsOnly)
+	float Damage = 10.0f;
+
+	UPROPERTY(ReplicatedUsing = OnRep_LaunchState)
+	FProjectileLaunch LaunchState;
+
+private:
+	/** Starts the server's hit sweeps from the current transform. */
+	void StartFlight();
+
+	/** Shows the projectile and restores the initial velocity for its current rotation. */
+	void ResetMovement();
+	void StopMovement();
+
+	/** Sweeps the trajectory between two times since spawn and applies the earliest hit. */
+	bool SweepSubstep(double StartTime, double EndTime);
+
+	void ApplyHit(AActor* Other);
+
+	/** How far behind server time the shooting client was, zero when not lag compensated. */
+	float RewindOffset = 0.0f;
+
+	/** Launch serial this client last applied. */
+	uint8 AppliedLaunchSerial = 0;
+
+	double SpawnTime = 0.0;
+	FProjectileTrajectory Trajectory;
+	FProjectileSubstepper Substepper;
+};
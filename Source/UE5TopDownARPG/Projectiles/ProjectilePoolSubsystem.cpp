@@ -0,0 +1,123 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ProjectilePoolSubsystem.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Projectile.h"
+#include "../UE5TopDownARPG.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Projectiles Spawned"), STAT_ProjectilesSpawned, STATGROUP_ARPG);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Projectiles Reused"), STAT_ProjectilesReused, STATGROUP_ARPG);
+
+namespace
+{
+	bool bProjectilePoolEnabled = true;
+	FAutoConsoleVariableRef CVarProjectilePool(
+		TEXT("ARPG.Projectile.Pool"),
+		bProjectilePoolEnabled,
+		TEXT("Reuses projectiles that hit or expired instead of destroying them."));
+
+	int32 ProjectilePoolSize = 256;
+	FAutoConsoleVariableRef CVarProjectilePoolSize(
+		TEXT("ARPG.Projectile.PoolSize"),
+		ProjectilePoolSize,
+		TEXT("Most idle projectiles kept per world, the rest are destroyed."));
+
+	void LogProjectilePoolReport(UWorld* World)
+	{
+		if (UProjectilePoolSubsystem* Pool = UProjectilePoolSubsystem::Get(World))
+		{
+			Pool->LogReport();
+		}
+	}
+
+	FAutoConsoleCommandWithWorld ProjectilePoolReportCommand(
+		TEXT("ARPG.ProjectilePoolReport"),
+		TEXT("Logs how many projectiles were spawned, reused and are waiting in the pool."),
+		FConsoleCommandWithWorldDelegate::CreateStatic(&LogProjectilePoolReport));
+}
+
+bool UProjectilePoolSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	UWorld* World = Cast<UWorld>(Outer);
+	return Super::ShouldCreateSubsystem(Outer) && IsValid(World) && World->IsGameWorld();
+}
+
+UProjectilePoolSubsystem* UProjectilePoolSubsystem::Get(const UObject* WorldContextObject)
+{
+	UWorld* World = IsValid(WorldContextObject) ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UProjectilePoolSubsystem>() : nullptr;
+}
+
+AProjectile* UProjectilePoolSubsystem::Acquire(TSubclassOf<AProjectile> ProjectileClass, const FTransform& Transform, APawn* Instigator, float ClientTimestamp)
+{
+	if (ProjectileClass == nullptr)
+	{
+		return nullptr;
+	}
+
+	// Newest first, the arena restart or a level unload may have destroyed some of them.
+	for (int32 Index = Pooled.Num() - 1; Index >= 0; Index--)
+	{
+		AProjectile* Projectile = Pooled[Index];
+		if (IsValid(Projectile) == false)
+		{
+			Pooled.RemoveAtSwap(Index, 1, false);
+			continue;
+		}
+
+		if (Projectile->GetClass() == ProjectileClass)
+		{
+			Pooled.RemoveAtSwap(Index, 1, false);
+			Projectile->Relaunch(Transform, Instigator);
+			Projectile->SetClientTimestamp(ClientTimestamp);
+			NumReused++;
+			INC_DWORD_STAT(STAT_ProjectilesReused);
+			return Projectile;
+		}
+	}
+
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	SpawnParameters.Instigator = Instigator;
+	SpawnParameters.bDeferConstruction = true;
+
+	AProjectile* Projectile = GetWorld()->SpawnActor<AProjectile>(ProjectileClass, Transform, SpawnParameters);
+	if (IsValid(Projectile) == false)
+	{
+		return nullptr;
+	}
+
+	// The server rewinds targets to the client's timestamp when judging the projectile's hits.
+	Projectile->SetClientTimestamp(ClientTimestamp);
+	Projectile->FinishSpawning(Transform);
+	NumSpawned++;
+	INC_DWORD_STAT(STAT_ProjectilesSpawned);
+	return Projectile;
+}
+
+void UProjectilePoolSubsystem::Release(AProjectile* Projectile)
+{
+	if (IsValid(Projectile) == false || Projectile->HasAuthority() == false || Projectile->IsPooled())
+	{
+		return;
+	}
+
+	UProjectilePoolSubsystem* Pool = Get(Projectile);
+	if (bProjectilePoolEnabled == false || IsValid(Pool) == false || Pool->Pooled.Num() >= ProjectilePoolSize)
+	{
+		Projectile->Destroy();
+		return;
+	}
+
+	Projectile->Deactivate();
+	Pool->Pooled.Add(Projectile);
+}
+
+void UProjectilePoolSubsystem::LogReport() const
+{
+	const int32 NumFired = NumSpawned + NumReused;
+	UE_LOG(LogUE5TopDownARPG, Log, TEXT("Projectile pool: %d fired, %d spawned, %d reused (%.0f%%), %d idle"),
+		NumFired, NumSpawned, NumReused, NumFired > 0 ? 100.0f * NumReused / NumFired : 0.0f, Pooled.Num());
+}
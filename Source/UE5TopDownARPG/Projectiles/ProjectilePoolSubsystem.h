@@ -0,0 +1,40 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ProjectilePoolSubsystem.generated.h"
+
+/**
+ * Keeps projectiles that hit or expired on the server and fires them again, so a steady stream of
+ * bolts does not create and destroy an actor per cast. A pooled projectile is hidden without collision,
+ * which also makes it irrelevant to every connection until it is fired again.
+ */
+UCLASS()
+class UE5TOPDOWNARPG_API UProjectilePoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+
+	static UProjectilePoolSubsystem* Get(const UObject* WorldContextObject);
+
+	/** Fires a pooled projectile of exactly this class, or spawns one. Server only. */
+	class AProjectile* Acquire(TSubclassOf<class AProjectile> ProjectileClass, const FTransform& Transform, APawn* Instigator, float ClientTimestamp);
+
+	/** Returns the projectile to its world's pool, or destroys it when pooling is off or the pool is full. Ignored on clients. */
+	static void Release(class AProjectile* Projectile);
+
+	int32 GetNumPooled() const { return Pooled.Num(); }
+
+	void LogReport() const;
+
+private:
+	UPROPERTY(Transient)
+	TArray<class AProjectile*> Pooled;
+
+	int32 NumSpawned = 0;
+	int32 NumReused = 0;
+};
@@ -0,0 +1,69 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Ballistic path of a projectile from its spawn, so any point on it can be evaluated exactly. */
+struct FProjectileTrajectory
+{
+	FVector Origin = FVector::ZeroVector;
+	FVector Velocity = FVector::ZeroVector;
+	FVector Acceleration = FVector::ZeroVector;
+
+	FVector GetLocation(double Time) const
+	{
+		return Origin + Velocity * Time + 0.5 * Acceleration * Time * Time;
+	}
+};
+
+/**
+ * Splits frame time into fixed substeps measured from the projectile's spawn. Substep boundaries
+ * do not depend on the frame rate, so sweeping each substep finds the same hits at any tick rate.
+ * A substep of zero sweeps once per frame instead.
+ */
+class FProjectileSubstepper
+{
+public:
+	void Reset(float InSubstepSeconds)
+	{
+		SubstepSeconds = InSubstepSeconds;
+		PendingTime = 0.0;
+		SimulatedTime = 0.0;
+		NumSubsteps = 0;
+	}
+
+	/** Calls Sweep with the start and end time of each completed substep, oldest first, until it reports a hit. */
+	template<typename SweepType>
+	bool Advance(float DeltaTime, SweepType&& Sweep)
+	{
+		PendingTime += DeltaTime;
+		if (SubstepSeconds <= 0.0f)
+		{
+			const double StartTime = SimulatedTime;
+			SimulatedTime += PendingTime;
+			PendingTime = 0.0;
+			return Sweep(StartTime, SimulatedTime);
+		}
+
+		// The tolerance keeps frame times that are exact multiples of the substep from losing one to rounding.
+		while (PendingTime + UE_KINDA_SMALL_NUMBER >= SubstepSeconds)
+		{
+			PendingTime -= SubstepSeconds;
+			const double StartTime = NumSubsteps * double(SubstepSeconds);
+			NumSubsteps++;
+			SimulatedTime = NumSubsteps * double(SubstepSeconds);
+			if (Sweep(StartTime, SimulatedTime))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+private:
+	float SubstepSeconds = 0.0f;
+	double PendingTime = 0.0;
+	double SimulatedTime = 0.0;
+	int32 NumSubsteps = 0;
+};
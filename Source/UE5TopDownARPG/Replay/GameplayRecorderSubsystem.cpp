@@ -0,0 +1,398 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GameplayRecorderSubsystem.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "../Pickups/PickupSubsystem.h"
+#include "../UE5TopDownARPGPlayerController.h"
+#include "../UE5TopDownARPG.h"
+
+const uint32 UGameplayRecorderSubsystem::FileMagic = 0x52505241; // "ARPR"
+const uint16 UGameplayRecorderSubsystem::FileVersion = 2;
+
+namespace
+{
+	void StartRecording(UWorld* World)
+	{
+		if (UGameplayRecorderSubsystem* Recorder = UGameplayRecorderSubsystem::Get(World))
+		{
+			Recorder->StartRecording();
+		}
+	}
+
+	void StopRecording(UWorld* World)
+	{
+		if (UGameplayRecorderSubsystem* Recorder = UGameplayRecorderSubsystem::Get(World))
+		{
+			Recorder->StopRecording();
+		}
+	}
+
+	FAutoConsoleCommandWithWorld RecordStartCommand(
+		TEXT("ARPG.Record.Start"),
+		TEXT("Starts recording input, ability activations, spawn waves and random seeds."),
+		FConsoleCommandWithWorldDelegate::CreateStatic(&StartRecording));
+
+	FAutoConsoleCommandWithWorld RecordStopCommand(
+		TEXT("ARPG.Record.Stop"),
+		TEXT("Stops recording and writes the stream to Saved/Recordings."),
+		FConsoleCommandWithWorldDelegate::CreateStatic(&StopRecording));
+
+	struct FEventSerializer
+	{
+		template<typename EventType>
+		static void Serialize(FArchive& Ar, EventType& Event)
+		{
+			uint8 Type = (uint8)Event.Type;
+			Ar << Type;
+			Event.Type = (EGameplayRecordEvent)Type;
+			Ar << Event.Time;
+
+			switch (Event.Type)
+			{
+			case EGameplayRecordEvent::RandomSeeds:
+				Ar << Event.Id;
+				Ar << Event.Value;
+				break;
+
+			case EGameplayRecordEvent::DestinationTriggered:
+				Ar << Event.bHit;
+				Ar << Event.Location;
+				Ar << Event.DeltaSeconds;
+				break;
+
+			case EGameplayRecordEvent::ActivateAbilityInput:
+				Ar << Event.Location;
+				break;
+
+			case EGameplayRecordEvent::AbilityActivated:
+				Ar << Event.Id;
+				Ar << Event.Location;
+				break;
+
+			case EGameplayRecordEvent::SpawnWave:
+			{
+				Ar << Event.Id;
+				uint32 Wave = Event.Value;
+				Ar.SerializeIntPacked(Wave);
+				Event.Value = Wave;
+				break;
+			}
+
+			default:
+				break;
+			}
+		}
+	};
+}
+
+bool UGameplayRecorderSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	UWorld* World = Cast<UWorld>(Outer);
+	return Super::ShouldCreateSubsystem(Outer) && IsValid(World) && World->IsGameWorld();
+}
+
+void UGameplayRecorderSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	// The loot seed is overridden on replay, so the pickup subsystem must exist first.
+	Collection.InitializeDependency<UPickupSubsystem>();
+
+	FString ReplayPath;
+	if (FParse::Value(FCommandLine::Get(), TEXT("ARPGReplay="), ReplayPath))
+	{
+		if (LoadRecording(ReplayPath))
+		{
+			StartReplay();
+		}
+	}
+	else if (FParse::Param(FCommandLine::Get(), TEXT("ARPGRecord")))
+	{
+		StartRecording();
+	}
+}
+
+void UGameplayRecorderSubsystem::Deinitialize()
+{
+	if (bIsRecording)
+	{
+		StopRecording();
+	}
+
+	Super::Deinitialize();
+}
+
+UGameplayRecorderSubsystem* UGameplayRecorderSubsystem::Get(const UObject* WorldContextObject)
+{
+	UWorld* World = IsValid(WorldContextObject) ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UGameplayRecorderSubsystem>() : nullptr;
+}
+
+void UGameplayRecorderSubsystem::StartRecording()
+{
+	if (bIsRecording || bIsReplaying)
+	{
+		return;
+	}
+
+	Stream.Reset();
+	FMemoryWriter Writer(Stream);
+	uint32 Magic = FileMagic;
+	uint16 Version = FileVersion;
+	Writer << Magic;
+	Writer << Version;
+
+	bIsRecording = true;
+	StreamStartTime = GetWorld()->GetTimeSeconds();
+
+	// Reseed the global generators so the replay can reproduce them.
+	const int32 Seed = FMath::Rand();
+	FMath::RandInit(Seed);
+	FMath::SRandInit(Seed);
+
+	FRecordedEvent SeedEvent;
+	SeedEvent.Type = EGameplayRecordEvent::RandomSeeds;
+	SeedEvent.Time = 0.0f;
+	SeedEvent.Id = Seed;
+	SeedEvent.Value = GetWorld()->GetSubsystem<UPickupSubsystem>()->GetLootSeed();
+	WriteEvent(SeedEvent);
+
+	UE_LOG(LogUE5TopDownARPG, Log, TEXT("Recording started"));
+}
+
+void UGameplayRecorderSubsystem::StopRecording()
+{
+	if (bIsRecording == false)
+	{
+		return;
+	}
+
+	bIsRecording = false;
+
+	const FString FilePath = FPaths::ProjectSavedDir() / TEXT("Recordings") / FString::Printf(TEXT("Session-%s.arpgrec"), *FDateTime::Now().ToString());
+	if (FFileHelper::SaveArrayToFile(Stream, *FilePath))
+	{
+		UE_LOG(LogUE5TopDownARPG, Log, TEXT("Recording saved to %s (%d bytes)"), *FilePath, Stream.Num());
+	}
+	else
+	{
+		UE_LOG(LogUE5TopDownARPG, Error, TEXT("Failed to save recording to %s"), *FilePath);
+	}
+	Stream.Empty();
+}
+
+void UGameplayRecorderSubsystem::RecordInput(EGameplayRecordEvent Event, bool bHit, const FVector& Location, float DeltaSeconds)
+{
+	if (bIsRecording == false)
+	{
+		return;
+	}
+
+	FRecordedEvent InputEvent;
+	InputEvent.Type = Event;
+	InputEvent.Time = GetStreamTime();
+	InputEvent.bHit = bHit;
+	InputEvent.Location = FVector3f(Location);
+	InputEvent.DeltaSeconds = DeltaSeconds;
+	WriteEvent(InputEvent);
+}
+
+void UGameplayRecorderSubsystem::RecordAbilityActivation(const AActor* Instigator, const FVector& Location)
+{
+	if (bIsReplaying)
+	{
+		ObservedCounts[(int32)EGameplayRecordEvent::AbilityActivated]++;
+	}
+
+	if (bIsRecording)
+	{
+		FRecordedEvent AbilityEvent;
+		AbilityEvent.Type = EGameplayRecordEvent::AbilityActivated;
+		AbilityEvent.Time = GetStreamTime();
+		AbilityEvent.Id = GetStableId(Instigator);
+		AbilityEvent.Location = FVector3f(Location);
+		WriteEvent(AbilityEvent);
+	}
+}
+
+void UGameplayRecorderSubsystem::RecordSpawnWave(const AActor* SpawnTrigger, int32 Wave)
+{
+	if (bIsReplaying)
+	{
+		ObservedCounts[(int32)EGameplayRecordEvent::SpawnWave]++;
+	}
+
+	if (bIsRecording)
+	{
+		FRecordedEvent WaveEvent;
+		WaveEvent.Type = EGameplayRecordEvent::SpawnWave;
+		WaveEvent.Time = GetStreamTime();
+		WaveEvent.Id = GetStableId(SpawnTrigger);
+		WaveEvent.Value = Wave;
+		WriteEvent(WaveEvent);
+	}
+}
+
+void UGameplayRecorderSubsystem::WriteEvent(const FRecordedEvent& Event)
+{
+	FMemoryWriter Writer(Stream);
+	Writer.Seek(Stream.Num());
+
+	FRecordedEvent EventCopy = Event;
+	FEventSerializer::Serialize(Writer, EventCopy);
+}
+
+bool UGameplayRecorderSubsystem::LoadRecording(const FString& FilePath)
+{
+	TArray<uint8> FileData;
+	if (FFileHelper::LoadFileToArray(FileData, *FilePath) == false)
+	{
+		UE_LOG(LogUE5TopDownARPG, Error, TEXT("Failed to read recording %s"), *FilePath);
+		return false;
+	}
+
+	FMemoryReader Reader(FileData);
+	uint32 Magic = 0;
+	uint16 Version = 0;
+	Reader << Magic;
+	Reader << Version;
+	if (Magic != FileMagic || Version != FileVersion)
+	{
+		UE_LOG(LogUE5TopDownARPG, Error, TEXT("%s is not a version %d gameplay recording"), *FilePath, FileVersion);
+		return false;
+	}
+
+	ReplayEvents.Reset();
+	while (Reader.AtEnd() == false)
+	{
+		FRecordedEvent Event;
+		FEventSerializer::Serialize(Reader, Event);
+		if (Reader.IsError() || Event.Type >= EGameplayRecordEvent::Max)
+		{
+			UE_LOG(LogUE5TopDownARPG, Error, TEXT("Recording %s is truncated"), *FilePath);
+			break;
+		}
+
+		RecordedCounts[(int32)Event.Type]++;
+		ReplayEvents.Add(Event);
+	}
+
+	UE_LOG(LogUE5TopDownARPG, Log, TEXT("Loaded recording %s: %d events"), *FilePath, ReplayEvents.Num());
+	return ReplayEvents.Num() > 0;
+}
+
+void UGameplayRecorderSubsystem::StartReplay()
+{
+	int32 ReplayFPS = 30;
+	FParse::Value(FCommandLine::Get(), TEXT("ARPGReplayFPS="), ReplayFPS);
+	bExitAfterReplay = FParse::Param(FCommandLine::Get(), TEXT("ARPGReplayExit"));
+
+	FApp::SetUseFixedTimeStep(true);
+	FApp::SetFixedDeltaTime(1.0 / FMath::Max(ReplayFPS, 1));
+
+	// Seeds must be in place before anything rolls.
+	NextReplayEvent = 0;
+	while (ReplayEvents.IsValidIndex(NextReplayEvent) && ReplayEvents[NextReplayEvent].Type == EGameplayRecordEvent::RandomSeeds)
+	{
+		DispatchReplayEvent(ReplayEvents[NextReplayEvent++]);
+	}
+
+	bIsReplaying = true;
+	StreamStartTime = -1.0;
+}
+
+void UGameplayRecorderSubsystem::Tick(float DeltaTime)
+{
+	if (bIsReplaying == false)
+	{
+		return;
+	}
+
+	if (StreamStartTime < 0.0)
+	{
+		StreamStartTime = GetWorld()->GetTimeSeconds();
+		GEngine->Exec(GetWorld(), TEXT("CsvProfile Start"));
+	}
+
+	const float StreamTime = GetStreamTime();
+	while (ReplayEvents.IsValidIndex(NextReplayEvent) && ReplayEvents[NextReplayEvent].Time <= StreamTime)
+	{
+		DispatchReplayEvent(ReplayEvents[NextReplayEvent++]);
+	}
+
+	// Give the last events a moment to play out before stopping the capture.
+	if (NextReplayEvent >= ReplayEvents.Num() && StreamTime > ReplayEvents.Last().Time + 1.0f)
+	{
+		FinishReplay();
+	}
+}
+
+TStatId UGameplayRecorderSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UGameplayRecorderSubsystem, STATGROUP_Tickables);
+}
+
+void UGameplayRecorderSubsystem::DispatchReplayEvent(const FRecordedEvent& Event)
+{
+	switch (Event.Type)
+	{
+	case EGameplayRecordEvent::RandomSeeds:
+		FMath::RandInit(Event.Id);
+		FMath::SRandInit(Event.Id);
+		GetWorld()->GetSubsystem<UPickupSubsystem>()->SetLootSeed(Event.Value);
+		break;
+
+	case EGameplayRecordEvent::InputStarted:
+	case EGameplayRecordEvent::DestinationTriggered:
+	case EGameplayRecordEvent::DestinationReleased:
+	case EGameplayRecordEvent::ActivateAbilityInput:
+	{
+		AUE5TopDownARPGPlayerController* PlayerController = Cast<AUE5TopDownARPGPlayerController>(GetWorld()->GetFirstPlayerController());
+		if (IsValid(PlayerController))
+		{
+			PlayerController->ReplayInput(Event.Type, Event.bHit, FVector(Event.Location), Event.DeltaSeconds);
+		}
+		break;
+	}
+
+	default:
+		// Ability activations and spawn waves are only compared, they happen on their own.
+		break;
+	}
+}
+
+void UGameplayRecorderSubsystem::FinishReplay()
+{
+	bIsReplaying = false;
+	GEngine->Exec(GetWorld(), TEXT("CsvProfile Stop"));
+	FApp::SetUseFixedTimeStep(false);
+
+	UE_LOG(LogUE5TopDownARPG, Log, TEXT("Replay finished: %d/%d ability activations, %d/%d spawn waves observed/recorded"),
+		ObservedCounts[(int32)EGameplayRecordEvent::AbilityActivated], RecordedCounts[(int32)EGameplayRecordEvent::AbilityActivated],
+		ObservedCounts[(int32)EGameplayRecordEvent::SpawnWave], RecordedCounts[(int32)EGameplayRecordEvent::SpawnWave]);
+
+	if (bExitAfterReplay)
+	{
+		FPlatformMisc::RequestExit(false);
+	}
+}
+
+float UGameplayRecorderSubsystem::GetStreamTime() const
+{
+	return GetWorld()->GetTimeSeconds() - StreamStartTime;
+}
+
+uint32 UGameplayRecorderSubsystem::GetStableId(const AActor* Actor)
+{
+	// Names of spawned actors follow spawn order, so they match between a recording and its replay.
+	return IsValid(Actor) ? FCrc::StrCrc32(*Actor->GetName()) : 0;
+}
@@ -0,0 +1,89 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "GameplayRecorderSubsystem.generated.h"
+
+enum class EGameplayRecordEvent : uint8
+{
+	RandomSeeds,
+	InputStarted,
+	DestinationTriggered,
+	DestinationReleased,
+	ActivateAbilityInput,
+	AbilityActivated,
+	SpawnWave,
+	Max
+};
+
+/**
+ * Records player input, ability activations, spawn waves and random seeds into a compact binary stream,
+ * and replays a recording at a fixed timestep so a hitching session can be profiled again.
+ *
+ * Record: -ARPGRecord on the command line, or ARPG.Record.Start / ARPG.Record.Stop.
+ * Replay: -ARPGReplay=<file> [-ARPGReplayFPS=30] [-ARPGReplayExit], typically with -nullrhi.
+ */
+UCLASS()
+class UE5TOPDOWNARPG_API UGameplayRecorderSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	static UGameplayRecorderSubsystem* Get(const UObject* WorldContextObject);
+
+	void StartRecording();
+	void StopRecording();
+
+	bool IsRecording() const { return bIsRecording; }
+	bool IsReplaying() const { return bIsReplaying; }
+
+	/** DeltaSeconds is the frame time a held destination input accumulated, replayed as recorded at any timestep. */
+	void RecordInput(EGameplayRecordEvent Event, bool bHit = false, const FVector& Location = FVector::ZeroVector, float DeltaSeconds = 0.0f);
+	void RecordAbilityActivation(const AActor* Instigator, const FVector& Location);
+	void RecordSpawnWave(const AActor* SpawnTrigger, int32 Wave);
+
+private:
+	struct FRecordedEvent
+	{
+		EGameplayRecordEvent Type;
+		float Time;
+		bool bHit = false;
+		FVector3f Location = FVector3f::ZeroVector;
+		float DeltaSeconds = 0.0f;
+		uint32 Id = 0;
+		int32 Value = 0;
+	};
+
+	static const uint32 FileMagic;
+	static const uint16 FileVersion;
+
+	void WriteEvent(const FRecordedEvent& Event);
+	bool LoadRecording(const FString& FilePath);
+	void StartReplay();
+	void FinishReplay();
+	void DispatchReplayEvent(const FRecordedEvent& Event);
+
+	float GetStreamTime() const;
+	static uint32 GetStableId(const AActor* Actor);
+
+	TArray<uint8> Stream;
+	TArray<FRecordedEvent> ReplayEvents;
+	int32 NextReplayEvent = 0;
+
+	/** Events observed while replaying, per type, to spot divergence from the recording. */
+	int32 RecordedCounts[(int32)EGameplayRecordEvent::Max] = {};
+	int32 ObservedCounts[(int32)EGameplayRecordEvent::Max] = {};
+
+	double StreamStartTime = 0.0;
+	bool bIsRecording = false;
+	bool bIsReplaying = false;
+	bool bExitAfterReplay = false;
+};
@@ -0,0 +1,209 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GameplayWorkScheduler.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "../Telemetry/GameplayMetrics.h"
+#include "../UE5TopDownARPG.h"
+
+DECLARE_CYCLE_STAT(TEXT("Scheduler Tick"), STAT_SchedulerTick, STATGROUP_ARPG);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Scheduled Work Run"), STAT_ScheduledWorkRun, STATGROUP_ARPG);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Scheduled Work Queued"), STAT_ScheduledWorkQueued, STATGROUP_ARPG);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Scheduler Budget Used %"), STAT_SchedulerBudgetUsed, STATGROUP_ARPG);
+
+namespace
+{
+	float SchedulerBudgetMs = 1.0f;
+	FAutoConsoleVariableRef CVarSchedulerBudgetMs(
+		TEXT("ARPG.Scheduler.BudgetMs"),
+		SchedulerBudgetMs,
+		TEXT("Time per frame spent on deferred gameplay work. At least one item runs every frame."));
+
+	float SchedulerMaxLatencyMs = 250.0f;
+	FAutoConsoleVariableRef CVarSchedulerMaxLatencyMs(
+		TEXT("ARPG.Scheduler.MaxLatencyMs"),
+		SchedulerMaxLatencyMs,
+		TEXT("Work waiting longer than this runs before higher priority work."));
+
+	const TCHAR* PriorityNames[] = { TEXT("High"), TEXT("Normal"), TEXT("Low") };
+
+	void LogSchedulerReport(UWorld* World)
+	{
+		if (UGameplayWorkScheduler* Scheduler = UGameplayWorkScheduler::Get(World))
+		{
+			Scheduler->LogReport();
+		}
+	}
+
+	FAutoConsoleCommandWithWorld SchedulerReportCommand(
+		TEXT("ARPG.SchedulerReport"),
+		TEXT("Logs gameplay work budget utilization and queue latency percentiles."),
+		FConsoleCommandWithWorldDelegate::CreateStatic(&LogSchedulerReport));
+}
+
+void UGameplayWorkScheduler::FWorkQueue::Compact()
+{
+	if (IsEmpty())
+	{
+		Items.Reset();
+		Head = 0;
+	}
+	else if (Head > 64 && Head > Items.Num() / 2)
+	{
+		Items.RemoveAt(0, Head, false);
+		Head = 0;
+	}
+}
+
+UGameplayWorkScheduler* UGameplayWorkScheduler::Get(const UObject* WorldContextObject)
+{
+	UWorld* World = IsValid(WorldContextObject) ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UGameplayWorkScheduler>() : nullptr;
+}
+
+void UGameplayWorkScheduler::Submit(EGameplayWorkPriority Priority, const UObject* Owner, TUniqueFunction<void()>&& Work)
+{
+	Queues[(int32)Priority].Items.Add({ Owner, MoveTemp(Work), FPlatformTime::Seconds() });
+}
+
+void UGameplayWorkScheduler::SubmitOrRun(const UObject* Owner, EGameplayWorkPriority Priority, TUniqueFunction<void()>&& Work)
+{
+	if (UGameplayWorkScheduler* Scheduler = Get(Owner))
+	{
+		Scheduler->Submit(Priority, Owner, MoveTemp(Work));
+	}
+	else
+	{
+		Work();
+	}
+}
+
+int32 UGameplayWorkScheduler::GetNumQueued() const
+{
+	int32 NumQueued = 0;
+	for (const FWorkQueue& Queue : Queues)
+	{
+		NumQueued += Queue.Items.Num() - Queue.Head;
+	}
+	return NumQueued;
+}
+
+void UGameplayWorkScheduler::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SchedulerTick);
+
+	const double StartTime = FPlatformTime::Seconds();
+	const double EndTime = StartTime + SchedulerBudgetMs / 1000.0;
+	bool bRanAny = false;
+
+	while (bRanAny == false || FPlatformTime::Seconds() < EndTime)
+	{
+		int32 QueueIndex = FindStarvingQueue(FPlatformTime::Seconds());
+		for (int32 Index = 0; QueueIndex == INDEX_NONE && Index < UE_ARRAY_COUNT(Queues); Index++)
+		{
+			if (Queues[Index].IsEmpty() == false)
+			{
+				QueueIndex = Index;
+			}
+		}
+
+		if (QueueIndex == INDEX_NONE)
+		{
+			break;
+		}
+
+		// Move the item out first, the work may submit more.
+		FWorkItem Item = MoveTemp(Queues[QueueIndex].Front());
+		Queues[QueueIndex].Head++;
+		RunItem((EGameplayWorkPriority)QueueIndex, Item);
+		bRanAny = true;
+	}
+
+	for (FWorkQueue& Queue : Queues)
+	{
+		Queue.Compact();
+	}
+
+	const int32 NumQueued = GetNumQueued();
+	const float Utilization = SchedulerBudgetMs > 0.0f ? float((FPlatformTime::Seconds() - StartTime) * 1000.0 / SchedulerBudgetMs) : 0.0f;
+	if (bRanAny)
+	{
+		if (FrameUtilization.Num() < HistorySize)
+		{
+			FrameUtilization.Add(Utilization);
+		}
+		else
+		{
+			FrameUtilization[FrameHistoryIndex] = Utilization;
+		}
+		FrameHistoryIndex = (FrameHistoryIndex + 1) % HistorySize;
+		NumFrames++;
+		NumCarriedOverFrames += NumQueued > 0 ? 1 : 0;
+	}
+
+	SET_DWORD_STAT(STAT_ScheduledWorkQueued, NumQueued);
+	SET_FLOAT_STAT(STAT_SchedulerBudgetUsed, Utilization * 100.0f);
+}
+
+TStatId UGameplayWorkScheduler::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UGameplayWorkScheduler, STATGROUP_Tickables);
+}
+
+int32 UGameplayWorkScheduler::FindStarvingQueue(double Now) const
+{
+	for (int32 Index = UE_ARRAY_COUNT(Queues) - 1; Index > 0; Index--)
+	{
+		const FWorkQueue& Queue = Queues[Index];
+		if (Queue.IsEmpty() == false && (Now - Queue.Items[Queue.Head].SubmitTime) * 1000.0 > SchedulerMaxLatencyMs)
+		{
+			return Index;
+		}
+	}
+	return INDEX_NONE;
+}
+
+void UGameplayWorkScheduler::RunItem(EGameplayWorkPriority Priority, FWorkItem& Item)
+{
+	if (Item.Owner.IsValid() == false)
+	{
+		return;
+	}
+
+	const int32 PriorityIndex = (int32)Priority;
+	const float LatencyMs = float((FPlatformTime::Seconds() - Item.SubmitTime) * 1000.0);
+	TArray<float>& Latencies = QueueLatencyMs[PriorityIndex];
+	if (Latencies.Num() < HistorySize)
+	{
+		Latencies.Add(LatencyMs);
+	}
+	else
+	{
+		Latencies[LatencyHistoryIndex[PriorityIndex]] = LatencyMs;
+	}
+	LatencyHistoryIndex[PriorityIndex] = (LatencyHistoryIndex[PriorityIndex] + 1) % HistorySize;
+
+	Item.Work();
+	INC_DWORD_STAT(STAT_ScheduledWorkRun);
+}
+
+void UGameplayWorkScheduler::LogReport() const
+{
+	UE_LOG(LogUE5TopDownARPG, Log, TEXT("Scheduler budget %.2f ms: utilization p50 %.0f%%, p95 %.0f%%, max %.0f%%, carried over in %d of %d busy frames"),
+		SchedulerBudgetMs,
+		GameplayMetrics::GetPercentile(FrameUtilization, 0.5f) * 100.0f,
+		GameplayMetrics::GetPercentile(FrameUtilization, 0.95f) * 100.0f,
+		GameplayMetrics::GetPercentile(FrameUtilization, 1.0f) * 100.0f,
+		NumCarriedOverFrames, NumFrames);
+
+	for (int32 Index = 0; Index < UE_ARRAY_COUNT(Queues); Index++)
+	{
+		UE_LOG(LogUE5TopDownARPG, Log, TEXT("  %s: %d queued, latency p50 %.2f ms, p95 %.2f ms, p99 %.2f ms"),
+			PriorityNames[Index],
+			Queues[Index].Items.Num() - Queues[Index].Head,
+			GameplayMetrics::GetPercentile(QueueLatencyMs[Index], 0.5f),
+			GameplayMetrics::GetPercentile(QueueLatencyMs[Index], 0.95f),
+			GameplayMetrics::GetPercentile(QueueLatencyMs[Index], 0.99f));
+	}
+}
@@ -0,0 +1,77 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "GameplayWorkScheduler.generated.h"
+
+enum class EGameplayWorkPriority : uint8
+{
+	/** Visible to players right away, such as spawning a wave. */
+	High,
+	/** Gameplay consequences that may slip a few frames, such as death and loot. */
+	Normal,
+	/** Refreshes and cosmetics, such as AI target searches and effects. */
+	Low,
+	Num
+};
+
+/**
+ * Runs deferrable gameplay work under a per-frame time budget. Work is taken by priority,
+ * oldest first, and whatever does not fit carries over to the next frame. Work that waited
+ * longer than ARPG.Scheduler.MaxLatencyMs runs ahead of higher priorities so nothing starves.
+ */
+UCLASS()
+class UE5TOPDOWNARPG_API UGameplayWorkScheduler : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	static UGameplayWorkScheduler* Get(const UObject* WorldContextObject);
+
+	/** Queues Work. It is dropped if Owner is destroyed before it runs. */
+	void Submit(EGameplayWorkPriority Priority, const UObject* Owner, TUniqueFunction<void()>&& Work);
+
+	/** Submits through the world's scheduler, or runs Work right away when there is none. */
+	static void SubmitOrRun(const UObject* Owner, EGameplayWorkPriority Priority, TUniqueFunction<void()>&& Work);
+
+	int32 GetNumQueued() const;
+
+	void LogReport() const;
+
+private:
+	struct FWorkItem
+	{
+		TWeakObjectPtr<const UObject> Owner;
+		TUniqueFunction<void()> Work;
+		double SubmitTime;
+	};
+
+	struct FWorkQueue
+	{
+		TArray<FWorkItem> Items;
+		int32 Head = 0;
+
+		bool IsEmpty() const { return Head == Items.Num(); }
+		FWorkItem& Front() { return Items[Head]; }
+		void Compact();
+	};
+
+	void RunItem(EGameplayWorkPriority Priority, FWorkItem& Item);
+	int32 FindStarvingQueue(double Now) const;
+
+	FWorkQueue Queues[(int32)EGameplayWorkPriority::Num];
+
+	// Rolling windows for the report.
+	static constexpr int32 HistorySize = 1024;
+	TArray<float> FrameUtilization;
+	TArray<float> QueueLatencyMs[(int32)EGameplayWorkPriority::Num];
+	int32 FrameHistoryIndex = 0;
+	int32 LatencyHistoryIndex[(int32)EGameplayWorkPriority::Num] = {};
+	int32 NumCarriedOverFrames = 0;
+	int32 NumFrames = 0;
+};
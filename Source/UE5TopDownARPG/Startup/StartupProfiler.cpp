@@ -0,0 +1,152 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "StartupProfiler.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/CommandLine.h"
+#include "../UE5TopDownARPG.h"
+
+namespace
+{
+	struct FPhaseTiming
+	{
+		/** Seconds since process start when the phase first began, negative if it never ran. */
+		double FirstStart = -1.0;
+		double OpenStart = 0.0;
+		double TotalSeconds = 0.0;
+		int32 NumRuns = 0;
+		int32 OpenDepth = 0;
+	};
+
+	FPhaseTiming PhaseTimings[(int32)EStartupPhase::Num] =
+	{
+		// Engine init is open from process start, before any game code runs.
+		{ 0.0, 0.0, 0.0, 0, 1 },
+	};
+	double ReadyTime = -1.0;
+	double ListenTime = -1.0;
+
+	const TCHAR* GetPhaseName(EStartupPhase Phase)
+	{
+		switch (Phase)
+		{
+		case EStartupPhase::EngineInit: return TEXT("Engine init");
+		case EStartupPhase::GameModeClassLookup: return TEXT("Game mode class lookup");
+		case EStartupPhase::MapLoad: return TEXT("Map load");
+		case EStartupPhase::NavigationBuild: return TEXT("Navigation build");
+		case EStartupPhase::AIAssetLoad: return TEXT("AI asset load");
+		case EStartupPhase::AIPossess: return TEXT("AI possess");
+		}
+		return TEXT("Unknown");
+	}
+
+	double GetSecondsSinceStart()
+	{
+		return FPlatformTime::Seconds() - GStartTime;
+	}
+
+	FAutoConsoleCommand StartupReportCommand(
+		TEXT("ARPG.StartupReport"),
+		TEXT("Logs how long each startup phase took until the server was ready for connections."),
+		FConsoleCommandDelegate::CreateStatic(&StartupProfiler::LogReport));
+}
+
+void StartupProfiler::BeginPhase(EStartupPhase Phase)
+{
+	if (Phase == EStartupPhase::Num || IsReady())
+	{
+		return;
+	}
+
+	// Nested runs of the same phase, e.g. a possess that loads, count once.
+	FPhaseTiming& Timing = PhaseTimings[(int32)Phase];
+	if (Timing.OpenDepth++ > 0)
+	{
+		return;
+	}
+
+	Timing.OpenStart = GetSecondsSinceStart();
+	if (Timing.FirstStart < 0.0)
+	{
+		Timing.FirstStart = Timing.OpenStart;
+	}
+}
+
+void StartupProfiler::EndPhase(EStartupPhase Phase)
+{
+	if (Phase == EStartupPhase::Num)
+	{
+		return;
+	}
+
+	FPhaseTiming& Timing = PhaseTimings[(int32)Phase];
+	if (Timing.OpenDepth == 0 || --Timing.OpenDepth > 0)
+	{
+		return;
+	}
+
+	Timing.TotalSeconds += GetSecondsSinceStart() - Timing.OpenStart;
+	Timing.NumRuns++;
+}
+
+bool StartupProfiler::IsPhaseOpen(EStartupPhase Phase)
+{
+	return Phase != EStartupPhase::Num && PhaseTimings[(int32)Phase].OpenDepth > 0;
+}
+
+void StartupProfiler::MarkReady()
+{
+	if (IsReady())
+	{
+		return;
+	}
+
+	ReadyTime = GetSecondsSinceStart();
+	LogReport();
+}
+
+bool StartupProfiler::IsReady()
+{
+	return ReadyTime >= 0.0;
+}
+
+void StartupProfiler::MarkListening()
+{
+	if (ListenTime < 0.0)
+	{
+		ListenTime = GetSecondsSinceStart();
+	}
+}
+
+bool StartupProfiler::IsFastBoot()
+{
+	static const bool bFastBoot = FParse::Param(FCommandLine::Get(), TEXT("ARPGFastBoot"));
+	return bFastBoot;
+}
+
+void StartupProfiler::LogReport()
+{
+	if (IsReady() == false)
+	{
+		UE_LOG(LogUE5TopDownARPG, Log, TEXT("Startup still in progress after %.2f s"), GetSecondsSinceStart());
+	}
+	else
+	{
+		const FString Listening = ListenTime >= 0.0 ? FString::Printf(TEXT("listening after %.2f s"), ListenTime) : FString(TEXT("not listening"));
+		UE_LOG(LogUE5TopDownARPG, Log, TEXT("Startup (%s): ready for connections after %.2f s, %s"),
+			IsFastBoot() ? TEXT("fast boot") : TEXT("full"), ReadyTime, *Listening);
+	}
+
+	for (int32 PhaseIndex = 0; PhaseIndex < (int32)EStartupPhase::Num; PhaseIndex++)
+	{
+		const FPhaseTiming& Timing = PhaseTimings[PhaseIndex];
+		if (Timing.FirstStart < 0.0)
+		{
+			UE_LOG(LogUE5TopDownARPG, Log, TEXT("  %-24s skipped"), GetPhaseName(EStartupPhase(PhaseIndex)));
+			continue;
+		}
+
+		UE_LOG(LogUE5TopDownARPG, Log, TEXT("  %-24s at %7.2f s, %9.2f ms over %d run(s)%s"), GetPhaseName(EStartupPhase(PhaseIndex)),
+			Timing.FirstStart, Timing.TotalSeconds * 1000.0, Timing.NumRuns, Timing.OpenDepth > 0 ? TEXT(", still running") : TEXT(""));
+	}
+}
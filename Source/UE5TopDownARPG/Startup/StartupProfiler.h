@@ -0,0 +1,59 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+enum class EStartupPhase : uint8
+{
+	EngineInit,
+	GameModeClassLookup,
+	MapLoad,
+	NavigationBuild,
+	AIAssetLoad,
+	AIPossess,
+	Num
+};
+
+/**
+ * Times the phases of server startup from process start until the server is ready for connections:
+ * the map is loaded and listening, navigation is built and the AI assets are loaded. A phase that
+ * runs several times, like possessing each enemy, accumulates. The report is logged once when the
+ * server becomes ready and again by ARPG.StartupReport.
+ *
+ * -ARPGFastBoot skips the navmesh build in favor of the navmesh saved with the map and loads the
+ * enemy classes and behavior trees while the map loads, see UStartupSubsystem.
+ */
+namespace StartupProfiler
+{
+	void BeginPhase(EStartupPhase Phase);
+	void EndPhase(EStartupPhase Phase);
+	bool IsPhaseOpen(EStartupPhase Phase);
+
+	/** Ends startup and logs the report. Later phases are not recorded. */
+	void MarkReady();
+	bool IsReady();
+
+	void MarkListening();
+
+	bool IsFastBoot();
+
+	void LogReport();
+}
+
+struct FScopedStartupPhase
+{
+	FScopedStartupPhase(EStartupPhase InPhase, bool bEnabled = true)
+		: Phase(bEnabled ? InPhase : EStartupPhase::Num)
+	{
+		StartupProfiler::BeginPhase(Phase);
+	}
+
+	~FScopedStartupPhase()
+	{
+		StartupProfiler::EndPhase(Phase);
+	}
+
+private:
+	EStartupPhase Phase;
+};
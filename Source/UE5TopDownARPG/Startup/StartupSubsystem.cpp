@@ -0,0 +1,192 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "StartupSubsystem.h"
+#include "StartupProfiler.h"
+#include "BehaviorTree/BehaviorTree.h"
+#include "BehaviorTree/BehaviorTreeManager.h"
+#include "Engine/AssetManager.h"
+#include "EngineUtils.h"
+#include "Misc/CoreDelegates.h"
+#include "NavigationSystem.h"
+#include "NavMesh/RecastNavMesh.h"
+#include "UObject/UObjectIterator.h"
+#include "../Loading/AssetPreloadSubsystem.h"
+#include "../Loading/PreloadManifest.h"
+#include "../Memory/GarbageCollectionSubsystem.h"
+#include "../UE5TopDownARPG.h"
+
+void UStartupSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	FCoreDelegates::OnPostEngineInit.AddUObject(this, &UStartupSubsystem::OnPostEngineInit);
+	FCoreUObjectDelegates::PreLoadMap.AddUObject(this, &UStartupSubsystem::OnPreLoadMap);
+	FWorldDelegates::OnPostWorldInitialization.AddUObject(this, &UStartupSubsystem::OnPostWorldInitialization);
+	FCoreUObjectDelegates::PostLoadMapWithWorld.AddUObject(this, &UStartupSubsystem::OnPostLoadMap);
+}
+
+void UStartupSubsystem::Deinitialize()
+{
+	FCoreDelegates::OnPostEngineInit.RemoveAll(this);
+	FCoreUObjectDelegates::PreLoadMap.RemoveAll(this);
+	FWorldDelegates::OnPostWorldInitialization.RemoveAll(this);
+	FCoreUObjectDelegates::PostLoadMapWithWorld.RemoveAll(this);
+	FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+
+	Super::Deinitialize();
+}
+
+void UStartupSubsystem::OnPostEngineInit()
+{
+	StartupProfiler::EndPhase(EStartupPhase::EngineInit);
+}
+
+void UStartupSubsystem::OnPreLoadMap(const FString& MapName)
+{
+	if (StartupProfiler::IsReady() == false)
+	{
+		StartupProfiler::BeginPhase(EStartupPhase::MapLoad);
+	}
+}
+
+void UStartupSubsystem::OnPostWorldInitialization(UWorld* World, const UWorld::InitializationValues IVS)
+{
+	if (StartupProfiler::IsReady() || StartupProfiler::IsFastBoot() == false || IsValid(World) == false || World->IsGameWorld() == false)
+	{
+		return;
+	}
+
+	// Runs before the navigation system decides to build and before placed enemies are possessed.
+	if (LockPrebuiltNavigation(World))
+	{
+		UE_LOG(LogUE5TopDownARPG, Log, TEXT("Fast boot: using the saved navmesh, navigation building is locked"));
+	}
+	LoadAIAssets(World);
+}
+
+void UStartupSubsystem::OnPostLoadMap(UWorld* World)
+{
+	if (StartupProfiler::IsReady() || IsValid(World) == false || World->IsGameWorld() == false)
+	{
+		return;
+	}
+
+	StartupProfiler::EndPhase(EStartupPhase::MapLoad);
+	if (World->GetNetDriver() != nullptr)
+	{
+		StartupProfiler::MarkListening();
+	}
+
+	// Wait for the navigation build and the asynchronous preloads the map started, which opened the AI asset load phase.
+	StartupWorld = World;
+	TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &UStartupSubsystem::TickStartup));
+}
+
+bool UStartupSubsystem::TickStartup(float DeltaTime)
+{
+	UWorld* World = StartupWorld.Get();
+	if (World == nullptr)
+	{
+		TickerHandle.Reset();
+		return false;
+	}
+
+	const UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(World);
+	const bool bBuilding = NavSys != nullptr && NavSys->IsNavigationBuildInProgress();
+	if (bBuilding != bNavigationBuilding)
+	{
+		bNavigationBuilding = bBuilding;
+		if (bBuilding)
+		{
+			StartupProfiler::BeginPhase(EStartupPhase::NavigationBuild);
+		}
+		else
+		{
+			StartupProfiler::EndPhase(EStartupPhase::NavigationBuild);
+		}
+	}
+
+	const UAssetPreloadSubsystem* PreloadSubsystem = World->GetSubsystem<UAssetPreloadSubsystem>();
+	const bool bPreloading = PreloadSubsystem != nullptr && PreloadSubsystem->IsPreloading();
+	if (bPreloading == false)
+	{
+		StartupProfiler::EndPhase(EStartupPhase::AIAssetLoad);
+	}
+
+	if (bBuilding || bPreloading)
+	{
+		return true;
+	}
+
+	StartupProfiler::MarkReady();
+	TickerHandle.Reset();
+	return false;
+}
+
+bool UStartupSubsystem::LockPrebuiltNavigation(UWorld* World) const
+{
+	UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(World);
+	if (NavSys == nullptr)
+	{
+		return false;
+	}
+
+	int32 NumNavMeshes = 0;
+	for (TActorIterator<ARecastNavMesh> It(World); It; ++It)
+	{
+		if (It->GetNavMeshTilesCount() == 0)
+		{
+			UE_LOG(LogUE5TopDownARPG, Warning, TEXT("Fast boot: %s was saved without navmesh tiles, building navigation instead"), *It->GetName());
+			return false;
+		}
+		NumNavMeshes++;
+	}
+
+	if (NumNavMeshes == 0)
+	{
+		return false;
+	}
+
+	// Unlocking would rebuild everything, so the lock is kept for the session.
+	NavSys->AddNavigationBuildLock(ENavigationBuildLock::Custom);
+	UNavigationSystemV1::SetNavigationAutoUpdateEnabled(false, NavSys);
+	return true;
+}
+
+void UStartupSubsystem::LoadAIAssets(UWorld* World) const
+{
+	FScopedStartupPhase Phase(EStartupPhase::AIAssetLoad);
+
+	if (UAssetManager::IsValid())
+	{
+		TArray<FPrimaryAssetId> ManifestIds;
+		UAssetManager& AssetManager = UAssetManager::Get();
+		AssetManager.GetPrimaryAssetIdList(UPreloadManifest::PrimaryAssetType, ManifestIds);
+
+		TSharedPtr<FStreamableHandle> Handle = ManifestIds.Num() > 0 ? AssetManager.LoadPrimaryAssets(ManifestIds, { FName(TEXT("Enemies")) }) : nullptr;
+		if (Handle.IsValid())
+		{
+			Handle->WaitUntilComplete();
+		}
+	}
+
+	if (UGarbageCollectionSubsystem* GarbageCollectionSubsystem = UGarbageCollectionSubsystem::Get())
+	{
+		GarbageCollectionSubsystem->ClusterResidentAssets();
+	}
+
+	// Builds each tree's shared template now instead of on the first StartTree of every enemy type.
+	UBehaviorTreeManager* BehaviorTreeManager = UBehaviorTreeManager::GetCurrent(World);
+	if (BehaviorTreeManager == nullptr)
+	{
+		return;
+	}
+
+	for (TObjectIterator<UBehaviorTree> It; It; ++It)
+	{
+		UBTCompositeNode* Root = nullptr;
+		uint16 InstanceMemorySize = 0;
+		BehaviorTreeManager->LoadTree(**It, Root, InstanceMemorySize);
+	}
+}
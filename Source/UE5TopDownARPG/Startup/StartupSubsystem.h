@@ -0,0 +1,42 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "Engine/World.h"
+#include "Subsystems/EngineSubsystem.h"
+#include "StartupSubsystem.generated.h"
+
+/**
+ * Follows the first map of the process through loading, navigation building and AI asset loading,
+ * feeding StartupProfiler, and marks the server ready once all of them are done.
+ *
+ * With -ARPGFastBoot the navmesh saved with the map is used as is. Navigation building stays locked for
+ * the session, so it must have been built before saving or cooking. The enemy bundle of the preload
+ * manifests and every behavior tree are loaded while the map loads, before the first enemy is possessed.
+ */
+UCLASS()
+class UE5TOPDOWNARPG_API UStartupSubsystem : public UEngineSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+private:
+	void OnPostEngineInit();
+	void OnPreLoadMap(const FString& MapName);
+	void OnPostWorldInitialization(UWorld* World, const UWorld::InitializationValues IVS);
+	void OnPostLoadMap(UWorld* World);
+	bool TickStartup(float DeltaTime);
+
+	/** Keeps the saved navmesh instead of rebuilding it, false when the map has none. */
+	bool LockPrebuiltNavigation(UWorld* World) const;
+	void LoadAIAssets(UWorld* World) const;
+
+	TWeakObjectPtr<UWorld> StartupWorld;
+	FTSTicker::FDelegateHandle TickerHandle;
+	bool bNavigationBuilding = false;
+};
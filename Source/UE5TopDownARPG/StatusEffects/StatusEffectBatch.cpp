@@ -0,0 +1,151 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "StatusEffectBatch.h"
+#include "Async/ParallelFor.h"
+
+namespace
+{
+	const int32 EffectsPerTask = 1024;
+}
+
+int32 FStatusEffectBatch::Add(int32 TargetIndex, EStatusEffect Type, float Magnitude, float Now, float Duration, float Interval, const FStatusEffectSource& Source)
+{
+	Interval = FMath::Max(Interval, KINDA_SMALL_NUMBER);
+
+	TargetIndices.Add(TargetIndex);
+	Types.Add(Type);
+	Magnitudes.Add(Magnitude);
+	Intervals.Add(Interval);
+	NextTickTimes.Add(Now + Interval);
+	ExpiryTimes.Add(Duration > 0.0f ? Now + Duration : MAX_flt);
+	Sources.Add(Source);
+
+	switch (Type)
+	{
+	case EStatusEffect::Poison:
+	case EStatusEffect::Burn:
+		DamagePerTick.Add(Magnitude);
+		SpeedMultipliers.Add(1.0f);
+		break;
+	case EStatusEffect::Regen:
+		DamagePerTick.Add(-Magnitude);
+		SpeedMultipliers.Add(1.0f);
+		break;
+	case EStatusEffect::Slow:
+		DamagePerTick.Add(0.0f);
+		SpeedMultipliers.Add(1.0f - FMath::Clamp(Magnitude, 0.0f, 1.0f));
+		break;
+	}
+
+	const int32 EffectId = NextId++;
+	IdToIndex.Add(EffectId, Ids.Add(EffectId));
+	return EffectId;
+}
+
+int32 FStatusEffectBatch::Remove(int32 EffectId)
+{
+	const int32* Index = IdToIndex.Find(EffectId);
+	if (Index == nullptr)
+	{
+		return INDEX_NONE;
+	}
+
+	const int32 TargetIndex = TargetIndices[*Index];
+	RemoveAt(*Index);
+	return TargetIndex;
+}
+
+int32 FStatusEffectBatch::RemoveTarget(int32 TargetIndex)
+{
+	int32 NumRemoved = 0;
+	for (int32 Index = Num() - 1; Index >= 0; Index--)
+	{
+		if (TargetIndices[Index] == TargetIndex)
+		{
+			RemoveAt(Index);
+			NumRemoved++;
+		}
+	}
+	return NumRemoved;
+}
+
+void FStatusEffectBatch::Update(float Now, TArrayView<float> OutDamage, TArrayView<float> OutSpeedMultipliers, TArrayView<FStatusEffectSource> OutSources, TArray<int32>& OutExpiredTargets)
+{
+	const int32 NumEffects = Num();
+	TickDamage.SetNumUninitialized(NumEffects, false);
+	StrongestTickDamage.Reset();
+	StrongestTickDamage.SetNumZeroed(OutDamage.Num());
+
+	// No branches on the effect type or on whether a tick is due, so each block vectorizes. An effect
+	// that fell behind by more than one interval applies every missed tick at once.
+	const int32 NumTasks = FMath::DivideAndRoundUp(NumEffects, EffectsPerTask);
+	ParallelFor(NumTasks, [this, Now, NumEffects](int32 TaskIndex)
+	{
+		const int32 End = FMath::Min((TaskIndex + 1) * EffectsPerTask, NumEffects);
+		const float* RESTRICT Interval = Intervals.GetData();
+		const float* RESTRICT Expiry = ExpiryTimes.GetData();
+		const float* RESTRICT Damage = DamagePerTick.GetData();
+		float* RESTRICT NextTick = NextTickTimes.GetData();
+		float* RESTRICT OutTickDamage = TickDamage.GetData();
+		for (int32 Index = TaskIndex * EffectsPerTask; Index < End; Index++)
+		{
+			const float LastTickTime = FMath::Min(Now, Expiry[Index]);
+			const float NumTicks = FMath::Max(FMath::FloorToFloat((LastTickTime - NextTick[Index]) / Interval[Index]) + 1.0f, 0.0f);
+			OutTickDamage[Index] = NumTicks * Damage[Index];
+			NextTick[Index] += NumTicks * Interval[Index];
+		}
+	});
+
+	for (int32 Index = 0; Index < NumEffects; Index++)
+	{
+		const int32 TargetIndex = TargetIndices[Index];
+		OutDamage[TargetIndex] += TickDamage[Index];
+		if (FMath::Abs(TickDamage[Index]) > StrongestTickDamage[TargetIndex])
+		{
+			StrongestTickDamage[TargetIndex] = FMath::Abs(TickDamage[Index]);
+			OutSources[TargetIndex] = Sources[Index];
+		}
+		OutSpeedMultipliers[TargetIndex] = FMath::Min(OutSpeedMultipliers[TargetIndex], SpeedMultipliers[Index]);
+	}
+
+	// Iterate backwards so RemoveAt only moves already visited effects.
+	for (int32 Index = NumEffects - 1; Index >= 0; Index--)
+	{
+		if (ExpiryTimes[Index] <= Now)
+		{
+			OutExpiredTargets.Add(TargetIndices[Index]);
+			RemoveAt(Index);
+		}
+	}
+}
+
+SIZE_T FStatusEffectBatch::GetAllocatedSize() const
+{
+	return TargetIndices.GetAllocatedSize() + Types.GetAllocatedSize() + Magnitudes.GetAllocatedSize()
+		+ Intervals.GetAllocatedSize() + NextTickTimes.GetAllocatedSize() + ExpiryTimes.GetAllocatedSize()
+		+ Sources.GetAllocatedSize() + DamagePerTick.GetAllocatedSize() + SpeedMultipliers.GetAllocatedSize()
+		+ TickDamage.GetAllocatedSize() + StrongestTickDamage.GetAllocatedSize()
+		+ Ids.GetAllocatedSize() + IdToIndex.GetAllocatedSize();
+}
+
+void FStatusEffectBatch::RemoveAt(int32 Index)
+{
+	IdToIndex.Remove(Ids[Index]);
+
+	TargetIndices.RemoveAtSwap(Index, 1, false);
+	Types.RemoveAtSwap(Index, 1, false);
+	Magnitudes.RemoveAtSwap(Index, 1, false);
+	Intervals.RemoveAtSwap(Index, 1, false);
+	NextTickTimes.RemoveAtSwap(Index, 1, false);
+	ExpiryTimes.RemoveAtSwap(Index, 1, false);
+	Sources.RemoveAtSwap(Index, 1, false);
+	DamagePerTick.RemoveAtSwap(Index, 1, false);
+	SpeedMultipliers.RemoveAtSwap(Index, 1, false);
+	Ids.RemoveAtSwap(Index, 1, false);
+
+	if (Ids.IsValidIndex(Index))
+	{
+		IdToIndex[Ids[Index]] = Index;
+	}
+}
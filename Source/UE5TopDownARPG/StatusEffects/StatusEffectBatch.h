@@ -0,0 +1,81 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "StatusEffectBatch.generated.h"
+
+UENUM()
+enum class EStatusEffect : uint8
+{
+	/** Damages by Magnitude every interval. */
+	Poison,
+	Burn,
+	/** Heals by Magnitude every interval. */
+	Regen,
+	/** Scales max speed by 1 - Magnitude while active, the strongest slow wins. */
+	Slow
+};
+
+/** Who applied an effect, passed to TakeDamage for the damage it deals. */
+struct FStatusEffectSource
+{
+	TWeakObjectPtr<class AController> Instigator;
+	TWeakObjectPtr<AActor> Causer;
+};
+
+/**
+ * Every active status effect, one array per field. Update advances all of them in one pass and sums
+ * their damage per target, so a target takes one health change per frame however many effects it has.
+ * Targets are indices owned by the caller.
+ */
+class FStatusEffectBatch
+{
+public:
+	/** Returns an id for Remove. Duration <= 0 lasts until removed. */
+	int32 Add(int32 TargetIndex, EStatusEffect Type, float Magnitude, float Now, float Duration, float Interval, const FStatusEffectSource& Source = FStatusEffectSource());
+
+	/** Removes the effect and returns its target, INDEX_NONE when it already expired. */
+	int32 Remove(int32 EffectId);
+
+	/** Removes every effect on the target and returns how many there were. */
+	int32 RemoveTarget(int32 TargetIndex);
+
+	/**
+	 * Applies every tick due by Now. Damage per target is added to OutDamage, negative for healing, and
+	 * the strongest slow per target is folded into OutSpeedMultipliers. OutSources receives the source of
+	 * the effect that ticked hardest on each target, which is credited with the summed damage. All three
+	 * must cover every target index. Effects that expire are removed and their targets appended to
+	 * OutExpiredTargets.
+	 */
+	void Update(float Now, TArrayView<float> OutDamage, TArrayView<float> OutSpeedMultipliers, TArrayView<FStatusEffectSource> OutSources, TArray<int32>& OutExpiredTargets);
+
+	int32 Num() const { return TargetIndices.Num(); }
+
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	void RemoveAt(int32 Index);
+
+	TArray<int32> TargetIndices;
+	TArray<EStatusEffect> Types;
+	TArray<float> Magnitudes;
+	TArray<float> Intervals;
+	TArray<float> NextTickTimes;
+	TArray<float> ExpiryTimes;
+	TArray<FStatusEffectSource> Sources;
+
+	// Derived from type and magnitude when added, so the update pass does not branch on the type.
+	TArray<float> DamagePerTick;
+	TArray<float> SpeedMultipliers;
+
+	/** Damage of each effect this update, before it is summed per target. */
+	TArray<float> TickDamage;
+
+	/** Largest tick damage per target this update, to pick the source credited with it. */
+	TArray<float> StrongestTickDamage;
+
+	TArray<int32> Ids;
+	TMap<int32, int32> IdToIndex;
+	int32 NextId = 0;
+};
@@ -0,0 +1,271 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "StatusEffectSubsystem.h"
+#include "Containers/Ticker.h"
+#include "Engine/DamageEvents.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "TimerManager.h"
+#include "../Characters/ARPGCharacterMovementComponent.h"
+#include "../Characters/BaseCharacter.h"
+#include "../UE5TopDownARPG.h"
+
+DECLARE_CYCLE_STAT(TEXT("Status Effects"), STAT_StatusEffects, STATGROUP_ARPG);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Active Status Effects"), STAT_ActiveStatusEffects, STATGROUP_ARPG);
+
+namespace
+{
+	struct FStatusEffectBenchmark
+	{
+		// One looping timer per effect, like a damage zone per effect.
+		FTimerManager TimerManager;
+		TArray<FTimerHandle> TimerHandles;
+		TArray<float> TimerDamage;
+		int64 NumTimerCalls = 0;
+		uint64 TimerCycles = 0;
+
+		FStatusEffectBatch Batch;
+		TArray<float> BatchDamage;
+		TArray<float> BatchSpeedMultipliers;
+		TArray<FStatusEffectSource> BatchSources;
+		TArray<int32> ExpiredTargets;
+		int64 NumBatchApplications = 0;
+		uint64 BatchCycles = 0;
+
+		float Now = 0.0f;
+		int32 FramesLeft = 0;
+		int32 NumFrames = 0;
+	};
+
+	const float BenchmarkDeltaTime = 1.0f / 60.0f;
+
+	bool TickStatusEffectBenchmark(TSharedRef<FStatusEffectBenchmark> Benchmark)
+	{
+		// Timers tick at most once per engine frame, so the benchmark advances one simulated frame per real one.
+		uint64 StartCycles = FPlatformTime::Cycles64();
+		Benchmark->TimerManager.Tick(BenchmarkDeltaTime);
+		Benchmark->TimerCycles += FPlatformTime::Cycles64() - StartCycles;
+
+		Benchmark->Now += BenchmarkDeltaTime;
+		StartCycles = FPlatformTime::Cycles64();
+		FMemory::Memzero(Benchmark->BatchDamage.GetData(), Benchmark->BatchDamage.Num() * sizeof(float));
+		for (float& SpeedMultiplier : Benchmark->BatchSpeedMultipliers)
+		{
+			SpeedMultiplier = 1.0f;
+		}
+		Benchmark->Batch.Update(Benchmark->Now, Benchmark->BatchDamage, Benchmark->BatchSpeedMultipliers, Benchmark->BatchSources, Benchmark->ExpiredTargets);
+		for (float Damage : Benchmark->BatchDamage)
+		{
+			Benchmark->NumBatchApplications += Damage != 0.0f;
+		}
+		Benchmark->BatchCycles += FPlatformTime::Cycles64() - StartCycles;
+
+		if (--Benchmark->FramesLeft > 0)
+		{
+			return true;
+		}
+
+		const int32 NumEffects = Benchmark->TimerHandles.Num();
+		const double NumFrames = Benchmark->NumFrames;
+		UE_LOG(LogUE5TopDownARPG, Log, TEXT("%d status effects on %d targets over %d frames:"), NumEffects, Benchmark->BatchDamage.Num(), Benchmark->NumFrames);
+		UE_LOG(LogUE5TopDownARPG, Log, TEXT("  timer per effect: %.3f ms/frame, %.1f damage calls/frame"),
+			FPlatformTime::ToMilliseconds64(Benchmark->TimerCycles) / NumFrames, Benchmark->NumTimerCalls / NumFrames);
+		UE_LOG(LogUE5TopDownARPG, Log, TEXT("  batched: %.3f ms/frame, %.1f damage calls/frame, %.1f bytes/effect"),
+			FPlatformTime::ToMilliseconds64(Benchmark->BatchCycles) / NumFrames, Benchmark->NumBatchApplications / NumFrames,
+			double(Benchmark->Batch.GetAllocatedSize()) / FMath::Max(NumEffects, 1));
+
+		for (FTimerHandle& TimerHandle : Benchmark->TimerHandles)
+		{
+			Benchmark->TimerManager.ClearTimer(TimerHandle);
+		}
+		return false;
+	}
+
+	void RunStatusEffectBenchmark(const TArray<FString>& Args)
+	{
+		const int32 NumEffects = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 10000;
+		const int32 NumTargets = FMath::Max(Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 500, 1);
+		const int32 NumFrames = FMath::Max(Args.Num() > 2 ? FCString::Atoi(*Args[2]) : 300, 1);
+
+		TSharedRef<FStatusEffectBenchmark> Benchmark = MakeShared<FStatusEffectBenchmark>();
+		Benchmark->TimerDamage.SetNumZeroed(NumTargets);
+		Benchmark->BatchDamage.SetNumZeroed(NumTargets);
+		Benchmark->BatchSpeedMultipliers.Init(1.0f, NumTargets);
+		Benchmark->BatchSources.SetNum(NumTargets);
+		Benchmark->FramesLeft = NumFrames;
+		Benchmark->NumFrames = NumFrames;
+
+		// Intervals between a quarter and two seconds so ticks spread over frames like real zones and dots.
+		FRandomStream Stream(NumEffects);
+		Benchmark->TimerHandles.SetNum(NumEffects);
+		for (int32 Index = 0; Index < NumEffects; Index++)
+		{
+			const int32 TargetIndex = Index % NumTargets;
+			const EStatusEffect Type = EStatusEffect(Index % 4);
+			const float Magnitude = Type == EStatusEffect::Slow ? 0.3f : Stream.FRandRange(1.0f, 10.0f);
+			const float Interval = Stream.FRandRange(0.25f, 2.0f);
+
+			Benchmark->Batch.Add(TargetIndex, Type, Magnitude, 0.0f, 0.0f, Interval);
+
+			if (Type != EStatusEffect::Slow)
+			{
+				const float Damage = Type == EStatusEffect::Regen ? -Magnitude : Magnitude;
+				FStatusEffectBenchmark* RawBenchmark = &Benchmark.Get();
+				Benchmark->TimerManager.SetTimer(Benchmark->TimerHandles[Index], FTimerDelegate::CreateLambda([RawBenchmark, TargetIndex, Damage]()
+				{
+					RawBenchmark->TimerDamage[TargetIndex] += Damage;
+					RawBenchmark->NumTimerCalls++;
+				}), Interval, true);
+			}
+		}
+
+		FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([Benchmark](float)
+		{
+			return TickStatusEffectBenchmark(Benchmark);
+		}));
+	}
+
+	FAutoConsoleCommand StatusEffectBenchmarkCommand(
+		TEXT("ARPG.Bench.StatusEffects"),
+		TEXT("Compares batched status effects against a looping timer per effect. Args: [NumEffects=10000] [NumTargets=500] [NumFrames=300]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&RunStatusEffectBenchmark));
+}
+
+bool UStatusEffectSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	UWorld* World = Cast<UWorld>(Outer);
+	return Super::ShouldCreateSubsystem(Outer) && IsValid(World) && World->IsGameWorld();
+}
+
+UStatusEffectSubsystem* UStatusEffectSubsystem::Get(const UObject* WorldContextObject)
+{
+	UWorld* World = IsValid(WorldContextObject) ? WorldContextObject->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UStatusEffectSubsystem>() : nullptr;
+}
+
+int32 UStatusEffectSubsystem::ApplyEffect(ABaseCharacter* Target, EStatusEffect Type, float Magnitude, float Duration, float Interval,
+	AController* Instigator, AActor* Causer)
+{
+	if (IsValid(Target) == false || GetWorld()->GetNetMode() == NM_Client)
+	{
+		return INDEX_NONE;
+	}
+
+	int32 TargetIndex = INDEX_NONE;
+	if (const int32* ExistingSlot = TargetSlots.Find(Target))
+	{
+		TargetIndex = *ExistingSlot;
+	}
+	else
+	{
+		TargetIndex = FreeTargets.Num() > 0 ? FreeTargets.Pop(false) : Targets.AddDefaulted();
+		TargetEffectCounts.SetNumZeroed(Targets.Num());
+		TargetSpeedMultipliers.SetNum(Targets.Num());
+		TargetKeys.SetNum(Targets.Num());
+		Targets[TargetIndex] = Target;
+		TargetKeys[TargetIndex] = Target;
+		TargetSpeedMultipliers[TargetIndex] = 1.0f;
+		TargetSlots.Add(Target, TargetIndex);
+	}
+
+	TargetEffectCounts[TargetIndex]++;
+	INC_DWORD_STAT(STAT_ActiveStatusEffects);
+	return Effects.Add(TargetIndex, Type, Magnitude, GetWorld()->GetTimeSeconds(), Duration, Interval, FStatusEffectSource{ Instigator, Causer });
+}
+
+void UStatusEffectSubsystem::RemoveEffect(int32 EffectId)
+{
+	const int32 TargetIndex = Effects.Remove(EffectId);
+	if (TargetIndex != INDEX_NONE)
+	{
+		ReleaseEffects(TargetIndex, 1);
+	}
+}
+
+void UStatusEffectSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_StatusEffects);
+
+	if (Effects.Num() == 0)
+	{
+		return;
+	}
+
+	const int32 NumTargets = Targets.Num();
+	TargetDamage.Reset();
+	TargetDamage.SetNumZeroed(NumTargets);
+	NewSpeedMultipliers.Init(1.0f, NumTargets);
+	DamageSources.Reset();
+	DamageSources.SetNum(NumTargets);
+	ExpiredTargets.Reset();
+	Effects.Update(GetWorld()->GetTimeSeconds(), TargetDamage, NewSpeedMultipliers, DamageSources, ExpiredTargets);
+
+	for (int32 TargetIndex = 0; TargetIndex < NumTargets; TargetIndex++)
+	{
+		if (TargetEffectCounts[TargetIndex] == 0)
+		{
+			continue;
+		}
+
+		ABaseCharacter* Character = Targets[TargetIndex].Get();
+		if (IsValid(Character) == false)
+		{
+			ReleaseEffects(TargetIndex, Effects.RemoveTarget(TargetIndex));
+			continue;
+		}
+
+		if (TargetDamage[TargetIndex] != 0.0f)
+		{
+			const FStatusEffectSource& Source = DamageSources[TargetIndex];
+			Character->TakeDamage(TargetDamage[TargetIndex], FDamageEvent(UDamageType::StaticClass()), Source.Instigator.Get(), Source.Causer.Get());
+		}
+		SetSpeedMultiplier(TargetIndex, NewSpeedMultipliers[TargetIndex]);
+	}
+
+	// Expired effects applied their last tick above, so their targets can be released now.
+	for (int32 TargetIndex : ExpiredTargets)
+	{
+		ReleaseEffects(TargetIndex, 1);
+	}
+}
+
+TStatId UStatusEffectSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UStatusEffectSubsystem, STATGROUP_Tickables);
+}
+
+void UStatusEffectSubsystem::ReleaseEffects(int32 TargetIndex, int32 NumEffects)
+{
+	if (TargetEffectCounts[TargetIndex] == 0 || NumEffects == 0)
+	{
+		return;
+	}
+
+	DEC_DWORD_STAT_BY(STAT_ActiveStatusEffects, NumEffects);
+	TargetEffectCounts[TargetIndex] -= NumEffects;
+	if (TargetEffectCounts[TargetIndex] > 0)
+	{
+		return;
+	}
+
+	SetSpeedMultiplier(TargetIndex, 1.0f);
+	TargetSlots.Remove(TargetKeys[TargetIndex]);
+	Targets[TargetIndex] = nullptr;
+	FreeTargets.Add(TargetIndex);
+}
+
+void UStatusEffectSubsystem::SetSpeedMultiplier(int32 TargetIndex, float SpeedMultiplier)
+{
+	if (TargetSpeedMultipliers[TargetIndex] == SpeedMultiplier)
+	{
+		return;
+	}
+
+	TargetSpeedMultipliers[TargetIndex] = SpeedMultiplier;
+	ABaseCharacter* Character = Targets[TargetIndex].Get();
+	if (UARPGCharacterMovementComponent* MovementComponent = Character ? Cast<UARPGCharacterMovementComponent>(Character->GetCharacterMovement()) : nullptr)
+	{
+		MovementComponent->SetSpeedMultiplier(SpeedMultiplier);
+	}
+}
@@ -0,0 +1,57 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "StatusEffectBatch.h"
+#include "StatusEffectSubsystem.generated.h"
+
+/**
+ * Owns poison, burn, regen and slow effects on every character on the server. Effects tick together
+ * once per frame instead of through a timer per effect, and each character takes the summed damage
+ * of all its effects as a single TakeDamage call.
+ */
+UCLASS()
+class UE5TOPDOWNARPG_API UStatusEffectSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	static UStatusEffectSubsystem* Get(const UObject* WorldContextObject);
+
+	/**
+	 * Returns an id for RemoveEffect, INDEX_NONE on clients. Duration <= 0 lasts until removed.
+	 * Instigator and Causer are passed to TakeDamage for the damage the effect deals.
+	 */
+	int32 ApplyEffect(class ABaseCharacter* Target, EStatusEffect Type, float Magnitude, float Duration, float Interval = 1.0f,
+		class AController* Instigator = nullptr, AActor* Causer = nullptr);
+
+	void RemoveEffect(int32 EffectId);
+
+	int32 GetNumEffects() const { return Effects.Num(); }
+
+private:
+	void ReleaseEffects(int32 TargetIndex, int32 NumEffects);
+	void SetSpeedMultiplier(int32 TargetIndex, float SpeedMultiplier);
+
+	FStatusEffectBatch Effects;
+
+	// Per target, indexed by the target indices stored in Effects. Slots with no effects are free.
+	TArray<TWeakObjectPtr<class ABaseCharacter>> Targets;
+	TArray<TObjectKey<class ABaseCharacter>> TargetKeys;
+	TArray<int32> TargetEffectCounts;
+	TArray<float> TargetSpeedMultipliers;
+	TMap<TObjectKey<class ABaseCharacter>, int32> TargetSlots;
+	TArray<int32> FreeTargets;
+
+	// Reused every tick.
+	TArray<float> TargetDamage;
+	TArray<float> NewSpeedMultipliers;
+	TArray<FStatusEffectSource> DamageSources;
+	TArray<int32> ExpiredTargets;
+};
@@ -0,0 +1,144 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GameplayMetrics.h"
+#include "Misc/ScopeLock.h"
+#include <atomic>
+
+namespace
+{
+	constexpr int32 NumCounters = (int32)EGameplayCounter::Num;
+	constexpr int32 NumHistograms = (int32)EGameplayHistogram::Num;
+	constexpr int32 MaxBuckets = 8;
+
+	const TCHAR* CounterNames[NumCounters] =
+	{
+		TEXT("arpg_bolts_fired_total"),
+		TEXT("arpg_projectile_hits_total"),
+		TEXT("arpg_damage_dealt_total"),
+		TEXT("arpg_deaths_total"),
+		TEXT("arpg_waves_spawned_total"),
+		TEXT("arpg_pickups_collected_total"),
+		TEXT("arpg_ai_path_failures_total"),
+	};
+
+	struct FHistogramDefinition
+	{
+		const TCHAR* Name;
+		double UpperBounds[MaxBuckets];
+		int32 NumBounds;
+	};
+
+	const FHistogramDefinition HistogramDefinitions[NumHistograms] =
+	{
+		{ TEXT("arpg_damage_per_hit"), { 1.0, 5.0, 10.0, 20.0, 50.0, 100.0 }, 6 },
+		{ TEXT("arpg_wave_duration_seconds"), { 5.0, 10.0, 20.0, 40.0, 60.0, 120.0, 300.0 }, 7 },
+	};
+
+	/** Written only by its owning thread, so plain loads and stores are enough. */
+	struct FThreadMetrics
+	{
+		std::atomic<int64> Counters[NumCounters] = {};
+		std::atomic<uint64> Buckets[NumHistograms][MaxBuckets + 1] = {};
+		std::atomic<double> Sums[NumHistograms] = {};
+	};
+
+	// Blocks live for the whole process so the counts of finished threads are kept.
+	FCriticalSection RegistryLock;
+	TArray<TUniquePtr<FThreadMetrics>> Registry;
+
+	FThreadMetrics& GetThreadMetrics()
+	{
+		thread_local FThreadMetrics* ThreadMetrics = nullptr;
+		if (ThreadMetrics == nullptr)
+		{
+			// Only the first update on each thread takes the lock.
+			FScopeLock Lock(&RegistryLock);
+			ThreadMetrics = Registry.Add_GetRef(MakeUnique<FThreadMetrics>()).Get();
+		}
+		return *ThreadMetrics;
+	}
+
+	template<typename ValueType>
+	void AddRelaxed(std::atomic<ValueType>& Value, ValueType Amount)
+	{
+		Value.store(Value.load(std::memory_order_relaxed) + Amount, std::memory_order_relaxed);
+	}
+}
+
+void GameplayMetrics::Increment(EGameplayCounter Counter, int64 Amount)
+{
+	AddRelaxed(GetThreadMetrics().Counters[(int32)Counter], Amount);
+}
+
+void GameplayMetrics::Observe(EGameplayHistogram Histogram, double Value)
+{
+	const FHistogramDefinition& Definition = HistogramDefinitions[(int32)Histogram];
+	int32 Bucket = 0;
+	while (Bucket < Definition.NumBounds && Value > Definition.UpperBounds[Bucket])
+	{
+		Bucket++;
+	}
+
+	FThreadMetrics& ThreadMetrics = GetThreadMetrics();
+	AddRelaxed(ThreadMetrics.Buckets[(int32)Histogram][Bucket], uint64(1));
+	AddRelaxed(ThreadMetrics.Sums[(int32)Histogram], Value);
+}
+
+void GameplayMetrics::WritePrometheusText(FString& OutText, const FString& Instance)
+{
+	int64 Counters[NumCounters] = {};
+	uint64 Buckets[NumHistograms][MaxBuckets + 1] = {};
+	double Sums[NumHistograms] = {};
+	{
+		FScopeLock Lock(&RegistryLock);
+		for (const TUniquePtr<FThreadMetrics>& ThreadMetrics : Registry)
+		{
+			for (int32 Index = 0; Index < NumCounters; Index++)
+			{
+				Counters[Index] += ThreadMetrics->Counters[Index].load(std::memory_order_relaxed);
+			}
+			for (int32 Index = 0; Index < NumHistograms; Index++)
+			{
+				for (int32 Bucket = 0; Bucket <= MaxBuckets; Bucket++)
+				{
+					Buckets[Index][Bucket] += ThreadMetrics->Buckets[Index][Bucket].load(std::memory_order_relaxed);
+				}
+				Sums[Index] += ThreadMetrics->Sums[Index].load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	const FString Labels = FString::Printf(TEXT("instance=\"%s\""), *Instance);
+	for (int32 Index = 0; Index < NumCounters; Index++)
+	{
+		OutText += FString::Printf(TEXT("# TYPE %s counter\n%s{%s} %lld\n"), CounterNames[Index], CounterNames[Index], *Labels, Counters[Index]);
+	}
+
+	for (int32 Index = 0; Index < NumHistograms; Index++)
+	{
+		const FHistogramDefinition& Definition = HistogramDefinitions[Index];
+		OutText += FString::Printf(TEXT("# TYPE %s histogram\n"), Definition.Name);
+
+		// Prometheus buckets are cumulative.
+		uint64 Count = 0;
+		for (int32 Bucket = 0; Bucket <= Definition.NumBounds; Bucket++)
+		{
+			Count += Buckets[Index][Bucket];
+			const FString UpperBound = Bucket < Definition.NumBounds ? FString::SanitizeFloat(Definition.UpperBounds[Bucket]) : FString(TEXT("+Inf"));
+			OutText += FString::Printf(TEXT("%s_bucket{%s,le=\"%s\"} %llu\n"), Definition.Name, *Labels, *UpperBound, Count);
+		}
+		OutText += FString::Printf(TEXT("%s_sum{%s} %f\n%s_count{%s} %llu\n"), Definition.Name, *Labels, Sums[Index], Definition.Name, *Labels, Count);
+	}
+}
+
+float GameplayMetrics::GetPercentile(TArray<float> Samples, float Percentile)
+{
+	if (Samples.Num() == 0)
+	{
+		return 0.0f;
+	}
+
+	Samples.Sort();
+	return Samples[FMath::Min(FMath::FloorToInt(Samples.Num() * Percentile), Samples.Num() - 1)];
+}
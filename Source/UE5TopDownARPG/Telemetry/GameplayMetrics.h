@@ -0,0 +1,40 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+enum class EGameplayCounter : uint8
+{
+	BoltsFired,
+	ProjectileHits,
+	DamageDealt,
+	Deaths,
+	WavesSpawned,
+	PickupsCollected,
+	AIPathFailures,
+	Num
+};
+
+enum class EGameplayHistogram : uint8
+{
+	DamagePerHit,
+	WaveDurationSeconds,
+	Num
+};
+
+/**
+ * Gameplay counters and histograms that can be updated from any thread without locks.
+ * Each thread writes its own block; readers sum the blocks of every thread.
+ */
+namespace GameplayMetrics
+{
+	UE5TOPDOWNARPG_API void Increment(EGameplayCounter Counter, int64 Amount = 1);
+	UE5TOPDOWNARPG_API void Observe(EGameplayHistogram Histogram, double Value);
+
+	/** Sums every thread's block and formats it in the Prometheus text exposition format. */
+	UE5TOPDOWNARPG_API void WritePrometheusText(FString& OutText, const FString& Instance);
+
+	/** Nearest-rank percentile of samples kept for a report, Percentile in [0, 1]. Zero without samples. */
+	UE5TOPDOWNARPG_API float GetPercentile(TArray<float> Samples, float Percentile);
+}
@@ -0,0 +1,108 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MetricsExportSubsystem.h"
+#include "GameplayMetrics.h"
+#include "HAL/Event.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "../UE5TopDownARPG.h"
+
+namespace
+{
+	float MetricsFlushSeconds = 10.0f;
+	FAutoConsoleVariableRef CVarMetricsFlushSeconds(
+		TEXT("ARPG.Metrics.FlushSeconds"),
+		MetricsFlushSeconds,
+		TEXT("Time between metrics files. 0 pauses the export."));
+
+	int32 MetricsMaxFiles = 10;
+	FAutoConsoleVariableRef CVarMetricsMaxFiles(
+		TEXT("ARPG.Metrics.MaxFiles"),
+		MetricsMaxFiles,
+		TEXT("Number of metrics files kept per process before the oldest is overwritten."));
+}
+
+class FMetricsExportRunnable : public FRunnable
+{
+public:
+	FMetricsExportRunnable()
+		: WakeEvent(FPlatformProcess::GetSynchEventFromPool())
+	{
+		Instance = FString::Printf(TEXT("%s-%u"), FPlatformProcess::ComputerName(), FPlatformProcess::GetCurrentProcessId());
+	}
+
+	virtual ~FMetricsExportRunnable() override
+	{
+		FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+	}
+
+	virtual uint32 Run() override
+	{
+		while (bStopping == false)
+		{
+			WakeEvent->Wait(FTimespan::FromSeconds(FMath::Max(MetricsFlushSeconds, 1.0f)));
+			if (MetricsFlushSeconds > 0.0f || bStopping)
+			{
+				Flush();
+			}
+		}
+		return 0;
+	}
+
+	virtual void Stop() override
+	{
+		bStopping = true;
+		WakeEvent->Trigger();
+	}
+
+private:
+	void Flush()
+	{
+		Text.Reset();
+		GameplayMetrics::WritePrometheusText(Text, Instance);
+
+		const FString FilePath = FPaths::ProjectSavedDir() / TEXT("Metrics") / FString::Printf(TEXT("metrics-%s-%02d.prom"), *Instance, NextFileIndex);
+		if (FFileHelper::SaveStringToFile(Text, *FilePath, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM) == false)
+		{
+			UE_LOG(LogUE5TopDownARPG, Warning, TEXT("Failed to write metrics to %s"), *FilePath);
+		}
+		NextFileIndex = (NextFileIndex + 1) % FMath::Max(MetricsMaxFiles, 1);
+	}
+
+	FEvent* WakeEvent;
+	std::atomic<bool> bStopping { false };
+	FString Instance;
+	FString Text;
+	int32 NextFileIndex = 0;
+};
+
+void UMetricsExportSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	if (IsRunningCommandlet())
+	{
+		return;
+	}
+
+	Runnable = MakeUnique<FMetricsExportRunnable>();
+	Thread.Reset(FRunnableThread::Create(Runnable.Get(), TEXT("ARPGMetricsExport"), 0, TPri_BelowNormal));
+}
+
+void UMetricsExportSubsystem::Deinitialize()
+{
+	if (Thread.IsValid())
+	{
+		// Stop wakes the thread, which writes a final file before exiting.
+		Runnable->Stop();
+		Thread->WaitForCompletion();
+		Thread.Reset();
+	}
+	Runnable.Reset();
+
+	Super::Deinitialize();
+}
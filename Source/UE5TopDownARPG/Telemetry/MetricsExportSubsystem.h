@@ -0,0 +1,25 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/EngineSubsystem.h"
+#include "MetricsExportSubsystem.generated.h"
+
+/**
+ * Periodically writes the gameplay metrics to rotating Prometheus text files under Saved/Metrics
+ * from a background thread, so the game thread never waits on file I/O.
+ */
+UCLASS()
+class UE5TOPDOWNARPG_API UMetricsExportSubsystem : public UEngineSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+private:
+	TUniquePtr<class FMetricsExportRunnable> Runnable;
+	TUniquePtr<FRunnableThread> Thread;
+};
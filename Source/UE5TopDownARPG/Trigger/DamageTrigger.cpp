@@ -1,26 +1,48 @@
-// Fill out your copyright notice in the Description page of Project Settings.
-
-
-#include "DamageTrigger.h"
-#include "Engine/DamageEvents.h"
-
-void ADamageTrigger::ActionStart(AActor* ActorInRange)
-{
-  Target = ActorInRange;
-
-  GetWorld()->GetTimerManager().SetTimer(CustomDamageTickTimerHandle, this, &ADamageTrigger::DamageTick, DamageTickRate, true);
-}
-
-void ADamageTrigger::ActionEnd(AActor* ActorInRange)
-{
-  Target = nullptr;
-  GetWorld()->GetTimerManager().ClearTimer(CustomDamageTickTimerHandle);
-}
-
-void ADamageTrigger::DamageTick()
-{
-  if (IsValid(Target))
-  {
-    Target->TakeDamage(Damage, FDamageEvent(UDamageType::StaticClass()), nullptr, this);
-  }
-}
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "DamageTrigger.h"
+#include "../Characters/BaseCharacter.h"
+#include "../StatusEffects/StatusEffectSubsystem.h"
+
+void ADamageTrigger::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+  if (UStatusEffectSubsystem* StatusEffectSubsystem = UStatusEffectSubsystem::Get(this))
+  {
+    for (const TPair<TObjectKey<AActor>, int32>& ZoneEffect : ZoneEffects)
+    {
+      StatusEffectSubsystem->RemoveEffect(ZoneEffect.Value);
+    }
+  }
+  ZoneEffects.Reset();
+
+  Super::EndPlay(EndPlayReason);
+}
+
+void ADamageTrigger::ActionStart(AActor* ActorInRange)
+{
+  ABaseCharacter* Character = Cast<ABaseCharacter>(ActorInRange);
+  UStatusEffectSubsystem* StatusEffectSubsystem = UStatusEffectSubsystem::Get(this);
+  if (IsValid(Character) == false || StatusEffectSubsystem == nullptr || ZoneEffects.Contains(Character))
+  {
+    return;
+  }
+
+  const int32 EffectId = StatusEffectSubsystem->ApplyEffect(Character, Effect, Damage, 0.0f, DamageTickRate, nullptr, this);
+  if (EffectId != INDEX_NONE)
+  {
+    ZoneEffects.Add(Character, EffectId);
+  }
+}
+
+void ADamageTrigger::ActionEnd(AActor* ActorInRange)
+{
+  int32 EffectId = INDEX_NONE;
+  if (ZoneEffects.RemoveAndCopyValue(ActorInRange, EffectId))
+  {
+    if (UStatusEffectSubsystem* StatusEffectSubsystem = UStatusEffectSubsystem::Get(this))
+    {
+      StatusEffectSubsystem->RemoveEffect(EffectId);
+    }
+  }
+}
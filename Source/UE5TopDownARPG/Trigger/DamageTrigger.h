@@ -1,34 +1,35 @@
-// Fill out your copyright notice in the Description page of Project Settings.
-
-#pragma once
-
-#include "CoreMinimal.h"
-#include "BaseTrigger.h"
-#include "DamageTrigger.generated.h"
-
-/**
- * 
- */
-UCLASS()
-class UE5TOPDOWNARPG_API ADamageTrigger : public ABaseTrigger
-{
-	GENERATED_BODY()
-
-protected:
-	virtual void ActionStart(AActor* ActorInRange) override;
-	virtual void ActionEnd(AActor* ActorInRange) override;
-
-	void DamageTick();
-
-	UPROPERTY()
-	AActor* Target;
-
-	FTimerHandle CustomDamageTickTimerHandle;
-
-	UPROPERTY(EditDefaultsOnly)
-	float Damage = 10.0f;
-
-	UPROPERTY(EditDefaultsOnly)
-	float DamageTickRate = 1.0f;
-	
-};
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BaseTrigger.h"
+#include "../StatusEffects/StatusEffectBatch.h"
+#include "DamageTrigger.generated.h"
+
+/**
+ * Applies a status effect to every character inside the zone until it leaves.
+ */
+UCLASS()
+class UE5TOPDOWNARPG_API ADamageTrigger : public ABaseTrigger
+{
+	GENERATED_BODY()
+
+protected:
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void ActionStart(AActor* ActorInRange) override;
+	virtual void ActionEnd(AActor* ActorInRange) override;
+
+	UPROPERTY(EditDefaultsOnly)
+	EStatusEffect Effect = EStatusEffect::Burn;
+
+	UPROPERTY(EditDefaultsOnly)
+	float Damage = 10.0f;
+
+	UPROPERTY(EditDefaultsOnly)
+	float DamageTickRate = 1.0f;
+
+	/** Status effect id of each character in the zone. */
+	TMap<TObjectKey<AActor>, int32> ZoneEffects;
+	
+};
@@ -1,36 +1,344 @@
-// Fill out your copyright notice in the Description page of Project Settings.
-
-
-#include "SpawnTrigger.h"
-
-ASpawnTrigger::ASpawnTrigger()
-{
-	SpawnLocationComponent = CreateDefaultSubobject<USceneComponent>(TEXT("SpawnLocationComponent"));
-	SpawnLocationComponent->SetupAttachment(RootComponent);
-}
-
-void ASpawnTrigger::ActionStart(AActor* ActorInRange)
-{
-	CurrentWave = 1;
-
-	GetWorld()->GetTimerManager().SetTimer(WaveSpawnTimerHandle, this, &ASpawnTrigger::SpawnWave, TimeBetweenWaves, true, InitialDelay);
-}
-
-void ASpawnTrigger::SpawnWave()
-{
-	FActorSpawnParameters SpawnParameters;
-	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
-
-	for (int i = 0; i < NumberOfActorsToSpawn; i++)
-	{
-		GetWorld()->SpawnActor<AActor>(ActorToSpawnClass, SpawnLocationComponent->GetComponentLocation(), FRotator(), SpawnParameters);
-	}
-
-	if (CurrentWave == NumberOfWaves)
-	{
-		GetWorld()->GetTimerManager().ClearTimer(WaveSpawnTimerHandle);
-		return;
-	}
-
-	CurrentWave++;
-}
\ No newline at end of file
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SpawnTrigger.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "NavigationSystem.h"
+#include "../Characters/BaseCharacter.h"
+#include "../Loading/AssetPreloadSubsystem.h"
+#include "../Net/NetPolicyComponent.h"
+#include "../Replay/GameplayRecorderSubsystem.h"
+#include "../Scheduling/GameplayWorkScheduler.h"
+#include "../Telemetry/GameplayMetrics.h"
+#include "../UE5TopDownARPG.h"
+
+DECLARE_CYCLE_STAT(TEXT("Spawn Wave"), STAT_SpawnWave, STATGROUP_ARPG);
+DECLARE_CYCLE_STAT(TEXT("Spawn Actor"), STAT_SpawnActor, STATGROUP_ARPG);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Actors Spawned"), STAT_ActorsSpawned, STATGROUP_ARPG);
+
+namespace
+{
+	bool bUseSpawnPoints = true;
+	FAutoConsoleVariableRef CVarUseSpawnPoints(
+		TEXT("ARPG.Spawn.UseSpawnPoints"),
+		bUseSpawnPoints,
+		TEXT("Spawns waves at precomputed points instead of adjusting each spawn out of collision."));
+
+	struct FSpawnCost
+	{
+		uint64 Cycles = 0;
+		int32 NumSpawns = 0;
+	};
+
+	/** Indexed by whether the spawn used a precomputed point. */
+	FSpawnCost SpawnCosts[2];
+
+	void LogSpawnReport(const TArray<FString>& Args)
+	{
+		if (Args.Num() > 0 && Args[0] == TEXT("reset"))
+		{
+			SpawnCosts[0] = FSpawnCost();
+			SpawnCosts[1] = FSpawnCost();
+			return;
+		}
+
+		const TCHAR* ModeNames[] = { TEXT("collision adjusted"), TEXT("spawn points") };
+		for (int32 Mode = 0; Mode < UE_ARRAY_COUNT(SpawnCosts); Mode++)
+		{
+			const FSpawnCost& Cost = SpawnCosts[Mode];
+			UE_LOG(LogUE5TopDownARPG, Log, TEXT("Spawn %s: %d spawns, %.3f ms/spawn"), ModeNames[Mode], Cost.NumSpawns,
+				Cost.NumSpawns > 0 ? FPlatformTime::ToMilliseconds64(Cost.Cycles) / Cost.NumSpawns : 0.0);
+		}
+	}
+
+	FAutoConsoleCommand SpawnReportCommand(
+		TEXT("ARPG.SpawnReport"),
+		TEXT("Logs the cost per spawned wave actor with and without spawn points. Pass reset to start a new measurement."),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&LogSpawnReport));
+
+	const int32 MaxSpawnPointRings = 16;
+}
+
+ASpawnTrigger::ASpawnTrigger()
+{
+	SpawnLocationComponent = CreateDefaultSubobject<USceneComponent>(TEXT("SpawnLocationComponent"));
+	SpawnLocationComponent->SetupAttachment(RootComponent);
+}
+
+void ASpawnTrigger::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (HasAuthority() && SpawnPointOffsets.Num() == 0)
+	{
+		GenerateSpawnPoints();
+	}
+	SpawnPointStream.Initialize(GetTypeHash(GetFName()));
+}
+
+void ASpawnTrigger::BakeSpawnPoints()
+{
+	Modify();
+	GenerateSpawnPoints();
+}
+
+void ASpawnTrigger::GenerateSpawnPoints()
+{
+	SpawnPointOffsets.Reset();
+
+	UWorld* World = GetWorld();
+	UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(World);
+	if (NavSys == nullptr)
+	{
+		return;
+	}
+
+	// The spawned class may still be streaming in, its capsule is checked against the base character's when it is not loaded.
+	UClass* SpawnClass = ActorToSpawnClass.Get();
+	const ABaseCharacter* SpawnDefaults = GetDefault<ABaseCharacter>(SpawnClass != nullptr ? SpawnClass : ABaseCharacter::StaticClass());
+	const UCapsuleComponent* Capsule = SpawnDefaults->GetCapsuleComponent();
+	const float CapsuleRadius = Capsule->GetScaledCapsuleRadius();
+	const float CapsuleHalfHeight = Capsule->GetScaledCapsuleHalfHeight();
+	const float Spacing = FMath::Max(SpawnPointSpacing, 2.0f * CapsuleRadius);
+
+	const int32 NumPoints = NumSpawnPoints > 0 ? NumSpawnPoints : 2 * NumberOfActorsToSpawn;
+	const FVector Center = SpawnLocationComponent->GetComponentLocation();
+	const FVector ProjectionExtent(0.5f * Spacing, 0.5f * Spacing, 2.0f * CapsuleHalfHeight);
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(SpawnPoint), false, this);
+
+	auto TryAddPoint = [&](const FVector2D& Offset)
+	{
+		FNavLocation NavLocation;
+		if (NavSys->ProjectPointToNavigation(Center + FVector(Offset, 0.0f), NavLocation, ProjectionExtent) == false)
+		{
+			return;
+		}
+
+		const FVector CapsuleCenter = NavLocation.Location + FVector(0.0f, 0.0f, CapsuleHalfHeight + 2.0f);
+		if (World->OverlapBlockingTestByChannel(CapsuleCenter, FQuat::Identity, ECC_Pawn, FCollisionShape::MakeCapsule(CapsuleRadius, CapsuleHalfHeight), QueryParams))
+		{
+			return;
+		}
+
+		SpawnPointOffsets.Add(FVector3f(CapsuleCenter - Center));
+	};
+
+	TryAddPoint(FVector2D::ZeroVector);
+	for (int32 Ring = 1; Ring <= MaxSpawnPointRings && SpawnPointOffsets.Num() < NumPoints; Ring++)
+	{
+		if (SpawnPointLayout == ESpawnPointLayout::Rings)
+		{
+			// As many points as fit on the circumference at the spacing.
+			const float RingRadius = Ring * Spacing;
+			const int32 NumOnRing = FMath::FloorToInt(2.0f * PI * RingRadius / Spacing);
+			for (int32 Index = 0; Index < NumOnRing && SpawnPointOffsets.Num() < NumPoints; Index++)
+			{
+				const float Angle = 2.0f * PI * Index / NumOnRing;
+				TryAddPoint(FVector2D(FMath::Cos(Angle), FMath::Sin(Angle)) * RingRadius);
+			}
+		}
+		else
+		{
+			// The square of grid cells at this distance from the center.
+			for (int32 X = -Ring; X <= Ring && SpawnPointOffsets.Num() < NumPoints; X++)
+			{
+				for (int32 Y = -Ring; Y <= Ring && SpawnPointOffsets.Num() < NumPoints; Y++)
+				{
+					if (FMath::Max(FMath::Abs(X), FMath::Abs(Y)) == Ring)
+					{
+						TryAddPoint(FVector2D(X, Y) * Spacing);
+					}
+				}
+			}
+		}
+	}
+
+	if (SpawnPointOffsets.Num() < NumPoints)
+	{
+		UE_LOG(LogUE5TopDownARPG, Warning, TEXT("%s: only %d of %d spawn points are on the navmesh and free"), *GetName(), SpawnPointOffsets.Num(), NumPoints);
+	}
+}
+
+bool ASpawnTrigger::TryGetNextSpawnLocation(FVector& OutLocation)
+{
+	if (bUseSpawnPoints == false || SpawnPointOffsets.Num() == 0)
+	{
+		return false;
+	}
+
+	int32 PointIndex = NextSpawnPoint % SpawnPointOffsets.Num();
+	if (SpawnPointOrder == ESpawnPointOrder::Random)
+	{
+		if (ShuffledSpawnPoints.Num() != SpawnPointOffsets.Num() || PointIndex == 0)
+		{
+			ShuffledSpawnPoints.SetNumUninitialized(SpawnPointOffsets.Num());
+			for (int32 Index = 0; Index < ShuffledSpawnPoints.Num(); Index++)
+			{
+				ShuffledSpawnPoints[Index] = Index;
+			}
+			for (int32 Index = ShuffledSpawnPoints.Num() - 1; Index > 0; Index--)
+			{
+				ShuffledSpawnPoints.Swap(Index, SpawnPointStream.RandRange(0, Index));
+			}
+		}
+		PointIndex = ShuffledSpawnPoints[PointIndex];
+	}
+	NextSpawnPoint = (NextSpawnPoint + 1) % SpawnPointOffsets.Num();
+
+	OutLocation = SpawnLocationComponent->GetComponentLocation() + FVector(SpawnPointOffsets[PointIndex]);
+	return true;
+}
+
+void ASpawnTrigger::ActionStart(AActor* ActorInRange)
+{
+	CurrentWave = 1;
+
+	// Stream the enemy class in while the initial delay runs.
+	if (UAssetPreloadSubsystem* PreloadSubsystem = GetWorld()->GetSubsystem<UAssetPreloadSubsystem>())
+	{
+		PreloadSubsystem->RequestPreload({ ActorToSpawnClass.ToSoftObjectPath() }, TEXT("SpawnWave"));
+	}
+
+	GetWorld()->GetTimerManager().SetTimer(WaveSpawnTimerHandle, this, &ASpawnTrigger::SpawnWave, TimeBetweenWaves, true, InitialDelay);
+}
+
+float ASpawnTrigger::GetTimeToNextWave() const
+{
+	return GetWorld()->GetTimerManager().GetTimerRemaining(WaveSpawnTimerHandle);
+}
+
+void ASpawnTrigger::RestoreWaveProgress(int32 Wave, float TimeToNextWave)
+{
+	CurrentWave = Wave;
+	GetWorld()->GetTimerManager().ClearTimer(WaveSpawnTimerHandle);
+	if (TimeToNextWave >= 0.0f)
+	{
+		GetWorld()->GetTimerManager().SetTimer(WaveSpawnTimerHandle, this, &ASpawnTrigger::SpawnWave, TimeBetweenWaves, true, TimeToNextWave);
+	}
+	NetPolicyComponent->WakeForStateChange();
+}
+
+void ASpawnTrigger::StopWaves()
+{
+	GetWorld()->GetTimerManager().ClearTimer(WaveSpawnTimerHandle);
+	CurrentWave = 0;
+	NumPendingSpawns = 0;
+	SpawnGeneration++;
+	NetPolicyComponent->WakeForStateChange();
+}
+
+void ASpawnTrigger::SpawnWave()
+{
+	SCOPE_CYCLE_COUNTER(STAT_SpawnWave);
+
+	// The previous wave is still spreading its spawns over frames; this wave waits for the next timer tick.
+	if (NumPendingSpawns > 0)
+	{
+		return;
+	}
+
+	if (UGameplayRecorderSubsystem* Recorder = UGameplayRecorderSubsystem::Get(this))
+	{
+		Recorder->RecordSpawnWave(this, CurrentWave);
+	}
+
+	TSubclassOf<ABaseCharacter> SpawnClass = UAssetPreloadSubsystem::Resolve(this, ActorToSpawnClass);
+	GameplayMetrics::Increment(EGameplayCounter::WavesSpawned);
+
+	// Without a scheduler the spawns run right here and may already advance CurrentWave.
+	const int32 Wave = CurrentWave;
+	const double WaveStartTime = GetWorld()->GetTimeSeconds();
+	if (Wave == NumberOfWaves)
+	{
+		GetWorld()->GetTimerManager().ClearTimer(WaveSpawnTimerHandle);
+	}
+
+	NumPendingSpawns = NumberOfActorsToSpawn;
+	if (NumPendingSpawns <= 0)
+	{
+		NumPendingSpawns = 0;
+		OnWaveSpawned(Wave);
+	}
+
+	// Each spawn is its own work item so a large wave spreads over several frames.
+	for (int i = 0; i < NumberOfActorsToSpawn; i++)
+	{
+		UGameplayWorkScheduler::SubmitOrRun(this, EGameplayWorkPriority::High, [this, SpawnClass, Wave, WaveStartTime, Generation = SpawnGeneration]()
+		{
+			if (Generation != SpawnGeneration)
+			{
+				return;
+			}
+
+			SCOPE_CYCLE_COUNTER(STAT_SpawnActor);
+			const uint64 StartCycles = FPlatformTime::Cycles64();
+
+			// Spawn points were checked for collision up front, so only the fallback pays for the push-out search.
+			FVector SpawnLocation;
+			const bool bAtSpawnPoint = TryGetNextSpawnLocation(SpawnLocation);
+			FActorSpawnParameters SpawnParameters;
+			if (bAtSpawnPoint)
+			{
+				SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+			}
+			else
+			{
+				SpawnLocation = SpawnLocationComponent->GetComponentLocation();
+				SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+			}
+
+			ABaseCharacter* SpawnedActor = GetWorld()->SpawnActor<ABaseCharacter>(SpawnClass, SpawnLocation, FRotator(), SpawnParameters);
+			SpawnCosts[bAtSpawnPoint ? 1 : 0].Cycles += FPlatformTime::Cycles64() - StartCycles;
+			SpawnCosts[bAtSpawnPoint ? 1 : 0].NumSpawns++;
+			if (IsValid(SpawnedActor))
+			{
+				// The wave is tracked from its first actor, a wave whose spawns all failed never has to be cleared.
+				FWaveProgress* Progress = ActiveWaves.Find(Wave);
+				if (Progress == nullptr)
+				{
+					Progress = &ActiveWaves.Add(Wave);
+					Progress->StartTime = WaveStartTime;
+				}
+				Progress->NumAlive++;
+				SpawnedActorWaves.Add(SpawnedActor, Wave);
+				SpawnedActor->OnDestroyed.AddDynamic(this, &ASpawnTrigger::OnSpawnedActorDestroyed);
+			}
+			INC_DWORD_STAT(STAT_ActorsSpawned);
+
+			if (--NumPendingSpawns == 0)
+			{
+				OnWaveSpawned(Wave);
+			}
+		});
+	}
+}
+
+void ASpawnTrigger::OnWaveSpawned(int32 Wave)
+{
+	// A checkpoint restored while the wave was spawning already moved CurrentWave on.
+	if (Wave != CurrentWave || CurrentWave == NumberOfWaves)
+	{
+		return;
+	}
+
+	CurrentWave++;
+	NetPolicyComponent->WakeForStateChange();
+}
+
+void ASpawnTrigger::OnSpawnedActorDestroyed(AActor* DestroyedActor)
+{
+	int32 Wave = 0;
+	if (SpawnedActorWaves.RemoveAndCopyValue(DestroyedActor, Wave) == false)
+	{
+		return;
+	}
+
+	FWaveProgress* Progress = ActiveWaves.Find(Wave);
+	if (Progress != nullptr && --Progress->NumAlive <= 0)
+	{
+		GameplayMetrics::Observe(EGameplayHistogram::WaveDurationSeconds, GetWorld()->GetTimeSeconds() - Progress->StartTime);
+		ActiveWaves.Remove(Wave);
+	}
+}
@@ -1,45 +1,125 @@
-// Fill out your copyright notice in the Description page of Project Settings.
-
-#pragma once
-
-#include "CoreMinimal.h"
-#include "BaseTrigger.h"
-#include "SpawnTrigger.generated.h"
-
-/**
- * 
- */
-UCLASS()
-class UE5TOPDOWNARPG_API ASpawnTrigger : public ABaseTrigger
-{
-	GENERATED_BODY()
-public:
-	ASpawnTrigger();
-
-protected:
-	virtual void ActionStart(AActor* ActorInRange) override;
-
-	UPROPERTY(EditDefaultsOnly)
-	TSubclassOf<AActor> ActorToSpawnClass;
-
-	UPROPERTY(EditDefaultsOnly)
-	class USceneComponent* SpawnLocationComponent;
-
-	UPROPERTY(EditDefaultsOnly)
-	int NumberOfWaves = 1;
-
-	UPROPERTY(EditDefaultsOnly)
-	int NumberOfActorsToSpawn = 1;
-
-	UPROPERTY(EditDefaultsOnly)
-	float InitialDelay;
-
-	UPROPERTY(EditDefaultsOnly)
-	float TimeBetweenWaves = 1.0f;
-
-	FTimerHandle WaveSpawnTimerHandle;
-private:
-	void SpawnWave();
-
-	int CurrentWave;
-};
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BaseTrigger.h"
+#include "SpawnTrigger.generated.h"
+
+UENUM()
+enum class ESpawnPointLayout : uint8
+{
+	/** Concentric rings around the spawn location. */
+	Rings,
+	/** A square grid spiralling out from the spawn location. */
+	Grid
+};
+
+UENUM()
+enum class ESpawnPointOrder : uint8
+{
+	RoundRobin,
+	/** Every point once in shuffled order before any repeats. */
+	Random
+};
+
+/**
+ * 
+ */
+UCLASS()
+class UE5TOPDOWNARPG_API ASpawnTrigger : public ABaseTrigger
+{
+	GENERATED_BODY()
+public:
+	ASpawnTrigger();
+
+	int32 GetCurrentWave() const { return CurrentWave; }
+
+	/** Seconds until the next wave, negative when no waves are pending. */
+	float GetTimeToNextWave() const;
+
+	/** Resumes spawning at Wave, used when restoring a checkpoint. */
+	void RestoreWaveProgress(int32 Wave, float TimeToNextWave);
+
+	/** Cancels pending waves and spawns, used when an arena resets in place. The next overlap starts over. */
+	void StopWaves();
+
+	/** Generates the spawn points in the editor so they are saved with the level instead of built at BeginPlay. */
+	UFUNCTION(CallInEditor, Category = "Spawn Points")
+	void BakeSpawnPoints();
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void ActionStart(AActor* ActorInRange) override;
+
+	UPROPERTY(EditDefaultsOnly)
+	TSoftClassPtr<class ABaseCharacter> ActorToSpawnClass;
+
+	UPROPERTY(EditDefaultsOnly)
+	class USceneComponent* SpawnLocationComponent;
+
+	UPROPERTY(EditDefaultsOnly)
+	int NumberOfWaves = 1;
+
+	UPROPERTY(EditDefaultsOnly)
+	int NumberOfActorsToSpawn = 1;
+
+	UPROPERTY(EditDefaultsOnly)
+	float InitialDelay;
+
+	UPROPERTY(EditDefaultsOnly)
+	float TimeBetweenWaves = 1.0f;
+
+	UPROPERTY(EditAnywhere, Category = "Spawn Points")
+	ESpawnPointLayout SpawnPointLayout = ESpawnPointLayout::Rings;
+
+	UPROPERTY(EditAnywhere, Category = "Spawn Points")
+	ESpawnPointOrder SpawnPointOrder = ESpawnPointOrder::RoundRobin;
+
+	/** Distance between neighboring points, at least the spawned capsule's diameter. */
+	UPROPERTY(EditAnywhere, Category = "Spawn Points")
+	float SpawnPointSpacing = 150.0f;
+
+	/** Points to generate, 0 for two per actor in a wave so back to back waves do not land on each other. */
+	UPROPERTY(EditAnywhere, Category = "Spawn Points")
+	int32 NumSpawnPoints = 0;
+
+	/** Nav-projected, collision-free capsule centers relative to the spawn location. */
+	UPROPERTY(VisibleAnywhere, Category = "Spawn Points")
+	TArray<FVector3f> SpawnPointOffsets;
+
+	FTimerHandle WaveSpawnTimerHandle;
+private:
+	void SpawnWave();
+
+	/** Runs after the last deferred spawn of Wave, only then the trigger reports the next wave. */
+	void OnWaveSpawned(int32 Wave);
+
+	void GenerateSpawnPoints();
+	bool TryGetNextSpawnLocation(FVector& OutLocation);
+
+	int32 NextSpawnPoint = 0;
+	TArray<int32> ShuffledSpawnPoints;
+	FRandomStream SpawnPointStream;
+
+	UFUNCTION()
+	void OnSpawnedActorDestroyed(AActor* DestroyedActor);
+
+	int CurrentWave;
+
+	/** Deferred spawns of the wave being spawned that did not run yet. */
+	int32 NumPendingSpawns = 0;
+
+	/** Bumped by StopWaves so deferred spawns queued before it do nothing. */
+	int32 SpawnGeneration = 0;
+
+	struct FWaveProgress
+	{
+		double StartTime = 0.0;
+		int32 NumAlive = 0;
+	};
+
+	/** Waves with living actors, used to measure how long each wave takes to clear. */
+	TMap<int32, FWaveProgress> ActiveWaves;
+	TMap<TObjectKey<AActor>, int32> SpawnedActorWaves;
+};
@@ -1,9 +1,13 @@
-// Copyright Epic Games, Inc. All Rights Reserved.
-
-#include "UE5TopDownARPG.h"
-#include "Modules/ModuleManager.h"
-
-IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, UE5TopDownARPG, "UE5TopDownARPG" );
-
-DEFINE_LOG_CATEGORY(LogUE5TopDownARPG)
- 
\ No newline at end of file
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "UE5TopDownARPG.h"
+#include "Modules/ModuleManager.h"
+
+IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, UE5TopDownARPG, "UE5TopDownARPG" );
+
+DEFINE_LOG_CATEGORY(LogUE5TopDownARPG)
+ 
+
+const FName ARPGCollisionProfiles::Projectile(TEXT("Projectile"));
+const FName ARPGCollisionProfiles::Trigger(TEXT("Trigger"));
+const FName ARPGCollisionProfiles::Hurtbox(TEXT("Hurtbox"));
@@ -1,7 +1,21 @@
-// Copyright Epic Games, Inc. All Rights Reserved.
-
-#pragma once
-
-#include "CoreMinimal.h"
-
-DECLARE_LOG_CATEGORY_EXTERN(LogUE5TopDownARPG, Log, All);
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+
+DECLARE_LOG_CATEGORY_EXTERN(LogUE5TopDownARPG, Log, All);
+
+DECLARE_STATS_GROUP(TEXT("ARPG"), STATGROUP_ARPG, STATCAT_Advanced);
+
+/** Gameplay collision channels and profiles, see [/Script/Engine.CollisionProfile] in DefaultEngine.ini. */
+#define ECC_Projectile ECC_GameTraceChannel1
+#define ECC_Trigger ECC_GameTraceChannel2
+
+namespace ARPGCollisionProfiles
+{
+	extern UE5TOPDOWNARPG_API const FName Projectile;
+	extern UE5TOPDOWNARPG_API const FName Trigger;
+	extern UE5TOPDOWNARPG_API const FName Hurtbox;
+}
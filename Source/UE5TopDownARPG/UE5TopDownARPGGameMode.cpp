@@ -1,39 +1,80 @@
-// Copyright Epic Games, Inc. All Rights Reserved.
-
-#include "UE5TopDownARPGGameMode.h"
-#include "UE5TopDownARPGPlayerController.h"
-#include "UE5TopDownARPGCharacter.h"
-#include "UObject/ConstructorHelpers.h"
-#include "UE5TopDownARPG.h"
-
-AUE5TopDownARPGGameMode::AUE5TopDownARPGGameMode()
-{
-	// use our custom PlayerController class
-	PlayerControllerClass = AUE5TopDownARPGPlayerController::StaticClass();
-
-	// set default pawn class to our Blueprinted character
-	static ConstructorHelpers::FClassFinder<APawn> PlayerPawnBPClass(TEXT("/Game/TopDown/Blueprints/BP_TopDownCharacter"));
-	if (PlayerPawnBPClass.Class != nullptr)
-	{
-		DefaultPawnClass = PlayerPawnBPClass.Class;
-	}
-
-	// set default controller to our Blueprinted controller
-	static ConstructorHelpers::FClassFinder<APlayerController> PlayerControllerBPClass(TEXT("/Game/TopDown/Blueprints/BP_TopDownPlayerController"));
-	if(PlayerControllerBPClass.Class != NULL)
-	{
-		PlayerControllerClass = PlayerControllerBPClass.Class;
-	}
-}
-
-void AUE5TopDownARPGGameMode::EndGame(bool IsWin)
-{
-	if (IsWin)
-	{
-		UE_LOG(LogUE5TopDownARPG, Log, TEXT("Win"));
-	}
-	else
-	{
-		UE_LOG(LogUE5TopDownARPG, Log, TEXT("Lose"));
-	}
-}
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "UE5TopDownARPGGameMode.h"
+#include "UE5TopDownARPGPlayerController.h"
+#include "UE5TopDownARPGCharacter.h"
+#include "Arena/ArenaSubsystem.h"
+#include "EngineUtils.h"
+#include "GameFramework/PlayerStart.h"
+#include "Messages/GameplayMessageSubsystem.h"
+#include "Startup/StartupProfiler.h"
+#include "UObject/ConstructorHelpers.h"
+#include "UE5TopDownARPG.h"
+
+AUE5TopDownARPGGameMode::AUE5TopDownARPGGameMode()
+{
+	// The class finders below only run for the class default object, which is built during engine init.
+	FScopedStartupPhase StartupPhase(EStartupPhase::GameModeClassLookup, HasAnyFlags(RF_ClassDefaultObject));
+
+	// use our custom PlayerController class
+	PlayerControllerClass = AUE5TopDownARPGPlayerController::StaticClass();
+
+	// set default pawn class to our Blueprinted character
+	static ConstructorHelpers::FClassFinder<APawn> PlayerPawnBPClass(TEXT("/Game/TopDown/Blueprints/BP_TopDownCharacter"));
+	if (PlayerPawnBPClass.Class != nullptr)
+	{
+		DefaultPawnClass = PlayerPawnBPClass.Class;
+	}
+
+	// set default controller to our Blueprinted controller
+	static ConstructorHelpers::FClassFinder<APlayerController> PlayerControllerBPClass(TEXT("/Game/TopDown/Blueprints/BP_TopDownPlayerController"));
+	if(PlayerControllerBPClass.Class != NULL)
+	{
+		PlayerControllerClass = PlayerControllerBPClass.Class;
+	}
+}
+
+AActor* AUE5TopDownARPGGameMode::ChoosePlayerStart_Implementation(AController* Player)
+{
+	UArenaSubsystem* ArenaSubsystem = UArenaSubsystem::Get(this);
+	if (ArenaSubsystem == nullptr || ArenaSubsystem->GetNumArenas() <= 1)
+	{
+		return Super::ChoosePlayerStart_Implementation(Player);
+	}
+
+	// Each arena instance brings its own player starts.
+	const int32 ArenaId = ArenaSubsystem->AssignPlayer(Player);
+	for (TActorIterator<APlayerStart> It(GetWorld()); It; ++It)
+	{
+		if (ArenaSubsystem->GetArenaId(It->GetActorLocation()) == ArenaId)
+		{
+			return *It;
+		}
+	}
+	return Super::ChoosePlayerStart_Implementation(Player);
+}
+
+void AUE5TopDownARPGGameMode::Logout(AController* Exiting)
+{
+	if (UArenaSubsystem* ArenaSubsystem = UArenaSubsystem::Get(this))
+	{
+		ArenaSubsystem->RemovePlayer(Exiting);
+	}
+
+	Super::Logout(Exiting);
+}
+
+void AUE5TopDownARPGGameMode::EndGame(bool IsWin, const AActor* Source)
+{
+	int32 ArenaId = 0;
+	if (UArenaSubsystem* ArenaSubsystem = UArenaSubsystem::Get(this))
+	{
+		ArenaId = FMath::Max(ArenaSubsystem->GetArenaId(Source), 0);
+		ArenaSubsystem->EndArena(ArenaId, IsWin);
+	}
+
+	if (UGameplayMessageSubsystem* MessageSubsystem = UGameplayMessageSubsystem::Get(this))
+	{
+		MessageSubsystem->PostGameEnded(IsWin, ArenaId);
+	}
+}
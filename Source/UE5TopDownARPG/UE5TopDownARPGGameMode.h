@@ -1,21 +1,25 @@
-// Copyright Epic Games, Inc. All Rights Reserved.
-
-#pragma once
-
-#include "CoreMinimal.h"
-#include "GameFramework/GameModeBase.h"
-#include "UE5TopDownARPGGameMode.generated.h"
-
-UCLASS(minimalapi)
-class AUE5TopDownARPGGameMode : public AGameModeBase
-{
-	GENERATED_BODY()
-
-public:
-	AUE5TopDownARPGGameMode();
-
-	void EndGame(bool IsWin);
-};
-
-
-
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/GameModeBase.h"
+#include "UE5TopDownARPGGameMode.generated.h"
+
+UCLASS(minimalapi)
+class AUE5TopDownARPGGameMode : public AGameModeBase
+{
+	GENERATED_BODY()
+
+public:
+	AUE5TopDownARPGGameMode();
+
+	virtual AActor* ChoosePlayerStart_Implementation(AController* Player) override;
+	virtual void Logout(AController* Exiting) override;
+
+	/** Ends the match of the arena Source is in. */
+	void EndGame(bool IsWin, const AActor* Source = nullptr);
+};
+
+
+
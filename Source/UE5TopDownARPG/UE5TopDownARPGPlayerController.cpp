@@ -1,146 +1,343 @@
-// Copyright Epic Games, Inc. All Rights Reserved.
-
-#include "UE5TopDownARPGPlayerController.h"
-#include "GameFramework/Pawn.h"
-#include "Blueprint/AIBlueprintHelperLibrary.h"
-#include "NiagaraSystem.h"
-#include "NiagaraFunctionLibrary.h"
-#include "UE5TopDownARPGCharacter.h"
-#include "Engine/World.h"
-#include "EnhancedInputComponent.h"
-#include "EnhancedInputSubsystems.h"
-#include "UE5TopDownARPG.h"
-
-AUE5TopDownARPGPlayerController::AUE5TopDownARPGPlayerController()
-{
-	bShowMouseCursor = true;
-	DefaultMouseCursor = EMouseCursor::Default;
-	CachedDestination = FVector::ZeroVector;
-	FollowTime = 0.f;
-}
-
-void AUE5TopDownARPGPlayerController::BeginPlay()
-{
-	// Call the base class  
-	Super::BeginPlay();
-
-	//Add Input Mapping Context
-	if (UEnhancedInputLocalPlayerSubsystem* Subsystem = ULocalPlayer::GetSubsystem<UEnhancedInputLocalPlayerSubsystem>(GetLocalPlayer()))
-	{
-		Subsystem->AddMappingContext(DefaultMappingContext, 0);
-	}
-}
-
-void AUE5TopDownARPGPlayerController::SetupInputComponent()
-{
-	// set up gameplay key bindings
-	Super::SetupInputComponent();
-
-	// Set up action bindings
-	if (UEnhancedInputComponent* EnhancedInputComponent = CastChecked<UEnhancedInputComponent>(InputComponent))
-	{
-		// Setup mouse input events
-		EnhancedInputComponent->BindAction(SetDestinationClickAction, ETriggerEvent::Started, this, &AUE5TopDownARPGPlayerController::OnInputStarted);
-		EnhancedInputComponent->BindAction(SetDestinationClickAction, ETriggerEvent::Triggered, this, &AUE5TopDownARPGPlayerController::OnSetDestinationTriggered);
-		EnhancedInputComponent->BindAction(SetDestinationClickAction, ETriggerEvent::Completed, this, &AUE5TopDownARPGPlayerController::OnSetDestinationReleased);
-		EnhancedInputComponent->BindAction(SetDestinationClickAction, ETriggerEvent::Canceled, this, &AUE5TopDownARPGPlayerController::OnSetDestinationReleased);
-
-		EnhancedInputComponent->BindAction(ActivateAbilityAction, ETriggerEvent::Started, this, &AUE5TopDownARPGPlayerController::OnActivateAbilityStarted);
-
-		// Setup touch input events
-		EnhancedInputComponent->BindAction(SetDestinationTouchAction, ETriggerEvent::Started, this, &AUE5TopDownARPGPlayerController::OnInputStarted);
-		EnhancedInputComponent->BindAction(SetDestinationTouchAction, ETriggerEvent::Triggered, this, &AUE5TopDownARPGPlayerController::OnTouchTriggered);
-		EnhancedInputComponent->BindAction(SetDestinationTouchAction, ETriggerEvent::Completed, this, &AUE5TopDownARPGPlayerController::OnTouchReleased);
-		EnhancedInputComponent->BindAction(SetDestinationTouchAction, ETriggerEvent::Canceled, this, &AUE5TopDownARPGPlayerController::OnTouchReleased);
-	}
-}
-
-void AUE5TopDownARPGPlayerController::OnInputStarted()
-{
-	StopMovement();
-}
-
-// Triggered every frame when the input is held down
-void AUE5TopDownARPGPlayerController::OnSetDestinationTriggered()
-{
-	// We flag that the input is being pressed
-	FollowTime += GetWorld()->GetDeltaSeconds();
-	
-	// We look for the location in the world where the player has pressed the input
-	FHitResult Hit;
-	bool bHitSuccessful = false;
-	if (bIsTouch)
-	{
-		bHitSuccessful = GetHitResultUnderFinger(ETouchIndex::Touch1, ECollisionChannel::ECC_Visibility, true, Hit);
-	}
-	else
-	{
-		bHitSuccessful = GetHitResultUnderCursor(ECollisionChannel::ECC_Visibility, true, Hit);
-	}
-
-	// If we hit a surface, cache the location
-	if (bHitSuccessful)
-	{
-		CachedDestination = Hit.Location;
-	}
-	
-	// Move towards mouse pointer or touch
-	APawn* ControlledPawn = GetPawn();
-	if (ControlledPawn != nullptr)
-	{
-		FVector WorldDirection = (CachedDestination - ControlledPawn->GetActorLocation()).GetSafeNormal();
-		ControlledPawn->AddMovementInput(WorldDirection, 1.0, false);
-	}
-}
-
-void AUE5TopDownARPGPlayerController::OnSetDestinationReleased()
-{
-	// If it was a short press
-	if (FollowTime <= ShortPressThreshold)
-	{
-		// We move there and spawn some particles
-		UAIBlueprintHelperLibrary::SimpleMoveToLocation(this, CachedDestination);
-		UNiagaraFunctionLibrary::SpawnSystemAtLocation(this, FXCursor, CachedDestination, FRotator::ZeroRotator, FVector(1.f, 1.f, 1.f), true, true, ENCPoolMethod::None, true);
-	}
-
-	FollowTime = 0.f;
-}
-
-// Triggered every frame when the input is held down
-void AUE5TopDownARPGPlayerController::OnTouchTriggered()
-{
-	bIsTouch = true;
-	OnSetDestinationTriggered();
-}
-
-void AUE5TopDownARPGPlayerController::OnTouchReleased()
-{
-	bIsTouch = false;
-	OnSetDestinationReleased();
-}
-
-void AUE5TopDownARPGPlayerController::OnActivateAbilityStarted()
-{
-	UE_LOG(LogUE5TopDownARPG, Log, TEXT("OnActivateAbilityStarted"));
-
-	AUE5TopDownARPGCharacter* ARPGCharacter = Cast<AUE5TopDownARPGCharacter>(GetPawn());
-	if (IsValid(ARPGCharacter))
-	{
-		FHitResult Hit;
-		bool bHitSuccessful = false;
-		if (bIsTouch)
-		{
-			bHitSuccessful = GetHitResultUnderFinger(ETouchIndex::Touch1, ECollisionChannel::ECC_Visibility, true, Hit);
-		}
-		else
-		{
-			bHitSuccessful = GetHitResultUnderCursor(ECollisionChannel::ECC_Visibility, true, Hit);
-		}
-
-		// If we hit a surface, cache the location
-		if (bHitSuccessful)
-		{
-			ARPGCharacter->ActivateAbility(Hit.Location);
-		}
-	}
-}
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "UE5TopDownARPGPlayerController.h"
+#include "GameFramework/Pawn.h"
+#include "HAL/IConsoleManager.h"
+#include "Navigation/PathFollowingComponent.h"
+#include "NavigationSystem.h"
+#include "NiagaraSystem.h"
+#include "NiagaraFunctionLibrary.h"
+#include "UE5TopDownARPGCharacter.h"
+#include "Engine/World.h"
+#include "EnhancedInputComponent.h"
+#include "EnhancedInputSubsystems.h"
+#include "Arena/ArenaSubsystem.h"
+#include "Replay/GameplayRecorderSubsystem.h"
+#include "Telemetry/GameplayMetrics.h"
+#include "UE5TopDownARPG.h"
+
+namespace
+{
+	void LogClickMoveReport(UWorld* World)
+	{
+		for (FConstPlayerControllerIterator It = World->GetPlayerControllerIterator(); It; ++It)
+		{
+			const AUE5TopDownARPGPlayerController* PlayerController = Cast<AUE5TopDownARPGPlayerController>(It->Get());
+			if (PlayerController != nullptr && PlayerController->IsLocalController())
+			{
+				PlayerController->LogClickMoveReport();
+			}
+		}
+	}
+
+	FAutoConsoleCommandWithWorld ClickMoveReportCommand(
+		TEXT("ARPG.ClickMoveReport"),
+		TEXT("Logs how click-to-move paths were planned, the full path queries avoided and click to movement latency."),
+		FConsoleCommandWithWorldDelegate::CreateStatic(&LogClickMoveReport));
+}
+
+AUE5TopDownARPGPlayerController::AUE5TopDownARPGPlayerController()
+{
+	bShowMouseCursor = true;
+	DefaultMouseCursor = EMouseCursor::Default;
+	CachedDestination = FVector::ZeroVector;
+	FollowTime = 0.f;
+}
+
+void AUE5TopDownARPGPlayerController::BeginPlay()
+{
+	// Call the base class  
+	Super::BeginPlay();
+
+	//Add Input Mapping Context
+	if (UEnhancedInputLocalPlayerSubsystem* Subsystem = ULocalPlayer::GetSubsystem<UEnhancedInputLocalPlayerSubsystem>(GetLocalPlayer()))
+	{
+		Subsystem->AddMappingContext(DefaultMappingContext, 0);
+	}
+}
+
+void AUE5TopDownARPGPlayerController::SetupInputComponent()
+{
+	// set up gameplay key bindings
+	Super::SetupInputComponent();
+
+	// Set up action bindings
+	if (UEnhancedInputComponent* EnhancedInputComponent = CastChecked<UEnhancedInputComponent>(InputComponent))
+	{
+		// Setup mouse input events
+		EnhancedInputComponent->BindAction(SetDestinationClickAction, ETriggerEvent::Started, this, &AUE5TopDownARPGPlayerController::OnInputStarted);
+		EnhancedInputComponent->BindAction(SetDestinationClickAction, ETriggerEvent::Triggered, this, &AUE5TopDownARPGPlayerController::OnSetDestinationTriggered);
+		EnhancedInputComponent->BindAction(SetDestinationClickAction, ETriggerEvent::Completed, this, &AUE5TopDownARPGPlayerController::OnSetDestinationReleased);
+		EnhancedInputComponent->BindAction(SetDestinationClickAction, ETriggerEvent::Canceled, this, &AUE5TopDownARPGPlayerController::OnSetDestinationReleased);
+
+		EnhancedInputComponent->BindAction(ActivateAbilityAction, ETriggerEvent::Started, this, &AUE5TopDownARPGPlayerController::OnActivateAbilityStarted);
+
+		// Setup touch input events
+		EnhancedInputComponent->BindAction(SetDestinationTouchAction, ETriggerEvent::Started, this, &AUE5TopDownARPGPlayerController::OnInputStarted);
+		EnhancedInputComponent->BindAction(SetDestinationTouchAction, ETriggerEvent::Triggered, this, &AUE5TopDownARPGPlayerController::OnTouchTriggered);
+		EnhancedInputComponent->BindAction(SetDestinationTouchAction, ETriggerEvent::Completed, this, &AUE5TopDownARPGPlayerController::OnTouchReleased);
+		EnhancedInputComponent->BindAction(SetDestinationTouchAction, ETriggerEvent::Canceled, this, &AUE5TopDownARPGPlayerController::OnTouchReleased);
+	}
+}
+
+void AUE5TopDownARPGPlayerController::OnInputStarted()
+{
+	if (UGameplayRecorderSubsystem* Recorder = UGameplayRecorderSubsystem::Get(this))
+	{
+		Recorder->RecordInput(EGameplayRecordEvent::InputStarted);
+	}
+
+	StopMovement();
+	PendingMoveRequestTime = 0.0;
+}
+
+// Triggered every frame when the input is held down
+void AUE5TopDownARPGPlayerController::OnSetDestinationTriggered()
+{
+	// We look for the location in the world where the player has pressed the input
+	FHitResult Hit;
+	bool bHitSuccessful = false;
+	if (bIsTouch)
+	{
+		bHitSuccessful = GetHitResultUnderFinger(ETouchIndex::Touch1, ECollisionChannel::ECC_Visibility, true, Hit);
+	}
+	else
+	{
+		bHitSuccessful = GetHitResultUnderCursor(ECollisionChannel::ECC_Visibility, true, Hit);
+	}
+
+	const float DeltaSeconds = GetWorld()->GetDeltaSeconds();
+	if (UGameplayRecorderSubsystem* Recorder = UGameplayRecorderSubsystem::Get(this))
+	{
+		Recorder->RecordInput(EGameplayRecordEvent::DestinationTriggered, bHitSuccessful, Hit.Location, DeltaSeconds);
+	}
+
+	SetDestination(bHitSuccessful, Hit.Location, DeltaSeconds);
+}
+
+void AUE5TopDownARPGPlayerController::SetDestination(bool bHitSuccessful, const FVector& HitLocation, float DeltaSeconds)
+{
+	// We flag that the input is being pressed
+	FollowTime += DeltaSeconds;
+
+	// If we hit a surface, cache the location
+	if (bHitSuccessful)
+	{
+		CachedDestination = HitLocation;
+	}
+	
+	// Move towards mouse pointer or touch
+	APawn* ControlledPawn = GetPawn();
+	if (ControlledPawn != nullptr)
+	{
+		FVector WorldDirection = (CachedDestination - ControlledPawn->GetActorLocation()).GetSafeNormal();
+		ControlledPawn->AddMovementInput(WorldDirection, 1.0, false);
+	}
+}
+
+void AUE5TopDownARPGPlayerController::OnSetDestinationReleased()
+{
+	if (UGameplayRecorderSubsystem* Recorder = UGameplayRecorderSubsystem::Get(this))
+	{
+		Recorder->RecordInput(EGameplayRecordEvent::DestinationReleased);
+	}
+
+	// If it was a short press
+	if (FollowTime <= ShortPressThreshold)
+	{
+		// We move there and spawn some particles
+		MoveToDestination(CachedDestination);
+		UNiagaraFunctionLibrary::SpawnSystemAtLocation(this, FXCursor, CachedDestination, FRotator::ZeroRotator, FVector(1.f, 1.f, 1.f), true, true, ENCPoolMethod::None, true);
+	}
+
+	FollowTime = 0.f;
+}
+
+void AUE5TopDownARPGPlayerController::MoveToDestination(const FVector& Destination)
+{
+	const double ClickTime = FPlatformTime::Seconds();
+	UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	if (GetPawn() == nullptr || NavSys == nullptr)
+	{
+		return;
+	}
+
+	// Same path following setup as UAIBlueprintHelperLibrary::SimpleMoveToLocation.
+	UPathFollowingComponent* PathFollowingComponent = FindComponentByClass<UPathFollowingComponent>();
+	if (PathFollowingComponent == nullptr)
+	{
+		PathFollowingComponent = NewObject<UPathFollowingComponent>(this);
+		PathFollowingComponent->RegisterComponentWithWorld(GetWorld());
+		PathFollowingComponent->Initialize();
+	}
+
+	if (PathFollowingComponent->IsPathFollowingAllowed() == false)
+	{
+		return;
+	}
+
+	const bool bAlreadyAtGoal = PathFollowingComponent->HasReached(Destination, EPathFollowingReachMode::OverlapAgent);
+	if (PathFollowingComponent->GetStatus() != EPathFollowingStatus::Idle)
+	{
+		PathFollowingComponent->AbortMove(*NavSys, FPathFollowingResultFlags::ForcedScript | FPathFollowingResultFlags::NewRequest,
+			FAIRequestID::AnyRequest, bAlreadyAtGoal ? EPathFollowingVelocityMode::Reset : EPathFollowingVelocityMode::Keep);
+	}
+
+	if (bAlreadyAtGoal)
+	{
+		PathFollowingComponent->RequestMoveWithImmediateFinish(EPathFollowingResult::Success);
+		return;
+	}
+
+	const FVector AgentNavLocation = GetNavAgentLocation();
+	const ANavigationData* NavData = NavSys->GetNavDataForProps(GetNavAgentPropertiesRef(), AgentNavLocation);
+	if (NavData == nullptr)
+	{
+		return;
+	}
+
+	FNavPathSharedPtr Path;
+	PathCorridorCache.FindPath(*NavSys, *NavData, this, AgentNavLocation, Destination, Path);
+	if (Path.IsValid())
+	{
+		PathFollowingComponent->RequestMove(FAIMoveRequest(Destination), Path);
+
+		// A pawn already heading along the new path has nothing to start, so the click gives no sample.
+		const TArray<FNavPathPoint>& PathPoints = Path->GetPathPoints();
+		PendingMoveDirection = PathPoints.Num() > 1 ? (PathPoints[1].Location - PathPoints[0].Location).GetSafeNormal2D() : FVector::ZeroVector;
+		const bool bAlreadyMoving = (GetPawn()->GetVelocity() | PendingMoveDirection) > 10.0f;
+		PendingMoveRequestTime = PendingMoveDirection.IsZero() || bAlreadyMoving ? 0.0 : ClickTime;
+	}
+	else if (PathFollowingComponent->GetStatus() != EPathFollowingStatus::Idle)
+	{
+		PathFollowingComponent->RequestMoveWithImmediateFinish(EPathFollowingResult::Invalid);
+	}
+}
+
+void AUE5TopDownARPGPlayerController::PlayerTick(float DeltaTime)
+{
+	Super::PlayerTick(DeltaTime);
+
+	// Movement has started once the pawn picks up speed along the clicked path, not just any speed it had before the click.
+	APawn* ControlledPawn = GetPawn();
+	if (PendingMoveRequestTime > 0.0 && ControlledPawn != nullptr && (ControlledPawn->GetVelocity() | PendingMoveDirection) > 10.0f)
+	{
+		const float LatencyMs = float((FPlatformTime::Seconds() - PendingMoveRequestTime) * 1000.0);
+		if (ClickToMoveLatencyMs.Num() < LatencyHistorySize)
+		{
+			ClickToMoveLatencyMs.Add(LatencyMs);
+		}
+		else
+		{
+			ClickToMoveLatencyMs[LatencyHistoryIndex] = LatencyMs;
+		}
+		LatencyHistoryIndex = (LatencyHistoryIndex + 1) % LatencyHistorySize;
+		PendingMoveRequestTime = 0.0;
+	}
+}
+
+void AUE5TopDownARPGPlayerController::LogClickMoveReport() const
+{
+	int32 NumPlanned = 0;
+	for (int32 Index = 0; Index < (int32)FPathCorridorCache::EPlanResult::Num; Index++)
+	{
+		const FPathCorridorCache::EPlanResult Result = (FPathCorridorCache::EPlanResult)Index;
+		NumPlanned += PathCorridorCache.GetNumResults(Result);
+		UE_LOG(LogUE5TopDownARPG, Log, TEXT("Click move %s: %d"), FPathCorridorCache::GetResultName(Result), PathCorridorCache.GetNumResults(Result));
+	}
+
+	const int32 NumAvoided = PathCorridorCache.GetNumResults(FPathCorridorCache::EPlanResult::CorridorReuse)
+		+ PathCorridorCache.GetNumResults(FPathCorridorCache::EPlanResult::CacheHit);
+	UE_LOG(LogUE5TopDownARPG, Log, TEXT("Click move: %d of %d clicks avoided a path query, click to movement p50 %.2f ms, p95 %.2f ms, max %.2f ms"),
+		NumAvoided, NumPlanned,
+		GameplayMetrics::GetPercentile(ClickToMoveLatencyMs, 0.5f),
+		GameplayMetrics::GetPercentile(ClickToMoveLatencyMs, 0.95f),
+		GameplayMetrics::GetPercentile(ClickToMoveLatencyMs, 1.0f));
+}
+
+void AUE5TopDownARPGPlayerController::ClientLoadArena_Implementation(const FString& MapName, const FString& InstanceName, FVector Origin)
+{
+	if (UArenaSubsystem* ArenaSubsystem = UArenaSubsystem::Get(this))
+	{
+		ArenaSubsystem->LoadClientArena(MapName, InstanceName, Origin);
+	}
+}
+
+// Triggered every frame when the input is held down
+void AUE5TopDownARPGPlayerController::OnTouchTriggered()
+{
+	bIsTouch = true;
+	OnSetDestinationTriggered();
+}
+
+void AUE5TopDownARPGPlayerController::OnTouchReleased()
+{
+	bIsTouch = false;
+	OnSetDestinationReleased();
+}
+
+void AUE5TopDownARPGPlayerController::OnActivateAbilityStarted()
+{
+	UE_LOG(LogUE5TopDownARPG, Log, TEXT("OnActivateAbilityStarted"));
+
+	AUE5TopDownARPGCharacter* ARPGCharacter = Cast<AUE5TopDownARPGCharacter>(GetPawn());
+	if (IsValid(ARPGCharacter))
+	{
+		FHitResult Hit;
+		bool bHitSuccessful = false;
+		if (bIsTouch)
+		{
+			bHitSuccessful = GetHitResultUnderFinger(ETouchIndex::Touch1, ECollisionChannel::ECC_Visibility, true, Hit);
+		}
+		else
+		{
+			bHitSuccessful = GetHitResultUnderCursor(ECollisionChannel::ECC_Visibility, true, Hit);
+		}
+
+		// If we hit a surface, cache the location
+		if (bHitSuccessful)
+		{
+			if (UGameplayRecorderSubsystem* Recorder = UGameplayRecorderSubsystem::Get(this))
+			{
+				Recorder->RecordInput(EGameplayRecordEvent::ActivateAbilityInput, true, Hit.Location);
+			}
+
+			ActivateAbilityAt(Hit.Location);
+		}
+	}
+}
+
+void AUE5TopDownARPGPlayerController::ActivateAbilityAt(const FVector& Location)
+{
+	AUE5TopDownARPGCharacter* ARPGCharacter = Cast<AUE5TopDownARPGCharacter>(GetPawn());
+	if (IsValid(ARPGCharacter))
+	{
+		ARPGCharacter->ActivateAbility(Location);
+	}
+}
+
+void AUE5TopDownARPGPlayerController::ReplayInput(EGameplayRecordEvent Event, bool bHit, const FVector& Location, float DeltaSeconds)
+{
+	switch (Event)
+	{
+	case EGameplayRecordEvent::InputStarted:
+		OnInputStarted();
+		break;
+
+	case EGameplayRecordEvent::DestinationTriggered:
+		// The recorded frame time, a replay frame may dispatch several recorded frames at once.
+		SetDestination(bHit, Location, DeltaSeconds);
+		break;
+
+	case EGameplayRecordEvent::DestinationReleased:
+		OnSetDestinationReleased();
+		break;
+
+	case EGameplayRecordEvent::ActivateAbilityInput:
+		ActivateAbilityAt(Location);
+		break;
+
+	default:
+		break;
+	}
+}
@@ -1,69 +1,101 @@
-// Copyright Epic Games, Inc. All Rights Reserved.
-
-#pragma once
-
-#include "CoreMinimal.h"
-#include "Templates/SubclassOf.h"
-#include "GameFramework/PlayerController.h"
-#include "InputActionValue.h"
-#include "UE5TopDownARPGPlayerController.generated.h"
-
-/** Forward declaration to improve compiling times */
-class UNiagaraSystem;
-
-UCLASS()
-class AUE5TopDownARPGPlayerController : public APlayerController
-{
-	GENERATED_BODY()
-
-public:
-	AUE5TopDownARPGPlayerController();
-
-	/** Time Threshold to know if it was a short press */
-	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Input)
-	float ShortPressThreshold;
-
-	/** FX Class that we will spawn when clicking */
-	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Input)
-	UNiagaraSystem* FXCursor;
-
-	/** MappingContext */
-	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Input, meta=(AllowPrivateAccess = "true"))
-	class UInputMappingContext* DefaultMappingContext;
-	
-	/** Jump Input Action */
-	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Input, meta=(AllowPrivateAccess = "true"))
-	class UInputAction* SetDestinationClickAction;
-
-	/** Jump Input Action */
-	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Input, meta=(AllowPrivateAccess = "true"))
-	class UInputAction* SetDestinationTouchAction;
-
-	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Input, meta=(AllowPrivateAccess = "true"))
-	class UInputAction* ActivateAbilityAction;
-
-protected:
-	/** True if the controlled character should navigate to the mouse cursor. */
-	uint32 bMoveToMouseCursor : 1;
-
-	virtual void SetupInputComponent() override;
-	
-	// To add mapping context
-	virtual void BeginPlay();
-
-	/** Input handlers for SetDestination action. */
-	void OnInputStarted();
-	void OnSetDestinationTriggered();
-	void OnSetDestinationReleased();
-	void OnTouchTriggered();
-	void OnTouchReleased();
-	void OnActivateAbilityStarted();
-
-private:
-	FVector CachedDestination;
-
-	bool bIsTouch; // Is it a touch device
-	float FollowTime; // For how long it has been pressed
-};
-
-
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Templates/SubclassOf.h"
+#include "GameFramework/PlayerController.h"
+#include "InputActionValue.h"
+#include "Navigation/PathCorridorCache.h"
+#include "UE5TopDownARPGPlayerController.generated.h"
+
+/** Forward declaration to improve compiling times */
+class UNiagaraSystem;
+enum class EGameplayRecordEvent : uint8;
+
+UCLASS()
+class AUE5TopDownARPGPlayerController : public APlayerController
+{
+	GENERATED_BODY()
+
+public:
+	AUE5TopDownARPGPlayerController();
+
+	/** Time Threshold to know if it was a short press */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Input)
+	float ShortPressThreshold;
+
+	/** FX Class that we will spawn when clicking */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Input)
+	UNiagaraSystem* FXCursor;
+
+	/** MappingContext */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Input, meta=(AllowPrivateAccess = "true"))
+	class UInputMappingContext* DefaultMappingContext;
+	
+	/** Jump Input Action */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Input, meta=(AllowPrivateAccess = "true"))
+	class UInputAction* SetDestinationClickAction;
+
+	/** Jump Input Action */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Input, meta=(AllowPrivateAccess = "true"))
+	class UInputAction* SetDestinationTouchAction;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Input, meta=(AllowPrivateAccess = "true"))
+	class UInputAction* ActivateAbilityAction;
+
+	/** Feeds a recorded input event back in, see UGameplayRecorderSubsystem. DeltaSeconds is the recorded frame time. */
+	void ReplayInput(EGameplayRecordEvent Event, bool bHit, const FVector& Location, float DeltaSeconds);
+
+	virtual void PlayerTick(float DeltaTime) override;
+
+	/** Logs how click-to-move paths were planned and the latency from click to movement start. */
+	void LogClickMoveReport() const;
+
+	/** Loads the arena instance the server assigned, an empty MapName for the arena in the persistent level. */
+	UFUNCTION(Client, Reliable)
+	void ClientLoadArena(const FString& MapName, const FString& InstanceName, FVector Origin);
+
+protected:
+	/** True if the controlled character should navigate to the mouse cursor. */
+	uint32 bMoveToMouseCursor : 1;
+
+	virtual void SetupInputComponent() override;
+	
+	// To add mapping context
+	virtual void BeginPlay();
+
+	/** Input handlers for SetDestination action. */
+	void OnInputStarted();
+	void OnSetDestinationTriggered();
+	void OnSetDestinationReleased();
+	void OnTouchTriggered();
+	void OnTouchReleased();
+	void OnActivateAbilityStarted();
+
+private:
+	/** DeltaSeconds is how long the input was held this frame. */
+	void SetDestination(bool bHitSuccessful, const FVector& HitLocation, float DeltaSeconds);
+	void ActivateAbilityAt(const FVector& Location);
+
+	/** Replaces SimpleMoveToLocation, planning through PathCorridorCache instead of a full query per click. */
+	void MoveToDestination(const FVector& Destination);
+
+	FVector CachedDestination;
+
+	FPathCorridorCache PathCorridorCache;
+
+	/** Time of the click whose move has not started yet, zero when none is pending. */
+	double PendingMoveRequestTime = 0.0;
+	/** Direction of the first segment of that click's path. */
+	FVector PendingMoveDirection = FVector::ZeroVector;
+
+	static constexpr int32 LatencyHistorySize = 256;
+	TArray<float> ClickToMoveLatencyMs;
+	int32 LatencyHistoryIndex = 0;
+
+	bool bIsTouch; // Is it a touch device
+	float FollowTime; // For how long it has been pressed
+};
+
+